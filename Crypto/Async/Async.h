@@ -0,0 +1,241 @@
+#ifndef BEESOFT_CRYPTO_ASYNC_H
+#define BEESOFT_CRYPTO_ASYNC_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <memory>
+#include "Crypto/Crypto.h"
+#include "Crypto/Async/AsyncTypes.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Async
+ * Asynchroniczne szyfrowanie i deszyfrowanie w trybie CBC. Praca
+ * zlecana jest wykonawcy biblioteki (@see Parallel::executor),
+ * wynik (jak w encrypt_cbc/decrypt_cbc) zwraca std::future
+ * i opcjonalnie funkcja zwrotna, wywoływana w wątku wykonawcy.
+ * Anulowanie sprawdzane jest przed startem i między fragmentami
+ * danych; anulowane zadanie zwraca (nullptr, -1).
+ * Kontekst szyfru i dane muszą istnieć do zakończenia zadania.
+ */
+template<typename Cipher>
+class Async {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int TileBytes = 64 * 1024;     // dane między sprawdzeniami anulowania
+    static constexpr int TileBlocks = TileBytes / BlockSize;
+
+public:
+    using Result = AsyncResult;
+    using Callback = AsyncCallback;
+
+    /**
+     * @brief encrypt_cbc
+     * Asynchroniczne szyfrowanie w trybie CBC (@see Cipher::encrypt_cbc).
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres bufora z jawnymi danymi.
+     * @param nbytes - rozmiar jawnych danych w bajtach.
+     * @param iv - wektor IV (nullptr: losowy), kopiowany przy wywołaniu.
+     * @param padding - rodzaj paddingu.
+     * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+     * @param cancellation - znacznik anulowania.
+     * @return future z wynikiem: IV + zaszyfrowane dane i ich rozmiar.
+     */
+    static std::future<Result>
+    encrypt_cbc(const Cipher& cipher, const void* const data, const int nbytes, const void* const iv,
+                const Padding padding, Callback callback, const Cancellation cancellation)
+    {
+        auto state = std::make_shared<State>(std::move(callback), cancellation);
+        if (iv) {
+            memcpy(state->iv, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(state->iv, BlockSize);
+        }
+        auto future = state->promise.get_future();
+        Parallel::executor()->execute([&cipher, data, nbytes, padding, state] {
+            state->finish(state->cancellation.cancelled()
+                          ? failure()
+                          : encrypt(cipher, data, nbytes, state->iv, padding, state->cancellation));
+        });
+        return future;
+    }
+
+    /**
+     * @brief decrypt_cbc
+     * Asynchroniczne deszyfrowanie w trybie CBC (@see Cipher::decrypt_cbc).
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres bufora z zaszyfrowanymi danymi (IV + dane).
+     * @param nbytes - rozmiar zaszyfrowanych danych w bajtach.
+     * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+     * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+     * @param cancellation - znacznik anulowania.
+     * @return future z wynikiem: odszyfrowane dane i ich rozmiar.
+     */
+    static std::future<Result>
+    decrypt_cbc(const Cipher& cipher, const void* const data, const int nbytes,
+                const Padding padding, Callback callback, const Cancellation cancellation)
+    {
+        auto state = std::make_shared<State>(std::move(callback), cancellation);
+        auto future = state->promise.get_future();
+        Parallel::executor()->execute([&cipher, data, nbytes, padding, state] {
+            state->finish(state->cancellation.cancelled()
+                          ? failure()
+                          : decrypt(cipher, data, nbytes, padding, state->cancellation));
+        });
+        return future;
+    }
+
+private:
+    /// Stan zadania współdzielony z wykonawcą.
+    struct State {
+        std::promise<Result> promise;
+        Callback callback;
+        Cancellation cancellation;
+        u8 iv[BlockSize];
+
+        State(Callback&& cb, const Cancellation& c) : callback(std::move(cb)), cancellation(c) {}
+
+        void finish(Result&& result) noexcept {
+            try {
+                if (callback) {
+                    callback(result);
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+                return;
+            }
+            promise.set_value(std::move(result));
+        }
+    };
+
+    static Result failure() noexcept {
+        return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+    }
+
+    /**
+     * @brief encrypt
+     * Szyfrowanie CBC w miejscu, w buforze wynikowym, fragmentami
+     * po TileBytes ze sprawdzaniem anulowania między nimi.
+     */
+    static Result encrypt(const Cipher& cipher, const void* const data, const int nbytes, u8* const iv,
+                          const Padding padding, const Cancellation& cancellation) noexcept
+    {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        if (padding == Padding::Cts) {
+            return cipher.encrypt_cbc(data, nbytes, iv, padding);
+        }
+        const int size = Crypto::padded_size(nbytes, BlockSize, padding);
+        if (size < 0) {
+            return failure();
+        }
+
+        u8* const out = new u8[size + BlockSize];
+        std::shared_ptr<void> result(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);});
+        memcpy(out, iv, BlockSize);
+        memcpy(out + BlockSize, data, nbytes);
+        Crypto::pad(out + BlockSize, nbytes, BlockSize, padding);
+
+        const u32* prv = reinterpret_cast<const u32*>(out);
+        u32* dst = reinterpret_cast<u32*>(out + BlockSize);
+        u32 tmp[BlockWords];
+        for (int done = 0; done < size / BlockSize; done += TileBlocks) {
+            if (cancellation.cancelled()) {
+                return failure();
+            }
+            const int n = std::min(TileBlocks, size / BlockSize - done);
+            for (int i = 0; i < n; i++) {
+                for (int w = 0; w < BlockWords; w++) {
+                    tmp[w] = dst[w] ^ prv[w];
+                }
+                cipher.encrypt_block(tmp, dst);
+                prv = dst;
+                dst += BlockWords;
+            }
+        }
+        return std::make_tuple(std::move(result), size + BlockSize);
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie CBC fragmentami (każdy może być deszyfrowany
+     * równolegle) ze sprawdzaniem anulowania między nimi.
+     */
+    static Result decrypt(const Cipher& cipher, const void* const data, int nbytes,
+                          const Padding padding, const Cancellation& cancellation) noexcept
+    {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        if (padding == Padding::Cts) {
+            return cipher.decrypt_cbc(data, nbytes, padding);
+        }
+        if (nbytes % BlockSize) {
+            return failure();
+        }
+
+        nbytes -= BlockSize;
+        u8* const out = new u8[std::max(nbytes, 1)];
+        std::shared_ptr<void> result(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);});
+        const u8* const in = static_cast<const u8*>(data);
+        // fragment na tyle duży, by mógł zostać podzielony między wątki
+        const u64 parallel = u64(Parallel::concurrency()) * u64(Parallel::threshold()) / BlockSize;
+        const int tile = int(std::max(u64(TileBlocks), std::min(parallel, u64(nbytes / BlockSize))));
+        for (int done = 0; done < nbytes / BlockSize; done += tile) {
+            if (cancellation.cancelled()) {
+                return failure();
+            }
+            const int n = std::min(tile, nbytes / BlockSize - done);
+            Cbc<Cipher>::decrypt_chain(cipher, in + done * BlockSize, n, out + done * BlockSize);
+        }
+
+        nbytes = Crypto::unpad(out, nbytes, BlockSize, padding);
+        if (nbytes < 0) {
+            return failure();
+        }
+        return std::make_tuple(std::move(result), nbytes);
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_ASYNC_H
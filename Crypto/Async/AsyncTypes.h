@@ -0,0 +1,68 @@
+#ifndef BEESOFT_CRYPTO_ASYNC_TYPES_H
+#define BEESOFT_CRYPTO_ASYNC_TYPES_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <tuple>
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Cancellation
+ * Znacznik anulowania zadania asynchronicznego. Kopie dzielą
+ * ten sam stan, więc wątek wywołujący zachowuje kopię i może
+ * anulować zadanie wykonywane w puli wątków.
+ */
+class Cancellation {
+    std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
+public:
+    void cancel() const noexcept {
+        flag->store(true, std::memory_order_relaxed);
+    }
+    bool cancelled() const noexcept {
+        return flag->load(std::memory_order_relaxed);
+    }
+};
+
+/// Wynik zadania asynchronicznego (jak encrypt_cbc/decrypt_cbc).
+using AsyncResult = std::tuple<std::shared_ptr<void>, int>;
+/// Funkcja zwrotna wywoływana z wynikiem zadania; zgłoszony przez nią
+/// wyjątek trafia do std::future zamiast wyniku.
+using AsyncCallback = std::function<void(const AsyncResult&)>;
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_ASYNC_TYPES_H
@@ -0,0 +1,295 @@
+#ifndef BEESOFT_CRYPTO_COALESCER_H
+#define BEESOFT_CRYPTO_COALESCER_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Crypto/Crypto.h"
+#include "Crypto/Async/Async.h"
+#include "Crypto/Modes/Cbc.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Coalescer
+ * Łączenie pojedynczych, małych żądań szyfrowania CBC we wsady.
+ * Żądania zbierane są do upływu terminu (liczonego od najstarszego
+ * oczekującego żądania) albo do osiągnięcia maksymalnego rozmiaru wsadu,
+ * po czym wątek w tle szyfruje je jednym wywołaniem Cbc::encrypt_batch
+ * (kernel wieloblokowy). Opóźnienie żądania jest ograniczone terminem
+ * i czasem szyfrowania wsadu. Statystyki zawierają histogramy rozmiarów
+ * wsadów i opóźnień (@see statistics).
+ * Kontekst szyfru i dane żądań muszą istnieć do ich zakończenia.
+ */
+template<typename Cipher>
+class Coalescer {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    using Clock = std::chrono::steady_clock;
+
+public:
+    static constexpr int LatencyBuckets = 32;
+
+    struct Stats {
+        u64 requests = 0;               // liczba żądań
+        u64 batches = 0;                // liczba wsadów
+        u64 full = 0;                   // wsady wysłane po osiągnięciu rozmiaru
+        u64 expired = 0;                // wsady wysłane po upływie terminu
+        std::vector<u64> sizes;         // [n] - liczba wsadów o n żądaniach
+        std::vector<u64> latency;       // [k] - żądania zakończone w [2^(k-1), 2^k) µs
+    };
+
+    /**
+     * @brief Coalescer
+     * Utworzenie obiektu i uruchomienie wątku wysyłającego wsady.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param deadline - maksymalny czas zbierania wsadu.
+     * @param max_batch - maksymalna liczba żądań we wsadzie.
+     * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+     */
+    Coalescer(const Cipher& cipher,
+              const std::chrono::microseconds deadline = std::chrono::microseconds(20),
+              const int max_batch = 64,
+              const Padding padding = Padding::Pkcs7)
+        : cipher(cipher)
+        , deadline(deadline)
+        , max_batch(std::max(1, max_batch))
+        , padding(padding)
+    {
+        stats.sizes.resize(this->max_batch + 1);
+        stats.latency.resize(LatencyBuckets);
+        worker = std::thread(&Coalescer::run, this);
+    }
+
+    /**
+     * @brief ~Coalescer
+     * Wysłanie oczekujących żądań i zatrzymanie wątku.
+     */
+    ~Coalescer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        arrived.notify_one();
+        worker.join();
+    }
+
+    Coalescer(const Coalescer&) = delete;
+    Coalescer& operator=(const Coalescer&) = delete;
+
+    /**
+     * @brief submit
+     * Zlecenie zaszyfrowania wiadomości w trybie CBC.
+     *
+     * @param data - adres jawnych danych.
+     * @param nbytes - rozmiar jawnych danych w bajtach.
+     * @param iv - wektor IV (nullptr: losowy), kopiowany przy wywołaniu.
+     * @param callback - funkcja wywoływana z wynikiem w wątku wsadów (może być pusta).
+     * @return future z wynikiem jak w encrypt_cbc (IV + szyfrogram i rozmiar)
+     *         lub wyjątkiem zgłoszonym przez callback.
+     */
+    std::future<AsyncResult> submit(const void* const data, const int nbytes,
+                                    const void* const iv = nullptr, AsyncCallback callback = {})
+    {
+        Request r;
+        r.data = data;
+        r.nbytes = nbytes;
+        if (iv) {
+            memcpy(r.iv, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(r.iv, BlockSize);
+        }
+        r.callback = std::move(callback);
+        r.arrival = Clock::now();
+        auto future = r.promise.get_future();
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(r));
+            stats.requests++;
+            // wątek budzony przy pierwszym żądaniu (start terminu) i pełnym wsadzie
+            wake = (pending.size() == 1) || (int(pending.size()) >= max_batch);
+        }
+        if (wake) {
+            arrived.notify_one();
+        }
+        return future;
+    }
+
+    /**
+     * @brief statistics
+     * @return kopia statystyk.
+     */
+    Stats statistics() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    struct Request {
+        const void* data;
+        int nbytes;
+        u8 iv[BlockSize];
+        AsyncCallback callback;
+        std::promise<AsyncResult> promise;
+        Clock::time_point arrival;
+    };
+
+    /**
+     * @brief run
+     * Pętla wątku: oczekiwanie na pierwsze żądanie, zbieranie wsadu
+     * do terminu lub pełnego rozmiaru i jego wysłanie.
+     */
+    void run() noexcept {
+        std::vector<Request> batch;
+        batch.reserve(max_batch);
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            arrived.wait(lock, [this] { return stop || !pending.empty(); });
+            if (pending.empty()) {
+                break;
+            }
+            const auto due = pending.front().arrival + deadline;
+            const bool full = arrived.wait_until(lock, due, [this] {
+                return stop || int(pending.size()) >= max_batch;
+            }) && int(pending.size()) >= max_batch;
+
+            const int n = std::min(int(pending.size()), max_batch);
+            for (int i = 0; i < n; i++) {
+                batch.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+            stats.batches++;
+            stats.sizes[n]++;
+            (full ? stats.full : stats.expired)++;
+
+            // statystyki przed przekazaniem wyników: po future.get() są już pełne
+            lock.unlock();
+            std::vector<AsyncResult> results;
+            const auto done = encrypt(batch, results);
+            lock.lock();
+            for (const auto& r : batch) {
+                const auto us = std::chrono::duration_cast<std::chrono::microseconds>(done - r.arrival).count();
+                stats.latency[std::min(LatencyBuckets - 1, bit_width(u64(us)))]++;
+            }
+            lock.unlock();
+            complete(batch, results);
+            lock.lock();
+            batch.clear();
+        }
+    }
+
+    /**
+     * @brief encrypt
+     * Zaszyfrowanie wsadu jednym wywołaniem encrypt_batch.
+     *
+     * @param batch - żądania.
+     * @param results - wyniki żądań (w tej samej kolejności).
+     * @return chwila zakończenia szyfrowania wsadu.
+     */
+    Clock::time_point encrypt(const std::vector<Request>& batch, std::vector<AsyncResult>& results) noexcept {
+        const int n = int(batch.size());
+        std::vector<typename Cbc<Cipher>::Job> jobs(n);
+        std::vector<std::shared_ptr<void>> buffers(n);
+        for (int i = 0; i < n; i++) {
+            const Request& r = batch[i];
+            const int padded = Crypto::padded_size(r.nbytes, BlockSize, padding);
+            u8* const out = (r.data && r.nbytes > 0 && padded >= 0) ? new u8[padded + BlockSize] : nullptr;
+            buffers[i] = std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);});
+            jobs[i] = {r.data, r.nbytes, r.iv, out, 0};
+        }
+        Cbc<Cipher>::encrypt_batch(cipher, jobs.data(), n, padding);
+
+        results.reserve(n);
+        for (int i = 0; i < n; i++) {
+            const int size = jobs[i].size;
+            results.push_back(std::make_tuple(size > 0 ? std::move(buffers[i]) : std::shared_ptr<void>(nullptr), size));
+        }
+        return Clock::now();
+    }
+
+    /**
+     * @brief complete
+     * Przekazanie wyników funkcjom zwrotnym i obiektom future
+     * (wyjątek funkcji zwrotnej trafia do jej future).
+     */
+    static void complete(std::vector<Request>& batch, std::vector<AsyncResult>& results) noexcept {
+        for (int i = 0; i < int(batch.size()); i++) {
+            try {
+                if (batch[i].callback) {
+                    batch[i].callback(results[i]);
+                }
+            } catch (...) {
+                // wyjątek funkcji zwrotnej nie może zatrzymać wątku wsadów
+                batch[i].promise.set_exception(std::current_exception());
+                continue;
+            }
+            batch[i].promise.set_value(std::move(results[i]));
+        }
+    }
+
+    static int bit_width(u64 v) noexcept {
+        int n = 0;
+        while (v) {
+            n++;
+            v >>= 1;
+        }
+        return n;
+    }
+
+    const Cipher& cipher;
+    const std::chrono::microseconds deadline;
+    const int max_batch;
+    const Padding padding;
+
+    mutable std::mutex mutex;
+    std::condition_variable arrived;
+    std::deque<Request> pending;
+    Stats stats;
+    bool stop = false;
+    std::thread worker;
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_COALESCER_H
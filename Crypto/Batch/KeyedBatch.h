@@ -0,0 +1,166 @@
+#ifndef BEESOFT_CRYPTO_BATCH_KEYED_BATCH_H
+#define BEESOFT_CRYPTO_BATCH_KEYED_BATCH_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <vector>
+#include "Crypto/Crypto.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief KeyedBatch
+ * Szyfrowanie w trybie CBC wsadu wiadomości, z których (prawie) każda
+ * ma własny kontekst szyfru (inny klucz).
+ * Wiadomości są grupowane według kontekstu: wiadomości jednej grupy
+ * szyfrowane są razem (@see Cbc::encrypt_batch), więc tablice S-box
+ * i podklucze są ładowane do pamięci podręcznej raz na grupę, a w czasie
+ * przetwarzania grupy pobierane są z wyprzedzeniem (prefetch) tablice
+ * kontekstu następnej grupy. Duże wsady są dzielone między wątki
+ * (@see Parallel) grupami.
+ * Wyniki wszystkich wiadomości trafiają do jednego ciągłego bufora,
+ * w kolejności wiadomości wejściowych (niezależnie od grupowania).
+ */
+template<typename Cipher>
+class KeyedBatch {
+public:
+    struct Request {
+        const Cipher* context;  // kontekst szyfru wiadomości
+        const void* data;       // jawne dane
+        int nbytes;             // rozmiar jawnych danych
+        const void* iv;         // wektor IV (nullptr: losowy)
+    };
+
+    struct Result {
+        int offset;     // pozycja wyniku (IV + szyfrogram) we wspólnym buforze
+        int size;       // rozmiar wyniku (0 dla pustych danych, -1 przy błędzie)
+    };
+
+    /**
+     * @brief encrypt_cbc
+     * Szyfrowanie wsadu wiadomości w trybie CBC.
+     *
+     * @param requests - tablica wiadomości.
+     * @param count - liczba wiadomości.
+     * @param results - tablica (count elementów) na położenie wyników.
+     * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+     * @return - tuple: adres wspólnego bufora z wynikami + jego rozmiar w bajtach.
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt_cbc(const Request* const requests, const int count, Result* const results, const Padding padding = Padding::Pkcs7) noexcept {
+        if (requests == nullptr || count <= 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+
+        // układ wyników w kolejności wiadomości
+        int total = 0;
+        for (int i = 0; i < count; i++) {
+            const Request& r = requests[i];
+            int size = 0;
+            if (r.context == nullptr || padding == Padding::Cts) {
+                size = -1;
+            } else if (r.data != nullptr && r.nbytes != 0) {
+                const int padded = Crypto::padded_size(r.nbytes, Cipher::BlockSize, padding);
+                size = (padded < 0) ? -1 : padded + Cipher::BlockSize;
+            }
+            results[i] = {total, size};
+            total += std::max(size, 0);
+        }
+        if (total == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        u8* const arena = new u8[total];
+
+        // grupy wiadomości o tym samym kontekście
+        std::vector<int> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [requests](const int a, const int b) {
+            return std::less<const Cipher*>()(requests[a].context, requests[b].context);
+        });
+        std::vector<int> groups;   // początki grup w order
+        for (int i = 0; i < count; i++) {
+            if (i == 0 || requests[order[i]].context != requests[order[i - 1]].context) {
+                groups.push_back(i);
+            }
+        }
+        const int ngroups = int(groups.size());
+        groups.push_back(count);
+
+        auto run = [&](const int begin, const int end) {
+            std::vector<typename Cbc<Cipher>::Job> jobs;
+            for (int g = begin; g < end; g++) {
+                if (g + 1 < end) {
+                    prefetch(requests[order[groups[g + 1]]].context);
+                }
+                const Cipher* const context = requests[order[groups[g]]].context;
+                if (context == nullptr) {
+                    continue;
+                }
+                jobs.clear();
+                for (int i = groups[g]; i < groups[g + 1]; i++) {
+                    const Request& r = requests[order[i]];
+                    jobs.push_back({r.data, r.nbytes, r.iv, arena + results[order[i]].offset, 0});
+                }
+                Cbc<Cipher>::encrypt_batch(*context, jobs.data(), int(jobs.size()), padding);
+            }
+        };
+        if (total >= Parallel::threshold()) {
+            Parallel::for_each(ngroups, 1, run);
+        } else {
+            run(0, ngroups);
+        }
+        return std::make_tuple(std::shared_ptr<void>(arena, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), total);
+    }
+
+private:
+    /// Pobranie kontekstu szyfru (tablic i podkluczy) do pamięci podręcznej.
+    static void prefetch(const Cipher* const context) noexcept {
+        if (context == nullptr) {
+            return;
+        }
+        const char* const p = reinterpret_cast<const char*>(context);
+        for (size_t i = 0; i < sizeof(Cipher); i += CacheLineSize) {
+            __builtin_prefetch(p + i, 0, 3);
+        }
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_BATCH_KEYED_BATCH_H
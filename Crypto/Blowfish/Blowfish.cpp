@@ -34,6 +34,13 @@
 #include "Blowfish.h"
 #include "BlowfishData.h"
 #include "Crypto/Crypto.h"
+#include "Crypto/Async/Async.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Modes/Cfb.h"
+#include "Crypto/Modes/Cmac.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Modes/Ecb.h"
+#include "Crypto/Modes/Ofb.h"
 
 /*------- namespaces:
 -------------------------------------------------------------------*/
@@ -41,22 +48,74 @@ namespace beesoft {
 namespace crypto {
 using namespace std;
 
-static constexpr int BlockSize = 8;
 static constexpr int MinKeySize = 4;
 static constexpr int MaxKeySize = 56;
 
 
 /**
  * @brief Blowfish
- * Konstruktor (jedyny).
+ * Konstruktor kontekstu bez klucza (np. dla puli kontekstów).
+ * Przed użyciem kontekst musi zostać zainicjowany kluczem (@see rekey).
+ */
+Blowfish::Blowfish() noexcept : p{}, s{}
+{}
+
+/**
+ * @brief Blowfish
+ * Konstruktor z kluczem.
  *
  * @param cipher_key - klucz od użytkownika
  * @param key_size - rozmiar przysłanego klucza (jako liczba bajtów).
  */
 Blowfish::Blowfish(const void* const cipher_key, const int key_size) {
+    rekey(cipher_key, key_size);
+}
+
+Blowfish::~Blowfish() {
+    clear();
+}
+
+/**
+ * @brief Blowfish
+ * Konstruktor przenoszący. Kontekst źródłowy zostaje wyczyszczony.
+ *
+ * @param other - kontekst źródłowy.
+ */
+Blowfish::Blowfish(Blowfish&& other) noexcept {
+    memcpy(p, other.p, sizeof(p));
+    memcpy(s, other.s, sizeof(s));
+    other.clear();
+}
+
+/**
+ * @brief operator=
+ * Przypisanie przenoszące. Kontekst źródłowy zostaje wyczyszczony.
+ *
+ * @param other - kontekst źródłowy.
+ * @return referencja do tego kontekstu.
+ */
+Blowfish& Blowfish::operator=(Blowfish&& other) noexcept {
+    if (this != &other) {
+        memcpy(p, other.p, sizeof(p));
+        memcpy(s, other.s, sizeof(s));
+        other.clear();
+    }
+    return *this;
+}
+
+/**
+ * @brief rekey
+ * Inicjalizacja kontekstu (w miejscu) nowym kluczem.
+ * Pozwala na ponowne użycie kontekstu bez jego alokacji.
+ *
+ * @param cipher_key - klucz od użytkownika
+ * @param key_size - rozmiar przysłanego klucza (jako liczba bajtów).
+ * @return true jeśli klucz został ustawiony, false przy błędnym rozmiarze klucza.
+ */
+bool Blowfish::rekey(const void* const cipher_key, const int key_size) noexcept {
     if (key_size < MinKeySize || key_size > MaxKeySize) {
         cerr << "Error (blowfish): invalid key size" << endl;
-        return;
+        return false;
     }
 
     const u8* const key = static_cast<const u8*>(cipher_key);
@@ -99,14 +158,16 @@ Blowfish::Blowfish(const void* const cipher_key, const int key_size) {
             s[i][j+1] = data[1];
         }
     }
+    return true;
 }
 
-Blowfish::~Blowfish() {
-    Crypto::clear_bytes(p, (RoundCount+2) * sizeof(u32));
-    Crypto::clear_bytes(s[0], 256 * sizeof(u32));
-    Crypto::clear_bytes(s[1], 256 * sizeof(u32));
-    Crypto::clear_bytes(s[2], 256 * sizeof(u32));
-    Crypto::clear_bytes(s[3], 256 * sizeof(u32));
+/**
+ * @brief clear
+ * Bezpieczne wyczyszczenie kontekstu (klucza i tablic S).
+ */
+void Blowfish::clear() noexcept {
+    Crypto::clear_bytes(p, sizeof(p));
+    Crypto::clear_bytes(s, sizeof(s));
 }
 
 inline u32 Blowfish::f(u32 x) const noexcept {
@@ -213,48 +274,108 @@ void Blowfish::decrypt_block(const u32* const src, u32* const dst) const noexcep
     dst[1] = xl ^ p[1];
 }
 
+/**
+ * @brief encrypt_blocks
+ * Szyfrowanie wielu niezależnych bloków (tryb ECB bez paddingu).
+ * Bloki są przetwarzane po Lanes jednocześnie - rundy kolejnych bloków
+ * przeplatają się, co pozwala procesorowi wykonywać je równolegle.
+ * Bufory mogą być tym samym buforem (szyfrowanie w miejscu).
+ *
+ * @param src - adres bufora z jawnymi blokami.
+ * @param dst - adres bufora na zaszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Blowfish::encrypt_blocks(const u32* src, u32* dst, int nblocks) const noexcept {
+    static_assert(Lanes == 4, "kernel is written for 4 lanes");
+    for (; nblocks >= Lanes; nblocks -= Lanes, src += 2 * Lanes, dst += 2 * Lanes) {
+        u32 xl0 = src[0], xr0 = src[1];
+        u32 xl1 = src[2], xr1 = src[3];
+        u32 xl2 = src[4], xr2 = src[5];
+        u32 xl3 = src[6], xr3 = src[7];
+
+        for (int i = 0; i < RoundCount; i += 2) {
+            xl0 ^= p[i]; xl1 ^= p[i]; xl2 ^= p[i]; xl3 ^= p[i];
+            xr0 ^= f(xl0); xr1 ^= f(xl1); xr2 ^= f(xl2); xr3 ^= f(xl3);
+            xr0 ^= p[i+1]; xr1 ^= p[i+1]; xr2 ^= p[i+1]; xr3 ^= p[i+1];
+            xl0 ^= f(xr0); xl1 ^= f(xr1); xl2 ^= f(xr2); xl3 ^= f(xr3);
+        }
+
+        dst[0] = xr0 ^ p[17]; dst[1] = xl0 ^ p[16];
+        dst[2] = xr1 ^ p[17]; dst[3] = xl1 ^ p[16];
+        dst[4] = xr2 ^ p[17]; dst[5] = xl2 ^ p[16];
+        dst[6] = xr3 ^ p[17]; dst[7] = xl3 ^ p[16];
+    }
+    for (; nblocks > 0; nblocks--, src += 2, dst += 2) {
+        encrypt_block(src, dst);
+    }
+}
+
+/**
+ * @brief decrypt_blocks
+ * Odszyfrowanie wielu niezależnych bloków (@see encrypt_blocks).
+ *
+ * @param src - adres bufora z zaszyfrowanymi blokami.
+ * @param dst - adres bufora na odszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Blowfish::decrypt_blocks(const u32* src, u32* dst, int nblocks) const noexcept {
+    static_assert(Lanes == 4, "kernel is written for 4 lanes");
+    for (; nblocks >= Lanes; nblocks -= Lanes, src += 2 * Lanes, dst += 2 * Lanes) {
+        u32 xl0 = src[0], xr0 = src[1];
+        u32 xl1 = src[2], xr1 = src[3];
+        u32 xl2 = src[4], xr2 = src[5];
+        u32 xl3 = src[6], xr3 = src[7];
+
+        for (int i = RoundCount + 1; i > 1; i -= 2) {
+            xl0 ^= p[i]; xl1 ^= p[i]; xl2 ^= p[i]; xl3 ^= p[i];
+            xr0 ^= f(xl0); xr1 ^= f(xl1); xr2 ^= f(xl2); xr3 ^= f(xl3);
+            xr0 ^= p[i-1]; xr1 ^= p[i-1]; xr2 ^= p[i-1]; xr3 ^= p[i-1];
+            xl0 ^= f(xr0); xl1 ^= f(xr1); xl2 ^= f(xr2); xl3 ^= f(xr3);
+        }
+
+        dst[0] = xr0 ^ p[0]; dst[1] = xl0 ^ p[1];
+        dst[2] = xr1 ^ p[0]; dst[3] = xl1 ^ p[1];
+        dst[4] = xr2 ^ p[0]; dst[5] = xl2 ^ p[1];
+        dst[6] = xr3 ^ p[0]; dst[7] = xl3 ^ p[1];
+    }
+    for (; nblocks > 0; nblocks--, src += 2, dst += 2) {
+        decrypt_block(src, dst);
+    }
+}
+
 /**
  * @brief encrypt_ecb
  * Szyfrowanie w trybie ECB.
  * Jeśli rozmiar jawnych danych nie jest wielokrotnością rozmiaru bloku
  * zostanie uzupełniony o tzw. padding.
+ * Duże dane są szyfrowane wielowątkowo (@see Ecb).
  *
  * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
  * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
- * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu (Cts nie jest obsługiwany w ECB).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 gdy danych nie można uzupełnić wskazanym paddingiem).
  */
 std::tuple<shared_ptr<void>, int>
-Blowfish::encrypt_ecb(const void* const data, const int nbytes) const noexcept {
+Blowfish::encrypt_ecb(const void* const data, const int nbytes, const Padding padding) const noexcept {
 
     if (data == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
 
-    int size = nbytes;
-    const int n = size % BlockSize;
-    u8* const plain = new u8[size + n];
-    memcpy(plain, data, size);
-    if (n) {
-        // Ponieważ rozmiar bufora danych do zaszyfrownia
-        // nie jest wielokrotnością bloku dodajemy padding
-        // o stosownej długości.
-        bzero(plain + size, n);
-        plain[size] = 128;
-        size += n;
+    const int size = (padding == Padding::Cts) ? -1 : Crypto::padded_size(nbytes, BlockSize, padding);
+    if (size < 0) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
 
+    // Szyfrowanie w miejscu, w buforze wynikowym.
     u8* const cipher = new u8[size];
+    memcpy(cipher, data, nbytes);
+    Crypto::pad(cipher, nbytes, BlockSize, padding);
 
-    u32* src = reinterpret_cast<u32*>(plain);
-    u32* dst = reinterpret_cast<u32*>(cipher);
+    u32* const dst = reinterpret_cast<u32*>(cipher);
+    Ecb<Blowfish>::encrypt(*this, dst, dst, size/BlockSize);
 
-    for (int i = 0; i < (size/BlockSize); i++) {
-        encrypt_block(src, dst);
-        src += 2;
-        dst += 2;
-    }
-
-    delete[] plain;
     return make_tuple(shared_ptr<void>(cipher, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
 }
 
@@ -265,29 +386,30 @@ Blowfish::encrypt_ecb(const void* const data, const int nbytes) const noexcept {
  *
  * @param data - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
  * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
- * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
  */
 std::tuple<std::shared_ptr<void>, int>
-Blowfish::decrypt_ecb(const void* const cipher, int nbytes) const noexcept {
+Blowfish::decrypt_ecb(const void* const cipher, int nbytes, const Padding padding) const noexcept {
 
     if (cipher == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
+    if (nbytes % BlockSize || padding == Padding::Cts) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
 
     u8* const plain  = new u8[nbytes];
-    bzero(plain, nbytes);
-
-    const u32* src = reinterpret_cast<const u32*>(cipher);
-    u32* dst = reinterpret_cast<u32*>(plain);
 
-    for (int i = 0; i < (nbytes/BlockSize); i++) {
-        decrypt_block(src, dst);
-        src += 2;
-        dst += 2;
-    }
+    const u32* const src = reinterpret_cast<const u32*>(cipher);
+    u32* const dst = reinterpret_cast<u32*>(plain);
+    Ecb<Blowfish>::decrypt(*this, src, dst, nbytes/BlockSize);
 
-    if (const int idx = Crypto::padding_index(plain, nbytes); idx != -1) {
-        nbytes = idx;
+    nbytes = Crypto::unpad(plain, nbytes, BlockSize, padding);
+    if (nbytes < 0) {
+        delete[] plain;
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
     return make_tuple(shared_ptr<void>(plain, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes);
 }
@@ -298,65 +420,58 @@ Blowfish::decrypt_ecb(const void* const cipher, int nbytes) const noexcept {
  * jako parametr to zostanie losowo wygenerowany.
  * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
  * Jeśli rozmiar jawnych danych nie jest wielokrotnością rozmiaru bloku
- * zostanie uzupełniony o tzw. padding.
+ * zostanie uzupełniony o tzw. padding (lub, dla Padding::Cts,
+ * zastosowana zostanie kradzież szyfrogramu).
  *
  * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
  * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
  * @param iv - adres wektor IV (może być nullptr).
- * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu.
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 gdy danych nie można uzupełnić wskazanym paddingiem).
  */
 std::tuple<std::shared_ptr<void>, int>
-Blowfish::encrypt_cbc(const void* const data, const int nbytes, void* iv) const noexcept {
+Blowfish::encrypt_cbc(const void* const data, const int nbytes, void* iv, const Padding padding) const noexcept {
 
     if (data == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
 
-    bool custom_iv = false;
+    u8 random_iv[BlockSize];
     if (iv == nullptr) {
         // Jeśli funkcja wywołująca nie przekazała wektora IV
         // sami generujemy go losowo.
-        iv = new u8[BlockSize];
-        Crypto::random_bytes(iv, BlockSize);
-        custom_iv = true;
+        Crypto::random_bytes(random_iv, BlockSize);
+        iv = random_iv;
+    }
+
+    if (padding == Padding::Cts) {
+        return Cbc<Blowfish>::encrypt_cts(*this, data, nbytes, iv);
     }
 
-    u8* plain = nullptr;
-    int size = nbytes;
-    const int n = size % BlockSize;
-    if (n) {
-        // Ponieważ rozmiar bufora danych do zaszyfrownia
-        // nie jest wielokrotnością bloku dodajemy padding
-        // o stosownej długości.
-        const int dn = BlockSize - n;
-        plain = new u8[size + dn];
-        memcpy(plain, data, size);
-        bzero(plain + size, dn);
-        plain[size] = 128;
-        size += dn;
-    } else {
-        plain = new u8[size];
-        memcpy(plain, data, size);
+    const int size = Crypto::padded_size(nbytes, BlockSize, padding);
+    if (size < 0) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
 
+    // Szyfrowanie w miejscu, w buforze wynikowym (za wektorem IV).
     u8* const cipher = new u8[size + BlockSize];
+    memcpy(cipher, iv, BlockSize);
+    memcpy(cipher + BlockSize, data, nbytes);
+    Crypto::pad(cipher + BlockSize, nbytes, BlockSize, padding);
 
-    u32* src = reinterpret_cast<u32*>(plain);
-    u32* dst = reinterpret_cast<u32*>(cipher);
-    memcpy(dst, iv, BlockSize);
+    const u32* prv = reinterpret_cast<const u32*>(cipher);
+    u32* dst = reinterpret_cast<u32*>(cipher + BlockSize);
 
     u32 tmp[2];
     for (int i = 0; i < (size/BlockSize); i++) {
-        tmp[0] = src[0] ^ dst[0];
-        tmp[1] = src[1] ^ dst[1];
-        dst += 2;
+        tmp[0] = dst[0] ^ prv[0];
+        tmp[1] = dst[1] ^ prv[1];
         encrypt_block(tmp, dst);
-        src += 2;
+        prv = dst;
+        dst += 2;
     }
 
-    if (custom_iv) delete[] static_cast<u8*>(iv);
-    delete[] plain;
-
     return make_tuple(shared_ptr<void>(cipher, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size + BlockSize);
 }
 
@@ -368,35 +483,278 @@ Blowfish::encrypt_cbc(const void* const data, const int nbytes, void* iv) const
  *
  * @param data - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
  * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
- * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
  */
 std::tuple<std::shared_ptr<void>, int>
-Blowfish::decrypt_cbc(const void* const cipher, int nbytes) const noexcept {
+Blowfish::decrypt_cbc(const void* const cipher, int nbytes, const Padding padding) const noexcept {
 
     if (cipher == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
+    if (padding == Padding::Cts) {
+        return Cbc<Blowfish>::decrypt_cts(*this, cipher, nbytes);
+    }
+    if (nbytes % BlockSize) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
 
     nbytes -= BlockSize;
     u8* const plain  = new u8[nbytes];
-    bzero(plain, nbytes);
 
-    const u32* src = reinterpret_cast<const u32*>(cipher);
-    u32* dst = reinterpret_cast<u32*>(plain);
+    // bloki są niezależne: duże dane deszyfrowane równolegle, padding tylko w ostatnim bloku
+    Cbc<Blowfish>::decrypt_chain(*this, cipher, nbytes/BlockSize, plain);
 
-    for (int i = 0; i < (nbytes/BlockSize); i++) {
-        decrypt_block(src + 2, dst);
-
-        dst[0] = dst[0] ^ src[0];
-        dst[1] = dst[1] ^ src[1];
-        dst += 2;
-        src += 2;
-    }
-
-    if (const int idx = Crypto::padding_index(plain, nbytes); idx != -1) {
-        nbytes = idx;
+    nbytes = Crypto::unpad(plain, nbytes, BlockSize, padding);
+    if (nbytes < 0) {
+        delete[] plain;
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
     return make_tuple(shared_ptr<void>(plain, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes);
 }
 
+
+/**
+ * @brief encrypt_cbc
+ * Szyfrowanie w trybie CBC danych rozproszonych w segmentach (jak writev).
+ * Łańcuch CBC i niepełne bloki przechodzą przez granice segmentów.
+ * @see Cbc::encrypt_segments
+ *
+ * @param in - segmenty z jawnymi danymi.
+ * @param in_count - liczba segmentów wejściowych.
+ * @param out - segmenty na zaszyfrowane dane (IV + dane z paddingiem).
+ * @param out_count - liczba segmentów wyjściowych.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+ * @return liczba zapisanych bajtów lub -1 przy błędzie.
+ */
+int Blowfish::encrypt_cbc(const iovec* const in, const int in_count,
+                       const iovec* const out, const int out_count, const void* const iv,
+                       const Padding padding) const noexcept {
+    return Cbc<Blowfish>::encrypt_segments(*this, in, in_count, out, out_count, iv, padding);
+}
+
+/**
+ * @brief decrypt_cbc
+ * Deszyfrowanie w trybie CBC danych rozproszonych w segmentach (jak readv).
+ * @see Cbc::decrypt_segments
+ *
+ * @param in - segmenty z zaszyfrowanymi danymi (IV + dane).
+ * @param in_count - liczba segmentów wejściowych.
+ * @param out - segmenty na odszyfrowane dane.
+ * @param out_count - liczba segmentów wyjściowych.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return liczba odszyfrowanych bajtów lub -1 przy błędzie.
+ */
+int Blowfish::decrypt_cbc(const iovec* const in, const int in_count,
+                       const iovec* const out, const int out_count, const Padding padding) const noexcept {
+    return Cbc<Blowfish>::decrypt_segments(*this, in, in_count, out, out_count, padding);
+}
+
+/**
+ * @brief decrypt_cbc_range
+ * Odszyfrowanie w trybie CBC tylko fragmentu jawnych danych
+ * (bez deszyfrowania całego bufora).
+ * @see Cbc::decrypt_range
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi (IV + dane).
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @param offset - pozycja początku fragmentu w jawnych danych.
+ * @param length - długość fragmentu w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z fragmentem + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::decrypt_cbc_range(const void* const cipher, const int nbytes, const int offset, const int length, const Padding padding) const noexcept {
+    return Cbc<Blowfish>::decrypt_range(*this, cipher, nbytes, offset, length, padding);
+}
+
+/**
+ * @brief encrypt_cbc_async
+ * Szyfrowanie w trybie CBC w puli wątków biblioteki.
+ * Dane i kontekst szyfru muszą istnieć do zakończenia zadania.
+ * @see Async::encrypt_cbc
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektora IV (może być nullptr).
+ * @param padding - rodzaj paddingu.
+ * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+ * @param cancellation - znacznik anulowania zadania.
+ * @return - future z wynikiem jak w encrypt_cbc ((nullptr, -1) po anulowaniu).
+ */
+std::future<AsyncResult>
+Blowfish::encrypt_cbc_async(const void* const data, const int nbytes, const void* const iv, const Padding padding,
+                            AsyncCallback callback, const Cancellation cancellation) const {
+    return Async<Blowfish>::encrypt_cbc(*this, data, nbytes, iv, padding, move(callback), cancellation);
+}
+
+/**
+ * @brief decrypt_cbc_async
+ * Deszyfrowanie w trybie CBC w puli wątków biblioteki.
+ * Dane i kontekst szyfru muszą istnieć do zakończenia zadania.
+ * @see Async::decrypt_cbc
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi (IV + dane).
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+ * @param cancellation - znacznik anulowania zadania.
+ * @return - future z wynikiem jak w decrypt_cbc ((nullptr, -1) po anulowaniu).
+ */
+std::future<AsyncResult>
+Blowfish::decrypt_cbc_async(const void* const cipher, const int nbytes, const Padding padding,
+                            AsyncCallback callback, const Cancellation cancellation) const {
+    return Async<Blowfish>::decrypt_cbc(*this, cipher, nbytes, padding, move(callback), cancellation);
+}
+
+/**
+ * @brief encrypt_ctr
+ * Szyfrowanie w trybie CTR (bez paddingu). Jeśli IV nie został przekazany
+ * jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Ctr
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::encrypt_ctr(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Ctr<Blowfish>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_ctr
+ * Deszyfrowanie w trybie CTR (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::decrypt_ctr(const void* const cipher, const int nbytes) const noexcept {
+    return Ctr<Blowfish>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief crypt_ctr
+ * Szyfrowanie/odszyfrowanie w trybie CTR fragmentu danych zaczynającego
+ * się od dowolnego bajtu strumienia (swobodny dostęp).
+ *
+ * @param iv - wartość początkowa licznika.
+ * @param offset - pozycja pierwszego bajtu w strumieniu.
+ * @param src - adres danych wejściowych.
+ * @param dst - adres bufora wynikowego (może być równy src).
+ * @param nbytes - liczba bajtów.
+ */
+void Blowfish::crypt_ctr(const void* const iv, const u64 offset, const void* const src, void* const dst, const int nbytes) const noexcept {
+    Ctr<Blowfish>::crypt(*this, iv, offset, src, dst, nbytes);
+}
+
+/**
+ * @brief encrypt_cfb
+ * Szyfrowanie w trybie pełnoblokowym CFB (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Cfb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::encrypt_cfb(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Cfb<Blowfish>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_cfb
+ * Deszyfrowanie w trybie pełnoblokowym CFB (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::decrypt_cfb(const void* const cipher, const int nbytes) const noexcept {
+    return Cfb<Blowfish>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief encrypt_cfb8
+ * Szyfrowanie w trybie 8-bitowym CFB (CFB8) (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Cfb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::encrypt_cfb8(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Cfb<Blowfish>::encrypt(*this, data, nbytes, iv, 1);
+}
+
+/**
+ * @brief decrypt_cfb8
+ * Deszyfrowanie w trybie 8-bitowym CFB (CFB8) (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::decrypt_cfb8(const void* const cipher, const int nbytes) const noexcept {
+    return Cfb<Blowfish>::decrypt(*this, cipher, nbytes, 1);
+}
+
+/**
+ * @brief encrypt_ofb
+ * Szyfrowanie w trybie OFB (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Ofb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::encrypt_ofb(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Ofb<Blowfish>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_ofb
+ * Deszyfrowanie w trybie OFB (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Blowfish::decrypt_ofb(const void* const cipher, const int nbytes) const noexcept {
+    return Ofb<Blowfish>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief cmac
+ * Wyznaczenie kodu uwierzytelniającego CMAC danych.
+ * @see Cmac
+ *
+ * @param data - adres danych.
+ * @param nbytes - rozmiar danych w bajtach.
+ * @param tag - adres bufora na znacznik (BlockSize bajtów).
+ */
+void Blowfish::cmac(const void* const data, const int nbytes, void* const tag) const noexcept {
+    Cmac<Blowfish>::compute(*this, data, nbytes, tag);
+}
+
 }} // namespaces
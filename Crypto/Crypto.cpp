@@ -32,6 +32,7 @@
 #include <cstring>
 #include <cstdio>
 #include "Crypto.h"
+#include "Crypto/Drbg/Drbg.h"
 
 /*------- namespaces:
 -------------------------------------------------------------------*/
@@ -42,35 +43,49 @@ namespace crypto {
  * @brief random_bytes
  * Losowe wygenerowanie wskazanej liczby bajtów i wpisanie ich
  * do wskazanego bufora.
+ * Bajty pochodzą z generatora bieżącego wątku (@see Drbg), który jest
+ * zasilany z getrandom - pojedyncze wywołanie nie wymaga wywołania systemowego.
  *
  * @param data - adres bufora na wygenerowane dane.
  * @param nbytes - rozmiar bufora (w bajtach).
  */
 void Crypto::random_bytes(void* const data, const int nbytes) noexcept {
-    while (getrandom(data, nbytes, 0) != nbytes);
+    if (nbytes > 0) {
+        Drbg::local().generate(data, nbytes);
+    }
+}
+
+/**
+ * @brief system_random_bytes
+ * Losowe wygenerowanie wskazanej liczby bajtów bezpośrednio przez
+ * system operacyjny (getrandom). Służy do zasilania generatora Drbg.
+ *
+ * @param data - adres bufora na wygenerowane dane.
+ * @param nbytes - rozmiar bufora (w bajtach).
+ */
+void Crypto::system_random_bytes(void* const data, const int nbytes) noexcept {
+    u8* const bytes = static_cast<u8*>(data);
+    for (int done = 0; done < nbytes; ) {
+        if (const ssize_t n = getrandom(bytes + done, nbytes - done, 0); n > 0) {
+            done += int(n);
+        }
+    }
 }
 
 /**
  * @brief clear_bytes
  * Wyczyszczenie wskazanego bufora danych o podanym rozmiarze.
  * Zwyczajowo bufor to tablica zawierająca klucz szyfujący lub IV.
- * Najprawdopodobniej ma zawartość wygenerowaną losowo (@see random_bytes).
+ * Czyszczenie nie alokuje pamięci i nie może zostać usunięte
+ * przez kompilator (explicit_bzero).
  *
  * @param data - adres bufora z danymi.
  * @param nbytes - rozmiar wskazanego bufora (w bajtach).
  */
 void Crypto::clear_bytes(void* const data, const int nbytes) noexcept {
-    // czterokrotnie wypełniamy bufor liczbami losowymi
-    const u8* rnd_buffer = new u8[4 * nbytes];
-    for (int i = 0, rnd_idx = 0; i < 4; i++, rnd_idx += nbytes) {
-        memcpy(data, rnd_buffer + rnd_idx, nbytes);
+    if (nbytes > 0) {
+        explicit_bzero(data, size_t(nbytes));
     }
-    delete[] rnd_buffer;
-
-    memset(data, 0x55, nbytes);
-    memset(data, 0xaa, nbytes);
-    memset(data, 0xff, nbytes);
-    memset(data, 0x00, nbytes);
 }
 
 /**
@@ -114,6 +129,101 @@ int Crypto::padding_index(const u8* const data, const int nbytes) noexcept {
     return -1;
 }
 
+/**
+ * @brief padded_size
+ * Wyznaczenie rozmiaru danych po dodaniu paddingu.
+ *
+ * @param nbytes - rozmiar jawnych danych w bajtach.
+ * @param block_size - rozmiar bloku szyfru w bajtach.
+ * @param padding - rodzaj paddingu.
+ * @return rozmiar danych z paddingiem lub -1 gdy dane nie mogą być
+ *         uzupełnione wskazanym paddingiem.
+ */
+int Crypto::padded_size(const int nbytes, const int block_size, const Padding padding) noexcept {
+    const int n = nbytes % block_size;
+    switch (padding) {
+    case Padding::None:
+        return n ? -1 : nbytes;
+    case Padding::Pkcs7:
+        return nbytes + (block_size - n);
+    case Padding::Iso7816:
+        return n ? nbytes + (block_size - n) : nbytes;
+    case Padding::Cts:
+        return (nbytes < block_size) ? -1 : nbytes;
+    }
+    return -1;
+}
+
+/**
+ * @brief pad
+ * Wpisanie paddingu za jawnymi danymi. Bufor musi mieć rozmiar
+ * wyznaczony przez padded_size.
+ *
+ * @param data - adres bufora z jawnymi danymi.
+ * @param nbytes - rozmiar jawnych danych w bajtach.
+ * @param block_size - rozmiar bloku szyfru w bajtach.
+ * @param padding - rodzaj paddingu.
+ */
+void Crypto::pad(u8* const data, const int nbytes, const int block_size, const Padding padding) noexcept {
+    const int n = nbytes % block_size;
+    switch (padding) {
+    case Padding::Pkcs7: {
+        const int dn = block_size - n;
+        memset(data + nbytes, dn, dn);
+        break;
+    }
+    case Padding::Iso7816:
+        if (n) {
+            memset(data + nbytes, 0, block_size - n);
+            data[nbytes] = 128;
+        }
+        break;
+    case Padding::None:
+    case Padding::Cts:
+        break;
+    }
+}
+
+/**
+ * @brief unpad
+ * Wyznaczenie rozmiaru jawnych danych po usunięciu paddingu.
+ * Padding jest szukany tylko w ostatnim bloku.
+ *
+ * @param data - adres bufora z odszyfrowanymi danymi.
+ * @param nbytes - rozmiar bufora (wielokrotność bloku).
+ * @param block_size - rozmiar bloku szyfru w bajtach.
+ * @param padding - rodzaj paddingu.
+ * @return rozmiar jawnych danych lub -1 gdy padding jest niepoprawny.
+ */
+int Crypto::unpad(const u8* const data, const int nbytes, const int block_size, const Padding padding) noexcept {
+    if (nbytes < block_size) {
+        return (padding == Padding::Pkcs7) ? -1 : nbytes;
+    }
+    const u8* const last = data + nbytes - block_size;
+    switch (padding) {
+    case Padding::Pkcs7: {
+        const int dn = last[block_size - 1];
+        if (dn == 0 || dn > block_size) {
+            return -1;
+        }
+        u8 diff = 0;
+        for (int i = block_size - dn; i < block_size; i++) {
+            diff |= last[i] ^ u8(dn);
+        }
+        return diff ? -1 : nbytes - dn;
+    }
+    case Padding::Iso7816:
+        if (const int idx = padding_index(last, block_size); idx != -1) {
+            return nbytes - block_size + idx;
+        }
+        return nbytes;
+    case Padding::None:
+    case Padding::Cts:
+        return nbytes;
+    }
+    return -1;
+}
+
 /**
  * @brief compare_bytes
  * Porównanie identyczności bajtów dwóch buforów.
@@ -127,5 +237,53 @@ bool Crypto::compare_bytes(const void* const a, const void* const b, const int n
     return (memcmp(a, b, n) == 0);
 }
 
+/**
+ * @brief verify_bytes
+ * Porównanie bajtów dwóch buforów w czasie niezależnym od ich zawartości
+ * (do sprawdzania znaczników MAC).
+ *
+ * @param a - adres pierwszego bufora danych.
+ * @param b - adres drugiego bufora danych.
+ * @param n - liczba bajtów do sprawdzenia
+ * @return true jeśli wszystkie bajty są takie same, false w przeciwnym przypadku.
+ */
+bool Crypto::verify_bytes(const void* const a, const void* const b, const int n) noexcept {
+    const volatile u8* const x = static_cast<const u8*>(a);
+    const volatile u8* const y = static_cast<const u8*>(b);
+    u8 diff = 0;
+    for (int i = 0; i < n; i++) {
+        diff |= x[i] ^ y[i];
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief xor_bytes
+ * Wyznaczenie sumy modulo 2 (XOR) dwóch buforów: dst = a ^ b.
+ * Bufor dst może być jednym z buforów a, b.
+ *
+ * @param dst - adres bufora wynikowego.
+ * @param a - adres pierwszego bufora danych.
+ * @param b - adres drugiego bufora danych.
+ * @param n - liczba bajtów.
+ */
+void Crypto::xor_bytes(void* const dst, const void* const a, const void* const b, const int n) noexcept {
+    u8* const out = static_cast<u8*>(dst);
+    const u8* const x = static_cast<const u8*>(a);
+    const u8* const y = static_cast<const u8*>(b);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        u64 u, v;
+        memcpy(&u, x + i, 8);
+        memcpy(&v, y + i, 8);
+        u ^= v;
+        memcpy(out + i, &u, 8);
+    }
+    for (; i < n; i++) {
+        out[i] = x[i] ^ y[i];
+    }
+}
+
 
 }} // namespaces
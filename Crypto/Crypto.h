@@ -35,13 +35,29 @@
 /*------- types:
 -------------------------------------------------------------------*/
 using u32 = uint32_t;
+using u64 = uint64_t;
 using u8 = uint8_t;
 
+/*------- constants:
+-------------------------------------------------------------------*/
+static constexpr int CacheLineSize = 64;    // in bytes
+
 /*------- namespaces:
 -------------------------------------------------------------------*/
 namespace beesoft {
 namespace crypto {
 
+/**
+ * @brief Padding
+ * Sposób uzupełniania ostatniego bloku danych w trybach ECB i CBC.
+ */
+enum class Padding {
+    None,       // bez paddingu, rozmiar danych musi być wielokrotnością bloku
+    Pkcs7,      // PKCS#7, zawsze dodawany (także do pełnych bloków)
+    Iso7816,    // ISO/IEC 7816-4 (0x80 + zera), pełne bloki bez paddingu (domyślny)
+    Cts         // kradzież szyfrogramu (CBC-CS3), rozmiar bez zmian
+};
+
 class Crypto {
 public:
     Crypto() = default;
@@ -53,10 +69,16 @@ public:
     Crypto&& operator=(const Crypto&&) = delete;
 
     static void random_bytes(void* const, const int) noexcept;
+    static void system_random_bytes(void* const, const int) noexcept;
     static void clear_bytes(void* const, const int) noexcept;
     static void print_bytes(void* const, const int) noexcept;
     static int  padding_index(const u8* const, const int) noexcept;
+    static int  padded_size(const int, const int, const Padding) noexcept;
+    static void pad(u8* const, const int, const int, const Padding) noexcept;
+    static int  unpad(const u8* const, const int, const int, const Padding) noexcept;
     static bool compare_bytes(const void* const, const void* const, const int) noexcept;
+    static bool verify_bytes(const void* const, const void* const, const int) noexcept;
+    static void xor_bytes(void* const, const void* const, const void* const, const int) noexcept;
 };
 
 }} // namespaces
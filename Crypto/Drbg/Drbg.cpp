@@ -0,0 +1,185 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "Drbg.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+static constexpr int KeySize = 32;
+static constexpr int SeedSize = KeySize + int(sizeof(u64));
+
+// Licznik wywołań fork(), zwiększany w procesie potomnym.
+static std::atomic<u64> fork_generation{1};
+
+static void on_fork_child() {
+    fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+Drbg::~Drbg() {
+    Crypto::clear_bytes(buffer, BufferSize);
+    Crypto::clear_bytes(&counter, sizeof(counter));
+}
+
+/**
+ * @brief local
+ * Generator przypisany do bieżącego wątku.
+ *
+ * @return referencja do generatora wątku.
+ */
+Drbg& Drbg::local() noexcept {
+    static const int registered = pthread_atfork(nullptr, nullptr, on_fork_child);
+    (void)registered;
+    thread_local Drbg drbg;
+    return drbg;
+}
+
+/**
+ * @brief reseed
+ * Zasilenie generatora nowym ziarnem z getrandom.
+ * Jeśli generator był już zainicjowany nowe ziarno jest mieszane
+ * z jego bieżącym stanem.
+ */
+void Drbg::reseed() noexcept {
+    u8 seed[SeedSize];
+    Crypto::system_random_bytes(seed, SeedSize);
+    if (seeded) {
+        u8 mix[SeedSize];
+        keystream(mix, SeedSize);
+        for (int i = 0; i < SeedSize; i++) {
+            seed[i] ^= mix[i];
+        }
+        Crypto::clear_bytes(mix, SeedSize);
+    }
+    cipher.rekey(seed, KeySize);
+    memcpy(&counter, seed + KeySize, sizeof(counter));
+    Crypto::clear_bytes(seed, SeedSize);
+
+    Crypto::clear_bytes(buffer, BufferSize);
+    available = 0;
+    refills = 0;
+    generation = fork_generation.load(std::memory_order_relaxed);
+    seeded = true;
+}
+
+/**
+ * @brief generate
+ * Wygenerowanie wskazanej liczby losowych bajtów.
+ *
+ * @param data - adres bufora na wygenerowane dane.
+ * @param nbytes - liczba bajtów do wygenerowania.
+ */
+void Drbg::generate(void* const data, int nbytes) noexcept {
+    if (!seeded || refills >= ReseedInterval || generation != fork_generation.load(std::memory_order_relaxed)) {
+        reseed();
+    }
+
+    u8* out = static_cast<u8*>(data);
+    if (nbytes >= BufferSize) {
+        // Duże żądania: strumień wprost do bufora użytkownika,
+        // z wymianą klucza co MaxRequestBlocks bloków. Każdy fragment
+        // liczy się do interwału odświeżania jak równoważna liczba
+        // uzupełnień bufora.
+        constexpr int Chunk = int(MaxRequestBlocks) * Gost::BlockSize;
+        while (nbytes >= Gost::BlockSize) {
+            if (refills >= ReseedInterval) {
+                reseed();
+            }
+            const int n = std::min(nbytes - nbytes % Gost::BlockSize, Chunk);
+            keystream(out, n);
+            update_key();
+            refills += u64(n + BufferSize - 1) / BufferSize;
+            out += n;
+            nbytes -= n;
+        }
+    }
+
+    while (nbytes > 0) {
+        if (available == 0) {
+            refill();
+        }
+        const int n = std::min(nbytes, available);
+        u8* const src = buffer + (BufferSize - available);
+        memcpy(out, src, n);
+        Crypto::clear_bytes(src, n);
+        available -= n;
+        out += n;
+        nbytes -= n;
+    }
+}
+
+/**
+ * @brief keystream
+ * Szyfrowanie kolejnych wartości licznika (tryb CTR).
+ *
+ * @param out - bufor na strumień (rozmiar wielokrotnością bloku).
+ * @param nbytes - rozmiar bufora w bajtach.
+ */
+void Drbg::keystream(u8* out, int nbytes) noexcept {
+    u32 block[Gost::BlockSize / sizeof(u32)];
+    for (; nbytes > 0; nbytes -= Gost::BlockSize, out += Gost::BlockSize) {
+        memcpy(block, &counter, sizeof(block));
+        ++counter;
+        cipher.encrypt_block(block, block);
+        memcpy(out, block, std::min(nbytes, Gost::BlockSize));
+    }
+    Crypto::clear_bytes(block, sizeof(block));
+}
+
+/**
+ * @brief update_key
+ * Wymiana klucza na kolejne bajty strumienia. Po wymianie nie da się
+ * odtworzyć wcześniej wygenerowanych danych.
+ */
+void Drbg::update_key() noexcept {
+    u8 key[KeySize];
+    keystream(key, KeySize);
+    cipher.rekey(key, KeySize);
+    Crypto::clear_bytes(key, KeySize);
+}
+
+/**
+ * @brief refill
+ * Uzupełnienie bufora strumieniem i wymiana klucza.
+ */
+void Drbg::refill() noexcept {
+    keystream(buffer, BufferSize);
+    update_key();
+    available = BufferSize;
+    ++refills;
+}
+
+}} // namespaces
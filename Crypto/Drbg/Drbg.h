@@ -0,0 +1,83 @@
+#ifndef BEESOFT_CRYPTO_DRBG_H
+#define BEESOFT_CRYPTO_DRBG_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <cstdint>
+#include "Crypto/Crypto.h"
+#include "Crypto/Gost/Gost.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Drbg
+ * Kryptograficzny generator liczb pseudolosowych (CTR-DRBG) oparty na
+ * szyfrze Gost. Każdy wątek ma własną instancję (@see local), więc
+ * generowanie nie wymaga synchronizacji ani wywołań systemowych.
+ * Generator jest inicjowany i okresowo odświeżany z getrandom,
+ * a po fork() w procesie potomnym jest inicjowany od nowa.
+ * Po każdym uzupełnieniu bufora klucz jest wymieniany (forward secrecy).
+ */
+class Drbg {
+    static constexpr int BufferSize = 4096;                 // in bytes
+    static constexpr u64 ReseedInterval = u64(1) << 14;     // refills between reseeds
+    static constexpr u64 MaxRequestBlocks = u64(1) << 16;   // blocks per one key
+
+    Gost cipher;
+    u64 counter = 0;
+    u64 refills = 0;
+    u64 generation = 0;
+    bool seeded = false;
+    int available = 0;
+    u8 buffer[BufferSize];
+
+public:
+    Drbg() noexcept = default;
+    ~Drbg();
+
+    Drbg(const Drbg&) = delete;
+    Drbg& operator=(const Drbg&) = delete;
+
+    void generate(void* const, int) noexcept;
+    void reseed() noexcept;
+
+    static Drbg& local() noexcept;
+
+private:
+    void keystream(u8*, int) noexcept;
+    void update_key() noexcept;
+    void refill() noexcept;
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_DRBG_H
@@ -32,6 +32,13 @@
 #include <cstring>
 #include "Gost.h"
 #include "Crypto/Crypto.h"
+#include "Crypto/Async/Async.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Modes/Cfb.h"
+#include "Crypto/Modes/Cmac.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Modes/Ecb.h"
+#include "Crypto/Modes/Ofb.h"
 
 /*------- namespaces:
 -------------------------------------------------------------------*/
@@ -39,43 +46,119 @@ namespace beesoft {
 namespace crypto {
 using namespace std;
 
-static constexpr int BlockSize = 8;
 static constexpr int KeySize = 32;  // in bytes (= 8xu32)
 
+/**
+ * Tablice S-box połączone parami w tablice 8-bitowe.
+ * Nie zależą od klucza, więc są wspólne dla wszystkich kontekstów
+ * i wyznaczane w czasie kompilacji.
+ */
+struct SBoxes {
+    u8 k87[256];
+    u8 k65[256];
+    u8 k43[256];
+    u8 k21[256];
+};
+
+static constexpr SBoxes make_sboxes() noexcept {
+    constexpr u8 k8[16] = {14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7};
+    constexpr u8 k7[16] = {15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10};
+    constexpr u8 k6[16] = {10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8};
+    constexpr u8 k5[16] = {7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15};
+    constexpr u8 k4[16] = {2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9};
+    constexpr u8 k3[16] = {12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11};
+    constexpr u8 k2[16] = {4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1};
+    constexpr u8 k1[16] = {13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7};
+
+    SBoxes t{};
+    for (int i = 0; i < 256; i++) {
+        const int p1 = i >> 4;
+        const int p2 = i & 15;
+        t.k87[i] = u8((k8[p1] << 4) | k7[p2]);
+        t.k65[i] = u8((k6[p1] << 4) | k5[p2]);
+        t.k43[i] = u8((k4[p1] << 4) | k3[p2]);
+        t.k21[i] = u8((k2[p1] << 4) | k1[p2]);
+    }
+    return t;
+}
 
+alignas(CacheLineSize) static constexpr SBoxes sbox = make_sboxes();
+
+
+/**
+ * @brief Gost
+ * Konstruktor kontekstu bez klucza (np. dla puli kontekstów).
+ * Przed użyciem kontekst musi zostać zainicjowany kluczem (@see rekey).
+ */
+Gost::Gost() noexcept : k{}
+{}
+
+/**
+ * @brief Gost
+ * Konstruktor z kluczem.
+ *
+ * @param user_key - klucz od użytkownika.
+ * @param key_size - rozmiar klucza w bajtach (musi wynosić 32).
+ */
 Gost::Gost(const void* const user_key, const int key_size) {
+    rekey(user_key, key_size);
+}
+
+Gost::~Gost() {
+    clear();
+}
+
+/**
+ * @brief Gost
+ * Konstruktor przenoszący. Kontekst źródłowy zostaje wyczyszczony.
+ *
+ * @param other - kontekst źródłowy.
+ */
+Gost::Gost(Gost&& other) noexcept {
+    memcpy(k, other.k, sizeof(k));
+    other.clear();
+}
+
+/**
+ * @brief operator=
+ * Przypisanie przenoszące. Kontekst źródłowy zostaje wyczyszczony.
+ *
+ * @param other - kontekst źródłowy.
+ * @return referencja do tego kontekstu.
+ */
+Gost& Gost::operator=(Gost&& other) noexcept {
+    if (this != &other) {
+        memcpy(k, other.k, sizeof(k));
+        other.clear();
+    }
+    return *this;
+}
+
+/**
+ * @brief rekey
+ * Inicjalizacja kontekstu (w miejscu) nowym kluczem.
+ *
+ * @param user_key - klucz od użytkownika.
+ * @param key_size - rozmiar klucza w bajtach (musi wynosić 32).
+ * @return true jeśli klucz został ustawiony, false przy błędnym rozmiarze klucza.
+ */
+bool Gost::rekey(const void* const user_key, const int key_size) noexcept {
     if (key_size != KeySize) {
         cerr << "Error (blowfish): invalid key size" << endl;
-        return;
+        return false;
     }
 
-    static const u8 k8[16] = {14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7};
-    static const u8 k7[16] = {15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10};
-    static const u8 k6[16] = {10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8};
-    static const u8 k5[16] = {7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15};
-    static const u8 k4[16] = {2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9};
-    static const u8 k3[16] = {12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11};
-    static const u8 k2[16] = {4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1};
-    static const u8 k1[16] = {13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7};
-
+    // tablice S-box są wspólne (@see sbox), kontekst to tylko klucz
     memcpy(k, user_key, KeySize);
-
-    for (int i = 0; i < 256; i++) {
-        const int p1 = i >> 4;
-        const int p2 = i & 15;
-        k87[i] = (k8[p1] << 4) | k7[p2];
-        k65[i] = (k6[p1] << 4) | k5[p2];
-        k43[i] = (k4[p1] << 4) | k3[p2];
-        k21[i] = (k2[p1] << 4) | k1[p2];
-    }
+    return true;
 }
 
-Gost::~Gost() {
+/**
+ * @brief clear
+ * Bezpieczne wyczyszczenie kontekstu.
+ */
+void Gost::clear() noexcept {
     Crypto::clear_bytes(k, 8 * sizeof(u32));
-    Crypto::clear_bytes(k87, 256);
-    Crypto::clear_bytes(k65, 256);
-    Crypto::clear_bytes(k43, 256);
-    Crypto::clear_bytes(k21, 256);
 }
 
 /**
@@ -84,65 +167,58 @@ Gost::~Gost() {
  * jako parametr to zostanie losowo wygenerowany.
  * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
  * Jeśli rozmiar jawnych danych nie jest wielokrotnością rozmiaru bloku
- * zostanie uzupełniony o tzw. padding.
+ * zostanie uzupełniony o tzw. padding (lub, dla Padding::Cts,
+ * zastosowana zostanie kradzież szyfrogramu).
  *
  * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
  * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
  * @param iv - adres wektor IV (może być nullptr).
- * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu.
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 gdy danych nie można uzupełnić wskazanym paddingiem).
  */
 std::tuple<std::shared_ptr<void>, int>
-Gost::encrypt_cbc(const void* const data, const int nbytes, void* iv) const noexcept {
+Gost::encrypt_cbc(const void* const data, const int nbytes, void* iv, const Padding padding) const noexcept {
 
     if (data == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
 
-    bool custom_iv = false;
+    u8 random_iv[BlockSize];
     if (iv == nullptr) {
         // Jeśli funkcja wywołująca nie przekazała wektora IV
         // sami generujemy go losowo.
-        iv = new u8[BlockSize];
-        Crypto::random_bytes(iv, BlockSize);
-        custom_iv = true;
+        Crypto::random_bytes(random_iv, BlockSize);
+        iv = random_iv;
     }
 
-    u8* plain = nullptr;
-    int size = nbytes;
-    const int n = size % BlockSize;
-    if (n) {
-        // Ponieważ rozmiar bufora danych do zaszyfrownia
-        // nie jest wielokrotnością bloku dodajemy padding
-        // o stosownej długości.
-        const int dn = BlockSize - n;
-        plain = new u8[size + dn];
-        memcpy(plain, data, size);
-        bzero(plain + size, dn);
-        plain[size] = 128;
-        size += dn;
-    } else {
-        plain = new u8[size];
-        memcpy(plain, data, size);
+    if (padding == Padding::Cts) {
+        return Cbc<Gost>::encrypt_cts(*this, data, nbytes, iv);
     }
 
+    const int size = Crypto::padded_size(nbytes, BlockSize, padding);
+    if (size < 0) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
+
+    // Szyfrowanie w miejscu, w buforze wynikowym (za wektorem IV).
     u8* const cipher = new u8[size + BlockSize];
+    memcpy(cipher, iv, BlockSize);
+    memcpy(cipher + BlockSize, data, nbytes);
+    Crypto::pad(cipher + BlockSize, nbytes, BlockSize, padding);
 
-    u32* src = reinterpret_cast<u32*>(plain);
-    u32* dst = reinterpret_cast<u32*>(cipher);
-    memcpy(dst, iv, BlockSize);
+    const u32* prv = reinterpret_cast<const u32*>(cipher);
+    u32* dst = reinterpret_cast<u32*>(cipher + BlockSize);
 
     u32 tmp[2];
     for (int i = 0; i < (size/BlockSize); i++) {
-        tmp[0] = src[0] ^ dst[0];
-        tmp[1] = src[1] ^ dst[1];
-        dst += 2;
+        tmp[0] = dst[0] ^ prv[0];
+        tmp[1] = dst[1] ^ prv[1];
         encrypt_block(tmp, dst);
-        src += 2;
+        prv = dst;
+        dst += 2;
     }
 
-    if (custom_iv) delete[] static_cast<u8*>(iv);
-    delete[] plain;
-
     return make_tuple(shared_ptr<void>(cipher, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size + BlockSize);
 }
 
@@ -154,79 +230,312 @@ Gost::encrypt_cbc(const void* const data, const int nbytes, void* iv) const noex
  *
  * @param data - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
  * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
- * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
  */
 std::tuple<std::shared_ptr<void>, int>
-Gost::decrypt_cbc(const void* const cipher, int nbytes) const noexcept {
+Gost::decrypt_cbc(const void* const cipher, int nbytes, const Padding padding) const noexcept {
 
     if (cipher == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
+    if (padding == Padding::Cts) {
+        return Cbc<Gost>::decrypt_cts(*this, cipher, nbytes);
+    }
+    if (nbytes % BlockSize) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
 
     nbytes -= BlockSize;
     u8* const plain  = new u8[nbytes];
-    bzero(plain, nbytes);
-
-    const u32* src = reinterpret_cast<const u32*>(cipher);
-    u32* dst = reinterpret_cast<u32*>(plain);
-
-    for (int i = 0; i < (nbytes/BlockSize); i++) {
-        decrypt_block(src + 2, dst);
 
-        dst[0] = dst[0] ^ src[0];
-        dst[1] = dst[1] ^ src[1];
-        dst += 2;
-        src += 2;
-    }
+    // bloki są niezależne: duże dane deszyfrowane równolegle, padding tylko w ostatnim bloku
+    Cbc<Gost>::decrypt_chain(*this, cipher, nbytes/BlockSize, plain);
 
-    if (const int idx = Crypto::padding_index(plain, nbytes); idx != -1) {
-        nbytes = idx;
+    nbytes = Crypto::unpad(plain, nbytes, BlockSize, padding);
+    if (nbytes < 0) {
+        delete[] plain;
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
     return make_tuple(shared_ptr<void>(plain, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes);
 }
 
+/**
+ * @brief encrypt_cbc
+ * Szyfrowanie w trybie CBC danych rozproszonych w segmentach (jak writev).
+ * Łańcuch CBC i niepełne bloki przechodzą przez granice segmentów.
+ * @see Cbc::encrypt_segments
+ *
+ * @param in - segmenty z jawnymi danymi.
+ * @param in_count - liczba segmentów wejściowych.
+ * @param out - segmenty na zaszyfrowane dane (IV + dane z paddingiem).
+ * @param out_count - liczba segmentów wyjściowych.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+ * @return liczba zapisanych bajtów lub -1 przy błędzie.
+ */
+int Gost::encrypt_cbc(const iovec* const in, const int in_count,
+                       const iovec* const out, const int out_count, const void* const iv,
+                       const Padding padding) const noexcept {
+    return Cbc<Gost>::encrypt_segments(*this, in, in_count, out, out_count, iv, padding);
+}
+
+/**
+ * @brief decrypt_cbc
+ * Deszyfrowanie w trybie CBC danych rozproszonych w segmentach (jak readv).
+ * @see Cbc::decrypt_segments
+ *
+ * @param in - segmenty z zaszyfrowanymi danymi (IV + dane).
+ * @param in_count - liczba segmentów wejściowych.
+ * @param out - segmenty na odszyfrowane dane.
+ * @param out_count - liczba segmentów wyjściowych.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return liczba odszyfrowanych bajtów lub -1 przy błędzie.
+ */
+int Gost::decrypt_cbc(const iovec* const in, const int in_count,
+                       const iovec* const out, const int out_count, const Padding padding) const noexcept {
+    return Cbc<Gost>::decrypt_segments(*this, in, in_count, out, out_count, padding);
+}
+
+/**
+ * @brief decrypt_cbc_range
+ * Odszyfrowanie w trybie CBC tylko fragmentu jawnych danych
+ * (bez deszyfrowania całego bufora).
+ * @see Cbc::decrypt_range
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi (IV + dane).
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @param offset - pozycja początku fragmentu w jawnych danych.
+ * @param length - długość fragmentu w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z fragmentem + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::decrypt_cbc_range(const void* const cipher, const int nbytes, const int offset, const int length, const Padding padding) const noexcept {
+    return Cbc<Gost>::decrypt_range(*this, cipher, nbytes, offset, length, padding);
+}
+
+/**
+ * @brief encrypt_cbc_async
+ * Szyfrowanie w trybie CBC w puli wątków biblioteki.
+ * Dane i kontekst szyfru muszą istnieć do zakończenia zadania.
+ * @see Async::encrypt_cbc
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektora IV (może być nullptr).
+ * @param padding - rodzaj paddingu.
+ * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+ * @param cancellation - znacznik anulowania zadania.
+ * @return - future z wynikiem jak w encrypt_cbc ((nullptr, -1) po anulowaniu).
+ */
+std::future<AsyncResult>
+Gost::encrypt_cbc_async(const void* const data, const int nbytes, const void* const iv, const Padding padding,
+                        AsyncCallback callback, const Cancellation cancellation) const {
+    return Async<Gost>::encrypt_cbc(*this, data, nbytes, iv, padding, move(callback), cancellation);
+}
+
+/**
+ * @brief decrypt_cbc_async
+ * Deszyfrowanie w trybie CBC w puli wątków biblioteki.
+ * Dane i kontekst szyfru muszą istnieć do zakończenia zadania.
+ * @see Async::decrypt_cbc
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi (IV + dane).
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+ * @param cancellation - znacznik anulowania zadania.
+ * @return - future z wynikiem jak w decrypt_cbc ((nullptr, -1) po anulowaniu).
+ */
+std::future<AsyncResult>
+Gost::decrypt_cbc_async(const void* const cipher, const int nbytes, const Padding padding,
+                        AsyncCallback callback, const Cancellation cancellation) const {
+    return Async<Gost>::decrypt_cbc(*this, cipher, nbytes, padding, move(callback), cancellation);
+}
+
+/**
+ * @brief encrypt_ctr
+ * Szyfrowanie w trybie CTR (bez paddingu). Jeśli IV nie został przekazany
+ * jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Ctr
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::encrypt_ctr(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Ctr<Gost>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_ctr
+ * Deszyfrowanie w trybie CTR (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::decrypt_ctr(const void* const cipher, const int nbytes) const noexcept {
+    return Ctr<Gost>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief crypt_ctr
+ * Szyfrowanie/odszyfrowanie w trybie CTR fragmentu danych zaczynającego
+ * się od dowolnego bajtu strumienia (swobodny dostęp).
+ *
+ * @param iv - wartość początkowa licznika.
+ * @param offset - pozycja pierwszego bajtu w strumieniu.
+ * @param src - adres danych wejściowych.
+ * @param dst - adres bufora wynikowego (może być równy src).
+ * @param nbytes - liczba bajtów.
+ */
+void Gost::crypt_ctr(const void* const iv, const u64 offset, const void* const src, void* const dst, const int nbytes) const noexcept {
+    Ctr<Gost>::crypt(*this, iv, offset, src, dst, nbytes);
+}
+
+/**
+ * @brief encrypt_cfb
+ * Szyfrowanie w trybie pełnoblokowym CFB (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Cfb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::encrypt_cfb(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Cfb<Gost>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_cfb
+ * Deszyfrowanie w trybie pełnoblokowym CFB (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::decrypt_cfb(const void* const cipher, const int nbytes) const noexcept {
+    return Cfb<Gost>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief encrypt_cfb8
+ * Szyfrowanie w trybie 8-bitowym CFB (CFB8) (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Cfb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::encrypt_cfb8(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Cfb<Gost>::encrypt(*this, data, nbytes, iv, 1);
+}
+
+/**
+ * @brief decrypt_cfb8
+ * Deszyfrowanie w trybie 8-bitowym CFB (CFB8) (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::decrypt_cfb8(const void* const cipher, const int nbytes) const noexcept {
+    return Cfb<Gost>::decrypt(*this, cipher, nbytes, 1);
+}
+
+/**
+ * @brief encrypt_ofb
+ * Szyfrowanie w trybie OFB (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Ofb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::encrypt_ofb(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Ofb<Gost>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_ofb
+ * Deszyfrowanie w trybie OFB (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Gost::decrypt_ofb(const void* const cipher, const int nbytes) const noexcept {
+    return Ofb<Gost>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief cmac
+ * Wyznaczenie kodu uwierzytelniającego CMAC danych.
+ * @see Cmac
+ *
+ * @param data - adres danych.
+ * @param nbytes - rozmiar danych w bajtach.
+ * @param tag - adres bufora na znacznik (BlockSize bajtów).
+ */
+void Gost::cmac(const void* const data, const int nbytes, void* const tag) const noexcept {
+    Cmac<Gost>::compute(*this, data, nbytes, tag);
+}
+
 /**
  * @brief encrypt_ecb
  * Szyfrowanie w trybie ECB.
  * Jeśli rozmiar jawnych danych nie jest wielokrotnością rozmiaru bloku
  * zostanie uzupełniony o tzw. padding.
+ * Duże dane są szyfrowane wielowątkowo (@see Ecb).
  *
  * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
  * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
- * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu (Cts nie jest obsługiwany w ECB).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 gdy danych nie można uzupełnić wskazanym paddingiem).
  */
 std::tuple<shared_ptr<void>, int>
-Gost::encrypt_ecb(const void* const data, const int nbytes) const noexcept {
+Gost::encrypt_ecb(const void* const data, const int nbytes, const Padding padding) const noexcept {
 
     if (data == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
 
-    int size = nbytes;
-    const int n = size % BlockSize;
-    u8* const plain = new u8[size + n];
-    memcpy(plain, data, size);
-    if (n) {
-        // Ponieważ rozmiar bufora danych do zaszyfrownia
-        // nie jest wielokrotnością bloku dodajemy padding
-        // o stosownej długości.
-        bzero(plain + size, n);
-        plain[size] = 128;
-        size += n;
+    const int size = (padding == Padding::Cts) ? -1 : Crypto::padded_size(nbytes, BlockSize, padding);
+    if (size < 0) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
 
+    // Szyfrowanie w miejscu, w buforze wynikowym.
     u8* const cipher = new u8[size];
+    memcpy(cipher, data, nbytes);
+    Crypto::pad(cipher, nbytes, BlockSize, padding);
 
-    u32* src = reinterpret_cast<u32*>(plain);
-    u32* dst = reinterpret_cast<u32*>(cipher);
-
-    for (int i = 0; i < (size/BlockSize); i++) {
-        encrypt_block(src, dst);
-        src += 2;
-        dst += 2;
-    }
+    u32* const dst = reinterpret_cast<u32*>(cipher);
+    Ecb<Gost>::encrypt(*this, dst, dst, size/BlockSize);
 
-    delete[] plain;
     return make_tuple(shared_ptr<void>(cipher, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
 }
 
@@ -237,33 +546,35 @@ Gost::encrypt_ecb(const void* const data, const int nbytes) const noexcept {
  *
  * @param data - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
  * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
- * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
  */
 std::tuple<std::shared_ptr<void>, int>
-Gost::decrypt_ecb(const void* const cipher, int nbytes) const noexcept {
+Gost::decrypt_ecb(const void* const cipher, int nbytes, const Padding padding) const noexcept {
 
     if (cipher == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
+    if (nbytes % BlockSize || padding == Padding::Cts) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
 
     u8* const plain  = new u8[nbytes];
-    bzero(plain, nbytes);
-
-    const u32* src = reinterpret_cast<const u32*>(cipher);
-    u32* dst = reinterpret_cast<u32*>(plain);
 
-    for (int i = 0; i < (nbytes/BlockSize); i++) {
-        decrypt_block(src, dst);
-        src += 2;
-        dst += 2;
-    }
+    const u32* const src = reinterpret_cast<const u32*>(cipher);
+    u32* const dst = reinterpret_cast<u32*>(plain);
+    Ecb<Gost>::decrypt(*this, src, dst, nbytes/BlockSize);
 
-    if (const int idx = Crypto::padding_index(plain, nbytes); idx != -1) {
-        nbytes = idx;
+    nbytes = Crypto::unpad(plain, nbytes, BlockSize, padding);
+    if (nbytes < 0) {
+        delete[] plain;
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
     return make_tuple(shared_ptr<void>(plain, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes);
 }
 
+
 /**
  * @brief encrypt_block
  * Szyfrowanie bloku (2xu32) jawnych danych.
@@ -366,11 +677,168 @@ void Gost::decrypt_block(const u32* const src, u32* const dst) const noexcept {
     dst[1] = n1;
 }
 
-inline u32 Gost::f(const u32 x) const noexcept {
-    const auto w0 = u32(k87[(x >> 24) & 0xff]) << 24;
-    const auto w1 = u32(k65[(x >> 16) & 0xff]) << 16;
-    const auto w2 = u32(k43[(x >>  8) & 0xff]) <<  8;
-    const auto w3 = u32(k21[x & 0xff]);
+/**
+ * @brief encrypt_blocks
+ * Szyfrowanie wielu niezależnych bloków (tryb ECB bez paddingu).
+ * Bloki są przetwarzane po Lanes jednocześnie - rundy kolejnych bloków
+ * przeplatają się, co pozwala procesorowi wykonywać je równolegle.
+ * Bufory mogą być tym samym buforem (szyfrowanie w miejscu).
+ *
+ * @param src - adres bufora z jawnymi blokami.
+ * @param dst - adres bufora na zaszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Gost::encrypt_blocks(const u32* src, u32* dst, int nblocks) const noexcept {
+    for (; nblocks >= Lanes; nblocks -= Lanes, src += 2 * Lanes, dst += 2 * Lanes) {
+        u32 n1[Lanes];
+        u32 n2[Lanes];
+        for (int l = 0; l < Lanes; l++) {
+            n1[l] = src[2*l];
+            n2[l] = src[2*l + 1];
+        }
+        for (int r = 0; r < 3; r++) {
+            for (int i = 0; i < 8; i += 2) {
+                for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[i]);
+                for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[i+1]);
+            }
+        }
+        for (int i = 7; i > 0; i -= 2) {
+            for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[i]);
+            for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[i-1]);
+        }
+        for (int l = 0; l < Lanes; l++) {
+            dst[2*l] = n2[l];
+            dst[2*l + 1] = n1[l];
+        }
+    }
+    for (; nblocks > 0; nblocks--, src += 2, dst += 2) {
+        encrypt_block(src, dst);
+    }
+}
+
+/**
+ * @brief decrypt_blocks
+ * Odszyfrowanie wielu niezależnych bloków (@see encrypt_blocks).
+ *
+ * @param src - adres bufora z zaszyfrowanymi blokami.
+ * @param dst - adres bufora na odszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Gost::decrypt_blocks(const u32* src, u32* dst, int nblocks) const noexcept {
+    for (; nblocks >= Lanes; nblocks -= Lanes, src += 2 * Lanes, dst += 2 * Lanes) {
+        u32 n1[Lanes];
+        u32 n2[Lanes];
+        for (int l = 0; l < Lanes; l++) {
+            n1[l] = src[2*l];
+            n2[l] = src[2*l + 1];
+        }
+        for (int i = 0; i < 8; i += 2) {
+            for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[i]);
+            for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[i+1]);
+        }
+        for (int r = 0; r < 3; r++) {
+            for (int i = 7; i > 0; i -= 2) {
+                for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[i]);
+                for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[i-1]);
+            }
+        }
+        for (int l = 0; l < Lanes; l++) {
+            dst[2*l] = n2[l];
+            dst[2*l + 1] = n1[l];
+        }
+    }
+    for (; nblocks > 0; nblocks--, src += 2, dst += 2) {
+        decrypt_block(src, dst);
+    }
+}
+
+/**
+ * @brief encrypt_multikey
+ * Szyfrowanie bloków, z których każdy ma własny klucz (blok i kontekstem
+ * contexts[i]). Klucz Gost to tylko 8 słów, a tablice S-box są wspólne,
+ * więc bloki pod różnymi kluczami są przetwarzane po Lanes jednocześnie
+ * (jak w encrypt_blocks), każdy tor z własnymi słowami klucza.
+ * Bufory mogą być tym samym buforem (szyfrowanie w miejscu).
+ *
+ * @param contexts - tablica kontekstów (nblocks elementów).
+ * @param src - adres bufora z jawnymi blokami.
+ * @param dst - adres bufora na zaszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Gost::encrypt_multikey(const Gost* const* contexts, const u32* src, u32* dst, int nblocks) noexcept {
+    for (; nblocks >= Lanes; nblocks -= Lanes, contexts += Lanes, src += 2 * Lanes, dst += 2 * Lanes) {
+        const u32* k[Lanes];
+        u32 n1[Lanes];
+        u32 n2[Lanes];
+        for (int l = 0; l < Lanes; l++) {
+            k[l] = contexts[l]->k;
+            n1[l] = src[2*l];
+            n2[l] = src[2*l + 1];
+        }
+        for (int r = 0; r < 3; r++) {
+            for (int i = 0; i < 8; i += 2) {
+                for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[l][i]);
+                for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[l][i+1]);
+            }
+        }
+        for (int i = 7; i > 0; i -= 2) {
+            for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[l][i]);
+            for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[l][i-1]);
+        }
+        for (int l = 0; l < Lanes; l++) {
+            dst[2*l] = n2[l];
+            dst[2*l + 1] = n1[l];
+        }
+    }
+    for (; nblocks > 0; nblocks--, contexts++, src += 2, dst += 2) {
+        (*contexts)->encrypt_block(src, dst);
+    }
+}
+
+/**
+ * @brief decrypt_multikey
+ * Odszyfrowanie bloków, z których każdy ma własny klucz (@see encrypt_multikey).
+ *
+ * @param contexts - tablica kontekstów (nblocks elementów).
+ * @param src - adres bufora z zaszyfrowanymi blokami.
+ * @param dst - adres bufora na odszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Gost::decrypt_multikey(const Gost* const* contexts, const u32* src, u32* dst, int nblocks) noexcept {
+    for (; nblocks >= Lanes; nblocks -= Lanes, contexts += Lanes, src += 2 * Lanes, dst += 2 * Lanes) {
+        const u32* k[Lanes];
+        u32 n1[Lanes];
+        u32 n2[Lanes];
+        for (int l = 0; l < Lanes; l++) {
+            k[l] = contexts[l]->k;
+            n1[l] = src[2*l];
+            n2[l] = src[2*l + 1];
+        }
+        for (int i = 0; i < 8; i += 2) {
+            for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[l][i]);
+            for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[l][i+1]);
+        }
+        for (int r = 0; r < 3; r++) {
+            for (int i = 7; i > 0; i -= 2) {
+                for (int l = 0; l < Lanes; l++) n2[l] ^= f(n1[l] + k[l][i]);
+                for (int l = 0; l < Lanes; l++) n1[l] ^= f(n2[l] + k[l][i-1]);
+            }
+        }
+        for (int l = 0; l < Lanes; l++) {
+            dst[2*l] = n2[l];
+            dst[2*l + 1] = n1[l];
+        }
+    }
+    for (; nblocks > 0; nblocks--, contexts++, src += 2, dst += 2) {
+        (*contexts)->decrypt_block(src, dst);
+    }
+}
+
+inline u32 Gost::f(const u32 x) noexcept {
+    const auto w0 = u32(sbox.k87[(x >> 24) & 0xff]) << 24;
+    const auto w1 = u32(sbox.k65[(x >> 16) & 0xff]) << 16;
+    const auto w2 = u32(sbox.k43[(x >>  8) & 0xff]) <<  8;
+    const auto w3 = u32(sbox.k21[x & 0xff]);
 
     const u32 w = w0|w1|w2|w3;
     return (w << 11) | (w >> (32 - 11));
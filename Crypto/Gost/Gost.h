@@ -32,9 +32,11 @@
 /*------- include files:
 -------------------------------------------------------------------*/
 #include <cstdint>
+#include <sys/uio.h>
 #include <memory>
 #include <tuple>
 #include "Crypto/Crypto.h"
+#include "Crypto/Async/AsyncTypes.h"
 
 /*------- namespaces:
 -------------------------------------------------------------------*/
@@ -44,28 +46,58 @@ namespace crypto {
 /*------- types:
 -------------------------------------------------------------------*/
 
-class Gost {
+class alignas(CacheLineSize) Gost {
      u32 k[8];
-     u8  k87[256];
-     u8  k65[256];
-     u8  k43[256];
-     u8  k21[256];
 
 public:
+    static constexpr int Lanes = 4;        // blocks per multi-block kernel step
+    static constexpr int BlockSize = 8;    // in bytes
+
+    Gost() noexcept;
     Gost(const void* const, const int);
     ~Gost();
 
-    std::tuple<std::shared_ptr<void>, int> encrypt_cbc(const void* const, const int, void* = nullptr) const noexcept;
-    std::tuple<std::shared_ptr<void>, int> decrypt_cbc(const void* const, int) const noexcept;
+    Gost(const Gost&) = delete;
+    Gost& operator=(const Gost&) = delete;
+    Gost(Gost&&) noexcept;
+    Gost& operator=(Gost&&) noexcept;
+
+    bool rekey(const void* const, const int) noexcept;
+    void clear() noexcept;
+
+    std::tuple<std::shared_ptr<void>, int> encrypt_cbc(const void* const, const int, void* = nullptr, const Padding = Padding::Iso7816) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cbc(const void* const, int, const Padding = Padding::Iso7816) const noexcept;
+    int encrypt_cbc(const iovec* const, const int, const iovec* const, const int, const void* const = nullptr, const Padding = Padding::Iso7816) const noexcept;
+    int decrypt_cbc(const iovec* const, const int, const iovec* const, const int, const Padding = Padding::Iso7816) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cbc_range(const void* const, const int, const int, const int, const Padding = Padding::Iso7816) const noexcept;
+    std::future<AsyncResult> encrypt_cbc_async(const void* const, const int, const void* const = nullptr, const Padding = Padding::Iso7816, AsyncCallback = {}, const Cancellation = {}) const;
+    std::future<AsyncResult> decrypt_cbc_async(const void* const, const int, const Padding = Padding::Iso7816, AsyncCallback = {}, const Cancellation = {}) const;
+
+    std::tuple<std::shared_ptr<void>, int> encrypt_ctr(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_ctr(const void* const, const int) const noexcept;
+    void crypt_ctr(const void* const, const u64, const void* const, void* const, const int) const noexcept;
+
+    std::tuple<std::shared_ptr<void>, int> encrypt_cfb(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cfb(const void* const, const int) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> encrypt_cfb8(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cfb8(const void* const, const int) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> encrypt_ofb(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_ofb(const void* const, const int) const noexcept;
+
+    void cmac(const void* const, const int, void* const) const noexcept;
 
-    std::tuple<std::shared_ptr<void>, int> encrypt_ecb(const void* const, const int) const noexcept;
-    std::tuple<std::shared_ptr<void>, int> decrypt_ecb(const void* const, int) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> encrypt_ecb(const void* const, const int, const Padding = Padding::Iso7816) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_ecb(const void* const, int, const Padding = Padding::Iso7816) const noexcept;
 
     void encrypt_block(const u32* const, u32* const) const noexcept;
     void decrypt_block(const u32* const, u32* const) const noexcept;
+    void encrypt_blocks(const u32*, u32*, int) const noexcept;
+    void decrypt_blocks(const u32*, u32*, int) const noexcept;
+    static void encrypt_multikey(const Gost* const*, const u32*, u32*, int) noexcept;
+    static void decrypt_multikey(const Gost* const*, const u32*, u32*, int) noexcept;
 
 private:
-    u32 f(const u32) const noexcept;
+    static u32 f(const u32) noexcept;
 };
 
 }} // namespaces
@@ -0,0 +1,212 @@
+#ifndef BEESOFT_CRYPTO_MODES_CASCADE_H
+#define BEESOFT_CRYPTO_MODES_CASCADE_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Cascade
+ * Kaskada szyfrów (np. Blowfish -> Gost -> Way3), każdy w trybie CBC
+ * z własnym IV. Dane są uzupełniane paddingiem PKCS#7 raz, do
+ * wielokrotności NWW rozmiarów bloków wszystkich szyfrów (8 i 12 -> 24),
+ * więc każdy etap przetwarza całe bloki.
+ * Dane są przetwarzane fragmentami rozmiaru L1 (TileSize) w miejscu,
+ * w buforze wynikowym: fragment przechodzi przez wszystkie etapy zanim
+ * zostanie pobrany następny; stan łańcucha CBC każdego etapu jest
+ * przenoszony między fragmentami. Nie ma buforów pośrednich pełnego rozmiaru.
+ * Format wyniku: IV etapu 1 || ... || IV etapu N || szyfrogram.
+ * Konteksty szyfrów muszą istnieć przez cały czas życia obiektu.
+ */
+template<typename... Ciphers>
+class Cascade {
+    static_assert(sizeof...(Ciphers) > 0, "Cascade: no ciphers");
+
+    static constexpr int alignment() noexcept {
+        int n = 1;
+        ((n = std::lcm(n, Ciphers::BlockSize)), ...);
+        return n;
+    }
+
+public:
+    static constexpr int Stages = int(sizeof...(Ciphers));
+    static constexpr int Alignment = alignment();                   // wspólna wielokrotność bloków
+    static constexpr int HeaderSize = (Ciphers::BlockSize + ...);   // wszystkie IV
+
+private:
+    static constexpr int TileSize = (16 * 1024 / Alignment) * Alignment;
+    static constexpr int BlockSizes[Stages] = {Ciphers::BlockSize...};
+
+    std::tuple<const Ciphers&...> stages;
+
+public:
+    explicit Cascade(const Ciphers&... ciphers) noexcept : stages(ciphers...) {}
+
+    /**
+     * @brief encrypt
+     * Szyfrowanie kaskadowe. Jeśli wektory IV nie zostały przekazane
+     * to zostaną losowo wygenerowane.
+     *
+     * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+     * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+     * @param ivs - adres wektorów IV kolejnych etapów (HeaderSize bajtów; może być nullptr).
+     * @return - tuple: adres bufora (IV + zaszyfrowane dane) + jego rozmiar w bajtach.
+     */
+    std::tuple<std::shared_ptr<void>, int>
+    encrypt(const void* const data, const int nbytes, const void* const ivs = nullptr) const noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        const int padded = Crypto::padded_size(nbytes, Alignment, Padding::Pkcs7);
+        const int size = HeaderSize + padded;
+        u8* const out = new u8[size];
+        if (ivs) {
+            memcpy(out, ivs, HeaderSize);
+        } else {
+            Crypto::random_bytes(out, HeaderSize);
+        }
+
+        u32 chains[HeaderSize / sizeof(u32)];
+        memcpy(chains, out, HeaderSize);
+        u8* const body = out + HeaderSize;
+        memcpy(body, data, nbytes);
+        Crypto::pad(body, nbytes, Alignment, Padding::Pkcs7);
+
+        for (int done = 0; done < padded; done += TileSize) {
+            const int n = std::min(TileSize, padded - done);
+            encrypt_tile(body + done, n, chains, std::index_sequence_for<Ciphers...>{});
+        }
+        Crypto::clear_bytes(chains, sizeof(chains));
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie kaskadowe (etapy w odwrotnej kolejności).
+     *
+     * @param data - adres bufora z zaszyfrowanymi danymi (IV + dane).
+     * @param nbytes - rozmiar bufora w bajtach.
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
+     */
+    std::tuple<std::shared_ptr<void>, int>
+    decrypt(const void* const data, const int nbytes) const noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        const int padded = nbytes - HeaderSize;
+        if (padded <= 0 || padded % Alignment) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const u8* const in = static_cast<const u8*>(data);
+        u8* const out = new u8[padded];
+        memcpy(out, in + HeaderSize, padded);
+
+        u32 chains[HeaderSize / sizeof(u32)];
+        memcpy(chains, in, HeaderSize);
+        for (int done = 0; done < padded; done += TileSize) {
+            const int n = std::min(TileSize, padded - done);
+            decrypt_tile(out + done, n, chains, std::index_sequence_for<Ciphers...>{});
+        }
+        Crypto::clear_bytes(chains, sizeof(chains));
+
+        const int size = Crypto::unpad(out, padded, Alignment, Padding::Pkcs7);
+        if (size < 0) {
+            Crypto::clear_bytes(out, padded);
+            delete[] out;
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+private:
+    /// Pozycja (w słowach) łańcucha CBC etapu w tablicy chains.
+    static constexpr int chain_offset(const int stage) noexcept {
+        int n = 0;
+        for (int i = 0; i < stage; i++) {
+            n += BlockSizes[i];
+        }
+        return n / int(sizeof(u32));
+    }
+
+    template<size_t... I>
+    void encrypt_tile(u8* const tile, const int n, u32* const chains, std::index_sequence<I...>) const noexcept {
+        (encrypt_stage(std::get<I>(stages), tile, n, chains + chain_offset(int(I))), ...);
+    }
+
+    template<size_t... I>
+    void decrypt_tile(u8* const tile, const int n, u32* const chains, std::index_sequence<I...>) const noexcept {
+        (decrypt_stage(std::get<Stages - 1 - I>(stages), tile, n, chains + chain_offset(Stages - 1 - int(I))), ...);
+    }
+
+    template<typename Cipher>
+    static void encrypt_stage(const Cipher& cipher, u8* tile, const int n, u32* const chain) noexcept {
+        constexpr int BlockSize = Cipher::BlockSize;
+        for (int i = 0; i < n; i += BlockSize, tile += BlockSize) {
+            Crypto::xor_bytes(chain, chain, tile, BlockSize);
+            cipher.encrypt_block(chain, chain);
+            memcpy(tile, chain, BlockSize);
+        }
+    }
+
+    template<typename Cipher>
+    static void decrypt_stage(const Cipher& cipher, u8* const tile, const int n, u32* const chain) noexcept {
+        constexpr int BlockSize = Cipher::BlockSize;
+        u32 scratch[TileSize / sizeof(u32)];
+        const int nblocks = n / BlockSize;
+        memcpy(scratch, tile, n);
+        cipher.decrypt_blocks(scratch, scratch, nblocks);
+
+        // od końca, bo poprzedni blok szyfrogramu jest potrzebny do XOR
+        u32 next[BlockSize / sizeof(u32)];
+        memcpy(next, tile + n - BlockSize, BlockSize);
+        const u8* const s = reinterpret_cast<const u8*>(scratch);
+        for (int i = nblocks - 1; i > 0; i--) {
+            Crypto::xor_bytes(tile + i * BlockSize, s + i * BlockSize, tile + (i - 1) * BlockSize, BlockSize);
+        }
+        Crypto::xor_bytes(tile, s, chain, BlockSize);
+        memcpy(chain, next, BlockSize);
+        Crypto::clear_bytes(scratch, n);
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_CASCADE_H
@@ -0,0 +1,606 @@
+#ifndef BEESOFT_CRYPTO_MODES_CBC_H
+#define BEESOFT_CRYPTO_MODES_CBC_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/Parallel.h"
+#include "Crypto/Segments/Segments.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Cbc
+ * Wspólna (dla wszystkich szyfrów blokowych) implementacja wariantów
+ * trybu CBC. Klasy szyfrów udostępniają te funkcje jako swoje metody.
+ */
+template<typename Cipher>
+class Cbc {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int Grain = Parallel::grain(BlockSize);   // najmniejszy fragment jednego wątku
+    static constexpr int BatchLanes = 2 * Cipher::Lanes;   // łańcuchy w jednym wywołaniu kernela
+
+public:
+    /// Opis wiadomości dla encrypt_batch.
+    struct Job {
+        const void* data;   // jawne dane
+        int nbytes;         // rozmiar jawnych danych
+        const void* iv;     // wektor IV (nullptr: losowy)
+        void* out;          // bufor na IV + szyfrogram (BlockSize + padded_size bajtów)
+        int size;           // wynik: rozmiar IV + szyfrogramu (0 dla pustych danych, -1 przy błędzie)
+    };
+
+    /**
+     * @brief encrypt_segments
+     * Szyfrowanie w trybie CBC danych rozproszonych w wielu segmentach
+     * (jak readv/writev). Łańcuch CBC i niepełne bloki są przenoszone
+     * przez granice segmentów, dane nie są łączone w jeden bufor.
+     * Wynik ma postać identyczną z encrypt_cbc (IV + zaszyfrowane dane).
+     * Segmenty wejściowe i wyjściowe nie mogą na siebie zachodzić.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param in - segmenty z jawnymi danymi.
+     * @param in_count - liczba segmentów wejściowych.
+     * @param out - segmenty na zaszyfrowane dane.
+     * @param out_count - liczba segmentów wyjściowych.
+     * @param iv - adres wektora IV (może być nullptr).
+     * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+     * @return liczba zapisanych bajtów lub -1 gdy segmenty wyjściowe są za małe
+     *         albo danych nie można uzupełnić wskazanym paddingiem.
+     */
+    static int encrypt_segments(const Cipher& cipher,
+                                const iovec* const in, const int in_count,
+                                const iovec* const out, const int out_count,
+                                const void* const iv, const Padding padding) noexcept
+    {
+        const size_t nbytes = SegmentReader::total(in, in_count);
+        if (nbytes == 0) {
+            return 0;
+        }
+        if (nbytes > INT_MAX - 2 * BlockSize || padding == Padding::Cts) {
+            return -1;
+        }
+        const int padded = Crypto::padded_size(int(nbytes), BlockSize, padding);
+        if (padded < 0) {
+            return -1;
+        }
+        const size_t rest = nbytes % BlockSize;
+        const size_t size = BlockSize + size_t(padded);
+        if (SegmentReader::total(out, out_count) < size) {
+            return -1;
+        }
+
+        SegmentReader reader(in, in_count);
+        SegmentWriter writer(out, out_count);
+
+        u32 chain[BlockWords];
+        u32 block[BlockWords];
+        if (iv) {
+            memcpy(chain, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(chain, BlockSize);
+        }
+        writer.write(chain, BlockSize);
+
+        size_t left = nbytes - rest;
+        while (left) {
+            // Szybka ścieżka: kolejne całe bloki leżą w bieżących
+            // segmentach wejścia i wyjścia - bez kopiowania przez bufor.
+            const size_t run = std::min({reader.contiguous(), writer.contiguous(), left}) / BlockSize;
+            if (run) {
+                const u8* src = reader.data();
+                u8* dst = writer.data();
+                for (size_t i = 0; i < run; i++) {
+                    memcpy(block, src, BlockSize);
+                    xor_block(block, chain);
+                    cipher.encrypt_block(block, chain);
+                    memcpy(dst, chain, BlockSize);
+                    src += BlockSize;
+                    dst += BlockSize;
+                }
+                reader.advance(run * BlockSize);
+                writer.advance(run * BlockSize);
+                left -= run * BlockSize;
+            } else {
+                // blok na granicy segmentów
+                reader.read(block, BlockSize);
+                xor_block(block, chain);
+                cipher.encrypt_block(block, chain);
+                writer.write(chain, BlockSize);
+                left -= BlockSize;
+            }
+        }
+
+        if (size_t(padded) > nbytes - rest) {
+            // ostatni blok z paddingiem
+            memset(block, 0, BlockSize);
+            reader.read(block, int(rest));
+            Crypto::pad(reinterpret_cast<u8*>(block), int(rest), BlockSize, padding);
+            xor_block(block, chain);
+            cipher.encrypt_block(block, chain);
+            writer.write(chain, BlockSize);
+        }
+        return int(size);
+    }
+
+    /**
+     * @brief decrypt_segments
+     * Deszyfrowanie w trybie CBC danych rozproszonych w wielu segmentach.
+     * Pierwszym blokiem zaszyfrowanych danych jest wektor IV.
+     * Ostatni blok jest wstrzymywany do czasu usunięcia paddingu.
+     * Segmenty wyjściowe muszą pomieścić (rozmiar danych - rozmiar bloku) bajtów.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param in - segmenty z zaszyfrowanymi danymi.
+     * @param in_count - liczba segmentów wejściowych.
+     * @param out - segmenty na odszyfrowane dane.
+     * @param out_count - liczba segmentów wyjściowych.
+     * @param padding - rodzaj paddingu użyty przy szyfrowaniu (Cts nie jest obsługiwany).
+     * @return liczba odszyfrowanych bajtów (bez paddingu) lub -1 przy błędzie.
+     */
+    static int decrypt_segments(const Cipher& cipher,
+                                const iovec* const in, const int in_count,
+                                const iovec* const out, const int out_count,
+                                const Padding padding) noexcept
+    {
+        const size_t nbytes = SegmentReader::total(in, in_count);
+        if (nbytes == 0) {
+            return 0;
+        }
+        if (nbytes % BlockSize || nbytes > INT_MAX || padding == Padding::Cts) {
+            return -1;
+        }
+        const size_t size = nbytes - BlockSize;
+        if (SegmentReader::total(out, out_count) < size) {
+            return -1;
+        }
+        if (size == 0) {
+            return 0;
+        }
+
+        SegmentReader reader(in, in_count);
+        SegmentWriter writer(out, out_count);
+
+        u32 chain[BlockWords];
+        u32 block[BlockWords];
+        reader.read(chain, BlockSize);
+
+        // wszystkie bloki poza ostatnim
+        size_t left = size - BlockSize;
+        while (left) {
+            const size_t run = std::min({reader.contiguous(), writer.contiguous(), left}) / BlockSize;
+            if (run) {
+                const u8* src = reader.data();
+                u8* dst = writer.data();
+                for (size_t i = 0; i < run; i++) {
+                    u32 next[BlockWords];
+                    memcpy(next, src, BlockSize);
+                    cipher.decrypt_block(next, block);
+                    xor_block(block, chain);
+                    memcpy(dst, block, BlockSize);
+                    memcpy(chain, next, BlockSize);
+                    src += BlockSize;
+                    dst += BlockSize;
+                }
+                reader.advance(run * BlockSize);
+                writer.advance(run * BlockSize);
+                left -= run * BlockSize;
+            } else {
+                u32 next[BlockWords];
+                reader.read(next, BlockSize);
+                cipher.decrypt_block(next, block);
+                xor_block(block, chain);
+                writer.write(block, BlockSize);
+                memcpy(chain, next, BlockSize);
+                left -= BlockSize;
+            }
+        }
+
+        // ostatni blok - usunięcie paddingu
+        u32 next[BlockWords];
+        reader.read(next, BlockSize);
+        cipher.decrypt_block(next, block);
+        xor_block(block, chain);
+        const int tail = Crypto::unpad(reinterpret_cast<const u8*>(block), BlockSize, BlockSize, padding);
+        if (tail < 0) {
+            return -1;
+        }
+        writer.write(block, tail);
+        return int(size) - BlockSize + tail;
+    }
+    /**
+     * @brief encrypt_cts
+     * Szyfrowanie w trybie CBC z kradzieżą szyfrogramu (wariant CS3:
+     * dwa ostatnie bloki zawsze zamienione miejscami, ostatni skrócony).
+     * Zaszyfrowane dane (bez IV) mają taki sam rozmiar jak jawne.
+     * Dane muszą mieć co najmniej jeden pełny blok.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres bufora z jawnymi danymi.
+     * @param nbytes - rozmiar jawnych danych w bajtach.
+     * @param iv - adres wektora IV.
+     * @return - tuple: adres bufora (IV + zaszyfrowane dane) + jego rozmiar w bajtach
+     *           (rozmiar -1 gdy dane są krótsze od bloku).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt_cts(const Cipher& cipher, const void* const data, const int nbytes, const void* const iv) noexcept {
+        if (nbytes < BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int m = (nbytes + BlockSize - 1) / BlockSize;   // liczba bloków
+        const int d = nbytes - (m - 1) * BlockSize;           // bajty w ostatnim bloku
+
+        u8* const out = new u8[nbytes + BlockSize];
+        memcpy(out, iv, BlockSize);
+
+        const u8* src = static_cast<const u8*>(data);
+        u8* dst = out + BlockSize;
+        u32 chain[BlockWords];
+        u32 block[BlockWords];
+        memcpy(chain, iv, BlockSize);
+
+        for (int i = 0; i < m - 1; i++) {
+            memcpy(block, src, BlockSize);
+            xor_block(block, chain);
+            cipher.encrypt_block(block, chain);
+            memcpy(dst, chain, BlockSize);
+            src += BlockSize;
+            dst += BlockSize;
+        }
+
+        // ostatni blok uzupełniony zerami
+        memset(block, 0, BlockSize);
+        memcpy(block, src, d);
+        xor_block(block, chain);
+        cipher.encrypt_block(block, block);
+
+        if (m == 1) {
+            memcpy(dst, block, BlockSize);
+        } else {
+            // C(m-1) skrócony do d bajtów idzie na koniec, pełny C(m) przed nim
+            u8* const prev = dst - BlockSize;
+            memcpy(dst, prev, d);
+            memcpy(prev, block, BlockSize);
+        }
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes + BlockSize);
+    }
+
+    /**
+     * @brief decrypt_cts
+     * Deszyfrowanie danych zaszyfrowanych przez encrypt_cts.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres bufora z zaszyfrowanymi danymi (IV + dane).
+     * @param nbytes - rozmiar zaszyfrowanych danych w bajtach.
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar -1 gdy dane są za krótkie).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt_cts(const Cipher& cipher, const void* const data, const int nbytes) noexcept {
+        const int size = nbytes - BlockSize;
+        if (size < BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int m = (size + BlockSize - 1) / BlockSize;
+        const int d = size - (m - 1) * BlockSize;
+
+        u8* const out = new u8[size];
+        const u8* src = static_cast<const u8*>(data);
+        u8* dst = out;
+        u32 chain[BlockWords];
+        u32 block[BlockWords];
+        u32 next[BlockWords];
+        memcpy(chain, src, BlockSize);
+        src += BlockSize;
+
+        for (int i = 0; i < m - 2; i++) {
+            memcpy(next, src, BlockSize);
+            cipher.decrypt_block(next, block);
+            xor_block(block, chain);
+            memcpy(dst, block, BlockSize);
+            memcpy(chain, next, BlockSize);
+            src += BlockSize;
+            dst += BlockSize;
+        }
+
+        if (m == 1) {
+            memcpy(next, src, BlockSize);
+            cipher.decrypt_block(next, block);
+            xor_block(block, chain);
+            memcpy(dst, block, BlockSize);
+        } else {
+            // X = D(C(m)) = (P(m) || 0) ^ C(m-1)
+            u32 x[BlockWords];
+            memcpy(next, src, BlockSize);
+            cipher.decrypt_block(next, x);
+            u8* const xb = reinterpret_cast<u8*>(x);
+
+            // odtworzenie pełnego C(m-1) i ostatniego bloku jawnego
+            u8 last[BlockSize];
+            u8 prev[BlockSize];
+            memcpy(prev, src + BlockSize, d);
+            memcpy(prev + d, xb + d, BlockSize - d);
+            for (int i = 0; i < d; i++) {
+                last[i] = xb[i] ^ prev[i];
+            }
+
+            memcpy(next, prev, BlockSize);
+            cipher.decrypt_block(next, block);
+            xor_block(block, chain);
+            memcpy(dst, block, BlockSize);
+            memcpy(dst + BlockSize, last, d);
+        }
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+    /**
+     * @brief encrypt_batch
+     * Szyfrowanie w trybie CBC wielu niezależnych wiadomości (multi-buffer).
+     * Łańcuch jednej wiadomości jest sekwencyjny, więc w jednym wywołaniu
+     * kernela wieloblokowego przeplatane są łańcuchy do BatchLanes
+     * wiadomości; gdy wiadomość się kończy, jej tor zajmuje następna.
+     * Duże wsady są dodatkowo dzielone między wątki (@see Parallel).
+     * Wynik każdej wiadomości jest identyczny z encrypt_cbc.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param jobs - tablica opisów wiadomości (pole size jest wynikiem).
+     * @param count - liczba wiadomości.
+     * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+     * @return liczba poprawnie zaszyfrowanych wiadomości.
+     */
+    static int encrypt_batch(const Cipher& cipher, Job* const jobs, const int count, const Padding padding) noexcept {
+        if (count <= 0) {
+            return 0;
+        }
+        u64 total = 0;
+        int valid = 0;
+        for (int i = 0; i < count; i++) {
+            Job& job = jobs[i];
+            if (job.data == nullptr || job.nbytes == 0) {
+                job.size = 0;
+                continue;
+            }
+            const int padded = (padding == Padding::Cts || job.out == nullptr)
+                    ? -1 : Crypto::padded_size(job.nbytes, BlockSize, padding);
+            job.size = (padded < 0) ? -1 : padded + BlockSize;
+            if (job.size > 0) {
+                total += u64(job.size);
+                valid++;
+            }
+        }
+        if (total >= u64(Parallel::threshold())) {
+            Parallel::for_each(count, BatchLanes, [&](const int begin, const int end) {
+                interleave(cipher, jobs + begin, end - begin, padding);
+            });
+        } else {
+            interleave(cipher, jobs, count, padding);
+        }
+        return valid;
+    }
+
+    /**
+     * @brief decrypt_chain
+     * Deszyfrowanie nblocks bloków łańcucha CBC (bez obsługi paddingu).
+     * Blok jawny zależy tylko od dwóch bloków szyfrogramu, więc duże dane
+     * (od progu Parallel::threshold()) są dzielone na fragmenty deszyfrowane
+     * równolegle kernelem wieloblokowym.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres zaszyfrowanych danych (IV + nblocks bloków).
+     * @param nblocks - liczba bloków danych (bez IV).
+     * @param out - bufor na odszyfrowane dane (nblocks * BlockSize bajtów).
+     */
+    static void decrypt_chain(const Cipher& cipher, const void* const data, const int nblocks, void* const out) noexcept {
+        const u8* const in = static_cast<const u8*>(data);
+        u8* const dst = static_cast<u8*>(out);
+        if (nblocks * BlockSize >= Parallel::threshold()) {
+            Parallel::for_each(nblocks, Grain, [&](const int begin, const int end) {
+                decrypt_blocks(cipher, in, begin, end - begin, dst + begin * BlockSize);
+            });
+        } else {
+            decrypt_blocks(cipher, in, 0, nblocks, dst);
+        }
+    }
+
+    /**
+     * @brief decrypt_range
+     * Odszyfrowanie tylko fragmentu [offset, offset + length) jawnych danych.
+     * W CBC blok jawny zależy tylko od dwóch bloków szyfrogramu, więc
+     * deszyfrowane są wyłącznie bloki pokrywające fragment. Długość jawnych
+     * danych (po usunięciu paddingu) jest ustalana przez odszyfrowanie
+     * najpierw ostatniego bloku; fragment jest do niej przycinany.
+     * Dla Padding::Cts (dwa ostatnie bloki są zamienione) odszyfrowywane
+     * są całe dane.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres zaszyfrowanych danych (IV + dane).
+     * @param nbytes - rozmiar zaszyfrowanych danych w bajtach.
+     * @param offset - pozycja pierwszego bajtu fragmentu w jawnych danych.
+     * @param length - długość fragmentu w bajtach.
+     * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+     * @return - tuple: adres bufora z fragmentem + jego rozmiar w bajtach
+     *           (0 gdy fragment leży za końcem danych, -1 przy błędzie).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt_range(const Cipher& cipher, const void* const data, const int nbytes,
+                  const int offset, const int length, const Padding padding) noexcept
+    {
+        if (data == nullptr || nbytes == 0 || length == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        if (offset < 0 || length < 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        if (padding == Padding::Cts) {
+            const auto [plain, size] = decrypt_cts(cipher, data, nbytes);
+            if (size < 0 || offset >= size) {
+                return std::make_tuple(std::shared_ptr<void>(nullptr), std::min(size, 0));
+            }
+            const int n = std::min(length, size - offset);
+            u8* const out = new u8[n];
+            memcpy(out, static_cast<const u8*>(plain.get()) + offset, n);
+            Crypto::clear_bytes(plain.get(), size);
+            return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), n);
+        }
+        if (nbytes % BlockSize || nbytes < 2 * BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+
+        // ostatni blok: rzeczywista długość jawnych danych
+        const u8* const in = static_cast<const u8*>(data);
+        const int nblocks = nbytes / BlockSize - 1;
+        u8 last[BlockSize];
+        decrypt_blocks(cipher, in, nblocks - 1, 1, last);
+        const int tail = Crypto::unpad(last, BlockSize, BlockSize, padding);
+        Crypto::clear_bytes(last, sizeof(last));
+        if (tail < 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int size = (nblocks - 1) * BlockSize + tail;
+        if (offset >= size) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+
+        const int end = offset + std::min(length, size - offset);
+        const int first = offset / BlockSize;
+        const int count = (end - 1) / BlockSize - first + 1;
+        u8* const out = new u8[count * BlockSize];
+        decrypt_blocks(cipher, in, first, count, out);
+        const int skip = offset - first * BlockSize;
+        if (skip) {
+            memmove(out, out + skip, end - offset);
+        }
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), end - offset);
+    }
+
+private:
+    /// Łańcuchy do BatchLanes wiadomości w jednym wywołaniu kernela, z wymianą zakończonych.
+    static void interleave(const Cipher& cipher, Job* const jobs, const int count, const Padding padding) noexcept {
+        u32 state[BatchLanes * BlockWords];
+        int job[BatchLanes];        // numer wiadomości w torze
+        int block[BatchLanes];      // numer następnego bloku wiadomości
+        int lanes = 0;
+        int next = 0;
+
+        auto start = [&](const int lane) {
+            while (next < count && jobs[next].size <= 0) {
+                next++;
+            }
+            if (next == count) {
+                return false;
+            }
+            Job& j = jobs[next];
+            u8* const out = static_cast<u8*>(j.out);
+            if (j.iv) {
+                memcpy(out, j.iv, BlockSize);
+            } else {
+                Crypto::random_bytes(out, BlockSize);
+            }
+            memcpy(state + lane * BlockWords, out, BlockSize);
+            job[lane] = next++;
+            block[lane] = 0;
+            return true;
+        };
+        while (lanes < BatchLanes && start(lanes)) {
+            lanes++;
+        }
+
+        while (lanes > 0) {
+            // P(i) ^ C(i-1) dla każdego toru; ostatni blok z paddingiem
+            for (int l = 0; l < lanes; l++) {
+                const Job& j = jobs[job[l]];
+                const int pos = block[l] * BlockSize;
+                u32* const s = state + l * BlockWords;
+                if (j.nbytes - pos >= BlockSize) {
+                    Crypto::xor_bytes(s, s, static_cast<const u8*>(j.data) + pos, BlockSize);
+                } else {
+                    u8 last[BlockSize];
+                    const int rest = j.nbytes - pos;
+                    if (rest > 0) {
+                        memcpy(last, static_cast<const u8*>(j.data) + pos, rest);
+                    }
+                    Crypto::pad(last, rest, BlockSize, padding);
+                    Crypto::xor_bytes(s, s, last, BlockSize);
+                    Crypto::clear_bytes(last, sizeof(last));
+                }
+            }
+            cipher.encrypt_blocks(state, state, lanes);
+
+            for (int l = 0; l < lanes; l++) {
+                memcpy(static_cast<u8*>(jobs[job[l]].out) + (++block[l]) * BlockSize, state + l * BlockWords, BlockSize);
+            }
+
+            // zakończone wiadomości: wymiana toru na następną wiadomość
+            for (int l = 0; l < lanes; ) {
+                if ((block[l] + 1) * BlockSize < jobs[job[l]].size || start(l)) {
+                    l++;
+                } else if (--lanes != l) {
+                    memcpy(state + l * BlockWords, state + lanes * BlockWords, BlockSize);
+                    job[l] = job[lanes];
+                    block[l] = block[lanes];
+                }
+            }
+        }
+        Crypto::clear_bytes(state, sizeof(state));
+    }
+
+    /// Odszyfrowanie bloków [first, first + count) jawnych danych (in wskazuje na IV).
+    static void decrypt_blocks(const Cipher& cipher, const u8* const in, const int first, const int count, u8* const out) noexcept {
+        constexpr int TileBlocks = 64;
+        u32 tile[TileBlocks * BlockWords];
+        for (int done = 0; done < count; ) {
+            const int n = std::min(count - done, TileBlocks);
+            const u8* const c = in + (first + done + 1) * BlockSize;
+            memcpy(tile, c, n * BlockSize);
+            cipher.decrypt_blocks(tile, tile, n);
+            Crypto::xor_bytes(out + done * BlockSize, tile, c - BlockSize, n * BlockSize);
+            done += n;
+        }
+        Crypto::clear_bytes(tile, sizeof(tile));
+    }
+
+    static void xor_block(u32* const dst, const u32* const src) noexcept {
+        for (int j = 0; j < BlockWords; j++) {
+            dst[j] ^= src[j];
+        }
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_CBC_H
@@ -0,0 +1,256 @@
+#ifndef BEESOFT_CRYPTO_MODES_CFB_H
+#define BEESOFT_CRYPTO_MODES_CFB_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Cfb
+ * Tryb sprzężenia zwrotnego szyfrogramu (CFB) dla wszystkich szyfrów
+ * blokowych, w dwóch wariantach:
+ *  - pełnoblokowym (segment = BlockSize),
+ *  - 8-bitowym (CFB8, segment = 1 bajt).
+ * Tryb nie wymaga paddingu. Obiekt klasy jest strumieniowym
+ * szyfratorem/deszyfratorem przyjmującym dane w porcjach dowolnej długości
+ * (wynik nie zależy od podziału danych na porcje).
+ * Szyfrowanie jest z natury sekwencyjne, natomiast przy deszyfrowaniu
+ * każdy segment zależy tylko od poprzedniego szyfrogramu, więc funkcja
+ * decrypt przetwarza dane kernelem wieloblokowym szyfru (encrypt_blocks),
+ * a duże dane dzieli między wątki (@see Parallel).
+ */
+template<typename Cipher>
+class Cfb {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int TileBlocks = 64;   // rejestry na jedno wywołanie kernela
+
+    const Cipher& cipher;
+    u32 reg[BlockWords];    // rejestr sprzężenia (ostatni szyfrogram)
+    u32 ks[BlockWords];     // zaszyfrowany rejestr (strumień)
+    const int segment;      // BlockSize lub 1 (CFB8)
+    const bool decrypting;
+    int used = BlockSize;   // liczba wykorzystanych bajtów strumienia
+
+public:
+    /**
+     * @brief Cfb
+     * Utworzenie strumieniowego szyfratora (decrypting == false)
+     * lub deszyfratora (decrypting == true).
+     *
+     * @param cipher - kontekst szyfru (musi istnieć przez cały czas życia obiektu).
+     * @param iv - wektor IV (BlockSize bajtów).
+     * @param decrypting - kierunek przetwarzania.
+     * @param segment - rozmiar segmentu: BlockSize lub 1 (CFB8).
+     */
+    Cfb(const Cipher& cipher, const void* const iv, const bool decrypting, const int segment = BlockSize) noexcept
+        : cipher(cipher), segment(segment == 1 ? 1 : BlockSize), decrypting(decrypting)
+    {
+        memcpy(reg, iv, BlockSize);
+    }
+    ~Cfb() {
+        Crypto::clear_bytes(reg, sizeof(reg));
+        Crypto::clear_bytes(ks, sizeof(ks));
+    }
+    Cfb(const Cfb&) = delete;
+    Cfb& operator=(const Cfb&) = delete;
+
+    /**
+     * @brief update
+     * Przetworzenie kolejnej porcji danych (dowolnej długości).
+     * Bufory src i dst mogą być tym samym buforem.
+     *
+     * @param src - adres danych wejściowych.
+     * @param dst - adres bufora wynikowego.
+     * @param nbytes - liczba bajtów.
+     */
+    void update(const void* const src, void* const dst, int nbytes) noexcept {
+        const u8* in = static_cast<const u8*>(src);
+        u8* out = static_cast<u8*>(dst);
+        u8* const r = reinterpret_cast<u8*>(reg);
+        const u8* const k = reinterpret_cast<const u8*>(ks);
+
+        if (segment == 1) {
+            for (int i = 0; i < nbytes; i++) {
+                cipher.encrypt_block(reg, ks);
+                const u8 c = decrypting ? in[i] : u8(in[i] ^ k[0]);
+                out[i] = in[i] ^ k[0];
+                memmove(r, r + 1, BlockSize - 1);
+                r[BlockSize - 1] = c;
+            }
+            return;
+        }
+
+        while (nbytes > 0) {
+            if (used == BlockSize) {
+                cipher.encrypt_block(reg, ks);
+                used = 0;
+            }
+            if (used == 0 && nbytes >= BlockSize) {
+                // cały blok naraz
+                u8 c[BlockSize];
+                Crypto::xor_bytes(c, in, k, BlockSize);
+                memcpy(r, decrypting ? in : c, BlockSize);
+                memcpy(out, c, BlockSize);
+                used = BlockSize;
+                in += BlockSize;
+                out += BlockSize;
+                nbytes -= BlockSize;
+                continue;
+            }
+            const u8 b = in[0];
+            out[0] = b ^ k[used];
+            r[used] = decrypting ? b : out[0];
+            used++;
+            in++;
+            out++;
+            nbytes--;
+        }
+    }
+
+    /**
+     * @brief encrypt
+     * Szyfrowanie w trybie CFB. Jeśli IV nie został przekazany
+     * to zostanie losowo wygenerowany. Wektor IV jest pierwszym blokiem
+     * zaszyfrowanych danych, dane nie są uzupełniane paddingiem.
+     *
+     * @return - tuple: adres bufora (IV + zaszyfrowane dane) + jego rozmiar w bajtach.
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt(const Cipher& cipher, const void* const data, const int nbytes, const void* iv, const int segment = BlockSize) noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        u8* const out = new u8[nbytes + BlockSize];
+        if (iv) {
+            memcpy(out, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(out, BlockSize);
+        }
+        Cfb(cipher, out, false, segment).update(data, out + BlockSize, nbytes);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes + BlockSize);
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie w trybie CFB (pierwszym blokiem danych jest IV).
+     * Rejestry wszystkich segmentów są znane z góry (to IV i szyfrogram),
+     * więc są szyfrowane kernelem wieloblokowym, równolegle dla dużych danych.
+     *
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar -1 gdy dane są krótsze od bloku).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt(const Cipher& cipher, const void* const data, const int nbytes, const int segment = BlockSize) noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        if (nbytes < BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int size = nbytes - BlockSize;
+        u8* const out = new u8[std::max(size, 1)];
+        const u8* const in = static_cast<const u8*>(data);
+
+        if (segment == 1) {
+            // każdy bajt wymaga zaszyfrowania jednego rejestru
+            if (u64(size) * BlockSize >= u64(Parallel::threshold())) {
+                Parallel::for_each(size, TileBlocks * BlockSize, [&](const int begin, const int end) {
+                    decrypt_bytes(cipher, in, out, begin, end);
+                });
+            } else {
+                decrypt_bytes(cipher, in, out, 0, size);
+            }
+        } else {
+            const int nblocks = size / BlockSize;
+            if (nblocks * BlockSize >= Parallel::threshold()) {
+                Parallel::for_each(nblocks, TileBlocks, [&](const int begin, const int end) {
+                    decrypt_blocks(cipher, in, out, begin, end);
+                });
+            } else {
+                decrypt_blocks(cipher, in, out, 0, nblocks);
+            }
+            if (const int rest = size - nblocks * BlockSize; rest) {
+                const int done = nblocks * BlockSize;
+                u32 k[BlockWords];
+                memcpy(k, in + done, BlockSize);
+                cipher.encrypt_block(k, k);
+                Crypto::xor_bytes(out + done, in + BlockSize + done, k, rest);
+                Crypto::clear_bytes(k, sizeof(k));
+            }
+        }
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+private:
+    /// Deszyfrowanie pełnych bloków [begin, end); in wskazuje na IV + szyfrogram.
+    static void decrypt_blocks(const Cipher& cipher, const u8* const in, u8* const out, int begin, const int end) noexcept {
+        u32 k[TileBlocks * BlockWords];
+        while (begin < end) {
+            const int n = std::min(end - begin, TileBlocks);
+            const u8* const prev = in + begin * BlockSize;
+            memcpy(k, prev, n * BlockSize);
+            cipher.encrypt_blocks(k, k, n);
+            Crypto::xor_bytes(out + begin * BlockSize, prev + BlockSize, k, n * BlockSize);
+            begin += n;
+        }
+        Crypto::clear_bytes(k, sizeof(k));
+    }
+
+    /// Deszyfrowanie bajtów [begin, end) w trybie CFB8; rejestrem bajtu i jest in[i, i + BlockSize).
+    static void decrypt_bytes(const Cipher& cipher, const u8* const in, u8* const out, int begin, const int end) noexcept {
+        u32 k[TileBlocks * BlockWords];
+        while (begin < end) {
+            const int n = std::min(end - begin, TileBlocks);
+            for (int i = 0; i < n; i++) {
+                memcpy(k + i * BlockWords, in + begin + i, BlockSize);
+            }
+            cipher.encrypt_blocks(k, k, n);
+            for (int i = 0; i < n; i++) {
+                out[begin + i] = in[BlockSize + begin + i] ^ reinterpret_cast<const u8*>(k + i * BlockWords)[0];
+            }
+            begin += n;
+        }
+        Crypto::clear_bytes(k, sizeof(k));
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_CFB_H
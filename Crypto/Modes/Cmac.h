@@ -0,0 +1,297 @@
+#ifndef BEESOFT_CRYPTO_MODES_CMAC_H
+#define BEESOFT_CRYPTO_MODES_CMAC_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Cmac
+ * Kod uwierzytelniający CMAC (OMAC1, NIST SP 800-38B) dla wszystkich
+ * szyfrów blokowych. Podklucze K1, K2 to E(0) pomnożone przez x i x^2
+ * w ciele GF(2^n) (n = 8 * BlockSize, zapis big-endian):
+ *  - GF(2^64): x^64 + x^4 + x^3 + x + 1,
+ *  - GF(2^96): x^96 + x^10 + x^9 + x^6 + 1.
+ * Obiekt klasy wyznacza znacznik strumieniowo (update/finalize).
+ * Łańcuch CBC-MAC jednej wiadomości jest sekwencyjny, dlatego funkcja
+ * compute_batch wyznacza znaczniki wielu niezależnych wiadomości naraz:
+ * łańcuchy kolejnych wiadomości są przeplatane w jednym wywołaniu kernela
+ * wieloblokowego (po Cipher::Lanes na wątek), a duże wsady są dzielone
+ * między wątki (@see Parallel).
+ */
+template<typename Cipher>
+class Cmac {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int BatchLanes = 2 * Cipher::Lanes;   // łańcuchy w jednym wywołaniu kernela
+    static_assert(BlockSize == 8 || BlockSize == 12, "Cmac: unsupported block size");
+
+    const Cipher& cipher;
+    u32 k1[BlockWords];
+    u32 k2[BlockWords];
+    u32 state[BlockWords];
+    u8 buffer[BlockSize];
+    int used = 0;           // liczba bajtów w buforze (ostatni blok jest zawsze wstrzymywany)
+
+public:
+    static constexpr int TagSize = BlockSize;
+
+    /// Opis wiadomości dla compute_batch.
+    struct Message {
+        const void* data;   // dane wiadomości
+        int nbytes;         // rozmiar wiadomości (może być 0)
+        void* tag;          // bufor na znacznik (TagSize bajtów)
+    };
+
+    explicit Cmac(const Cipher& cipher) noexcept : cipher(cipher) {
+        subkeys(cipher, k1, k2);
+        reset();
+    }
+    ~Cmac() {
+        Crypto::clear_bytes(k1, sizeof(k1));
+        Crypto::clear_bytes(k2, sizeof(k2));
+        Crypto::clear_bytes(state, sizeof(state));
+        Crypto::clear_bytes(buffer, sizeof(buffer));
+    }
+    Cmac(const Cmac&) = delete;
+    Cmac& operator=(const Cmac&) = delete;
+
+    /// Rozpoczęcie nowej wiadomości.
+    void reset() noexcept {
+        memset(state, 0, sizeof(state));
+        used = 0;
+    }
+
+    /**
+     * @brief update
+     * Dołączenie kolejnej porcji danych (dowolnej długości).
+     *
+     * @param data - adres danych.
+     * @param nbytes - liczba bajtów.
+     */
+    void update(const void* const data, int nbytes) noexcept {
+        const u8* in = static_cast<const u8*>(data);
+        while (nbytes > 0) {
+            if (used == BlockSize) {
+                Crypto::xor_bytes(state, state, buffer, BlockSize);
+                cipher.encrypt_block(state, state);
+                used = 0;
+            }
+            const int n = std::min(nbytes, BlockSize - used);
+            memcpy(buffer + used, in, n);
+            used += n;
+            in += n;
+            nbytes -= n;
+        }
+    }
+
+    /**
+     * @brief finalize
+     * Wyznaczenie znacznika; obiekt jest gotowy do przyjęcia nowej wiadomości.
+     *
+     * @param tag - bufor na znacznik (TagSize bajtów).
+     */
+    void finalize(void* const tag) noexcept {
+        last_block(state, buffer, used, k1, k2);
+        cipher.encrypt_block(state, state);
+        memcpy(tag, state, TagSize);
+        reset();
+    }
+
+    /**
+     * @brief compute
+     * Wyznaczenie znacznika CMAC wiadomości.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param data - adres danych.
+     * @param nbytes - rozmiar danych w bajtach.
+     * @param tag - bufor na znacznik (TagSize bajtów).
+     */
+    static void compute(const Cipher& cipher, const void* const data, const int nbytes, void* const tag) noexcept {
+        Cmac mac(cipher);
+        mac.update(data, nbytes);
+        mac.finalize(tag);
+    }
+
+    /**
+     * @brief verify
+     * Sprawdzenie znacznika CMAC wiadomości (porównanie w stałym czasie).
+     *
+     * @return true gdy znacznik jest poprawny.
+     */
+    static bool verify(const Cipher& cipher, const void* const data, const int nbytes, const void* const tag) noexcept {
+        u8 expected[TagSize];
+        compute(cipher, data, nbytes, expected);
+        return Crypto::verify_bytes(expected, tag, TagSize);
+    }
+
+    /**
+     * @brief compute_batch
+     * Wyznaczenie znaczników wielu niezależnych wiadomości.
+     * Wynik jest identyczny z wywołaniem compute dla każdej wiadomości.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param messages - tablica opisów wiadomości.
+     * @param count - liczba wiadomości.
+     */
+    static void compute_batch(const Cipher& cipher, const Message* const messages, const int count) noexcept {
+        if (count <= 0) {
+            return;
+        }
+        u64 total = 0;
+        for (int i = 0; i < count; i++) {
+            total += u64(messages[i].nbytes);
+        }
+        if (total >= u64(Parallel::threshold())) {
+            Parallel::for_each(count, BatchLanes, [&](const int begin, const int end) {
+                interleave(cipher, messages + begin, end - begin);
+            });
+        } else {
+            interleave(cipher, messages, count);
+        }
+    }
+
+    /**
+     * @brief multiply
+     * Mnożenie bloku (liczby big-endian) przez x w GF(2^n).
+     */
+    static void multiply(u8* const b) noexcept {
+        const u8 carry = b[0] >> 7;
+        for (int i = 0; i < BlockSize - 1; i++) {
+            b[i] = u8((b[i] << 1) | (b[i + 1] >> 7));
+        }
+        b[BlockSize - 1] = u8(b[BlockSize - 1] << 1);
+        if (carry) {
+            if constexpr (BlockSize == 8) {
+                b[BlockSize - 1] ^= 0x1b;
+            } else {
+                b[BlockSize - 1] ^= 0x41;
+                b[BlockSize - 2] ^= 0x06;
+            }
+        }
+    }
+
+private:
+    static void subkeys(const Cipher& cipher, u32* const k1, u32* const k2) noexcept {
+        memset(k1, 0, BlockSize);
+        cipher.encrypt_block(k1, k1);
+        multiply(reinterpret_cast<u8*>(k1));
+        memcpy(k2, k1, BlockSize);
+        multiply(reinterpret_cast<u8*>(k2));
+    }
+
+    /// Dołączenie ostatniego (być może niepełnego lub pustego) bloku z podkluczem.
+    static void last_block(u32* const state, const u8* const data, const int n,
+                           const u32* const k1, const u32* const k2) noexcept
+    {
+        u8 block[BlockSize];
+        if (n > 0) {
+            memcpy(block, data, n);
+        }
+        if (n == BlockSize) {
+            Crypto::xor_bytes(block, block, k1, BlockSize);
+        } else {
+            block[n] = 0x80;
+            memset(block + n + 1, 0, BlockSize - n - 1);
+            Crypto::xor_bytes(block, block, k2, BlockSize);
+        }
+        Crypto::xor_bytes(state, state, block, BlockSize);
+    }
+
+    /// Łańcuchy do BatchLanes wiadomości przetwarzane jednym wywołaniem kernela;
+    /// gdy wiadomość się kończy, jej miejsce zajmuje następna.
+    static void interleave(const Cipher& cipher, const Message* const messages, const int count) noexcept {
+        u32 k1[BlockWords], k2[BlockWords];
+        subkeys(cipher, k1, k2);
+
+        u32 state[BatchLanes * BlockWords];
+        int message[BatchLanes];    // numer wiadomości w torze
+        int pos[BatchLanes];        // liczba przetworzonych bajtów wiadomości
+        int lanes = 0;
+        int next = 0;
+
+        auto start = [&](const int lane) {
+            message[lane] = next++;
+            pos[lane] = 0;
+            memset(state + lane * BlockWords, 0, BlockSize);
+        };
+        while (lanes < BatchLanes && next < count) {
+            start(lanes++);
+        }
+
+        while (lanes > 0) {
+            // dołączenie kolejnego bloku każdej wiadomości (ostatni z podkluczem)
+            for (int l = 0; l < lanes; l++) {
+                const Message& m = messages[message[l]];
+                const u8* const data = static_cast<const u8*>(m.data) + pos[l];
+                u32* const s = state + l * BlockWords;
+                const int rest = m.nbytes - pos[l];
+                if (rest > BlockSize) {
+                    Crypto::xor_bytes(s, s, data, BlockSize);
+                    pos[l] += BlockSize;
+                } else {
+                    last_block(s, data, rest, k1, k2);
+                    pos[l] = -1;    // znacznik: to był ostatni blok
+                }
+            }
+            cipher.encrypt_blocks(state, state, lanes);
+
+            // zakończone wiadomości: zapis znacznika i wymiana toru
+            for (int l = 0; l < lanes; ) {
+                if (pos[l] != -1) {
+                    l++;
+                    continue;
+                }
+                memcpy(messages[message[l]].tag, state + l * BlockWords, TagSize);
+                if (next < count) {
+                    start(l++);
+                } else if (--lanes != l) {
+                    memcpy(state + l * BlockWords, state + lanes * BlockWords, BlockSize);
+                    message[l] = message[lanes];
+                    pos[l] = pos[lanes];
+                }
+            }
+        }
+        Crypto::clear_bytes(k1, sizeof(k1));
+        Crypto::clear_bytes(k2, sizeof(k2));
+        Crypto::clear_bytes(state, sizeof(state));
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_CMAC_H
@@ -0,0 +1,218 @@
+#ifndef BEESOFT_CRYPTO_MODES_CTR_H
+#define BEESOFT_CRYPTO_MODES_CTR_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Ctr
+ * Tryb licznikowy (CTR) dla wszystkich szyfrów blokowych.
+ * Licznikiem jest cały blok traktowany jako liczba big-endian
+ * (64 bity dla Blowfish i Gost, 96 bitów dla Way3); wartością
+ * początkową jest IV. Tryb nie wymaga paddingu, a strumień może być
+ * wygenerowany od dowolnego bajtu (swobodny dostęp).
+ * Strumień jest generowany wieloblokowym kernelem szyfru (encrypt_blocks),
+ * a duże dane są dzielone między wątki (@see Parallel).
+ */
+template<typename Cipher>
+class Ctr {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int TileBlocks = 64;   // bloki strumienia na jedno wywołanie kernela
+
+public:
+    /**
+     * @brief counter_block
+     * Wyznaczenie wartości licznika dla bloku o wskazanym numerze (IV + index).
+     *
+     * @param iv - wartość początkowa licznika.
+     * @param index - numer bloku.
+     * @param out - bufor na blok licznika.
+     */
+    static void counter_block(const void* const iv, u64 index, u8* const out) noexcept {
+        memcpy(out, iv, BlockSize);
+        unsigned carry = 0;
+        for (int i = BlockSize - 1; i >= 0; i--) {
+            const unsigned sum = unsigned(out[i]) + unsigned(index & 0xff) + carry;
+            out[i] = u8(sum);
+            carry = sum >> 8;
+            index >>= 8;
+            if (index == 0 && carry == 0) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief crypt
+     * Szyfrowanie/odszyfrowanie (XOR ze strumieniem) fragmentu danych
+     * zaczynającego się od wskazanego bajtu strumienia.
+     * Bufory src i dst mogą być tym samym buforem.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param iv - wartość początkowa licznika (BlockSize bajtów).
+     * @param offset - pozycja pierwszego bajtu w strumieniu.
+     * @param src - adres danych wejściowych.
+     * @param dst - adres bufora wynikowego.
+     * @param nbytes - liczba bajtów.
+     */
+    static void crypt(const Cipher& cipher, const void* const iv, const u64 offset,
+                      const void* const src, void* const dst, int nbytes) noexcept
+    {
+        const u8* in = static_cast<const u8*>(src);
+        u8* out = static_cast<u8*>(dst);
+        u64 index = offset / BlockSize;
+
+        if (const int skip = int(offset % BlockSize); skip && nbytes > 0) {
+            const int n = std::min(nbytes, BlockSize - skip);
+            partial(cipher, iv, index++, skip, in, out, n);
+            in += n;
+            out += n;
+            nbytes -= n;
+        }
+
+        const int nblocks = nbytes / BlockSize;
+        if (nblocks * BlockSize >= Parallel::threshold()) {
+            Parallel::for_each(nblocks, TileBlocks, [&](const int begin, const int end) {
+                crypt_blocks(cipher, iv, index + begin, in + begin * BlockSize, out + begin * BlockSize, end - begin);
+            });
+        } else {
+            crypt_blocks(cipher, iv, index, in, out, nblocks);
+        }
+
+        if (const int rest = nbytes - nblocks * BlockSize; rest) {
+            const int done = nblocks * BlockSize;
+            partial(cipher, iv, index + nblocks, 0, in + done, out + done, rest);
+        }
+    }
+
+    /**
+     * @brief encrypt
+     * Szyfrowanie w trybie CTR. Jeśli IV nie został przekazany
+     * to zostanie losowo wygenerowany. Wektor IV jest pierwszym blokiem
+     * zaszyfrowanych danych, dane nie są uzupełniane paddingiem.
+     *
+     * @return - tuple: adres bufora (IV + zaszyfrowane dane) + jego rozmiar w bajtach.
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt(const Cipher& cipher, const void* const data, const int nbytes, const void* iv) noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        u8* const out = new u8[nbytes + BlockSize];
+        if (iv) {
+            memcpy(out, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(out, BlockSize);
+        }
+        crypt(cipher, out, 0, data, out + BlockSize, nbytes);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes + BlockSize);
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie w trybie CTR (pierwszym blokiem danych jest IV).
+     *
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar -1 gdy dane są krótsze od bloku).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt(const Cipher& cipher, const void* const data, const int nbytes) noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        if (nbytes < BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int size = nbytes - BlockSize;
+        u8* const out = new u8[std::max(size, 1)];
+        const u8* const in = static_cast<const u8*>(data);
+        crypt(cipher, in, 0, in + BlockSize, out, size);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+private:
+    /// XOR pełnych bloków ze strumieniem, generowanym po TileBlocks bloków.
+    static void crypt_blocks(const Cipher& cipher, const void* const iv, const u64 first,
+                             const u8* in, u8* out, int nblocks) noexcept
+    {
+        u32 ks[TileBlocks * BlockWords];
+        u8 counter[BlockSize];
+        counter_block(iv, first, counter);
+
+        while (nblocks > 0) {
+            const int n = std::min(nblocks, TileBlocks);
+            u8* k = reinterpret_cast<u8*>(ks);
+            for (int i = 0; i < n; i++, k += BlockSize) {
+                memcpy(k, counter, BlockSize);
+                increment(counter);
+            }
+            cipher.encrypt_blocks(ks, ks, n);
+            Crypto::xor_bytes(out, in, ks, n * BlockSize);
+            in += n * BlockSize;
+            out += n * BlockSize;
+            nblocks -= n;
+        }
+        Crypto::clear_bytes(ks, sizeof(ks));
+    }
+
+    /// XOR fragmentu jednego bloku (od bajtu skip) ze strumieniem.
+    static void partial(const Cipher& cipher, const void* const iv, const u64 index, const int skip,
+                        const u8* in, u8* out, const int n) noexcept
+    {
+        u32 ks[BlockWords];
+        counter_block(iv, index, reinterpret_cast<u8*>(ks));
+        cipher.encrypt_block(ks, ks);
+        Crypto::xor_bytes(out, in, reinterpret_cast<const u8*>(ks) + skip, n);
+        Crypto::clear_bytes(ks, sizeof(ks));
+    }
+
+    static void increment(u8* const counter) noexcept {
+        for (int i = BlockSize - 1; i >= 0; i--) {
+            if (++counter[i]) {
+                break;
+            }
+        }
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_CTR_H
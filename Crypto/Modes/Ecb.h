@@ -0,0 +1,88 @@
+#ifndef BEESOFT_CRYPTO_MODES_ECB_H
+#define BEESOFT_CRYPTO_MODES_ECB_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Ecb
+ * Przetwarzanie bloków w trybie ECB dla wszystkich szyfrów blokowych.
+ * Bloki są niezależne, a kontekst szyfru jest po utworzeniu tylko czytany,
+ * więc dane od progu Parallel::threshold() są dzielone między wątki.
+ * Granice fragmentów są wielokrotnością zarówno bloku, jak i linii
+ * pamięci podręcznej (wątki nie dzielą linii wyniku), a każdy fragment
+ * jest przetwarzany kernelem wieloblokowym. Wynik jest identyczny
+ * z przetwarzaniem jednowątkowym.
+ */
+template<typename Cipher>
+class Ecb {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int Grain = Parallel::grain(BlockSize);   // najmniejszy fragment jednego wątku
+
+public:
+    /**
+     * @brief encrypt
+     * Szyfrowanie nblocks bloków (src i dst mogą być tym samym buforem).
+     */
+    static void encrypt(const Cipher& cipher, const u32* const src, u32* const dst, const int nblocks) noexcept {
+        if (nblocks * BlockSize >= Parallel::threshold()) {
+            Parallel::for_each(nblocks, Grain, [&](const int begin, const int end) {
+                cipher.encrypt_blocks(src + begin * BlockWords, dst + begin * BlockWords, end - begin);
+            });
+        } else {
+            cipher.encrypt_blocks(src, dst, nblocks);
+        }
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie nblocks bloków (src i dst mogą być tym samym buforem).
+     */
+    static void decrypt(const Cipher& cipher, const u32* const src, u32* const dst, const int nblocks) noexcept {
+        if (nblocks * BlockSize >= Parallel::threshold()) {
+            Parallel::for_each(nblocks, Grain, [&](const int begin, const int end) {
+                cipher.decrypt_blocks(src + begin * BlockWords, dst + begin * BlockWords, end - begin);
+            });
+        } else {
+            cipher.decrypt_blocks(src, dst, nblocks);
+        }
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_ECB_H
@@ -0,0 +1,171 @@
+#ifndef BEESOFT_CRYPTO_MODES_ETM_H
+#define BEESOFT_CRYPTO_MODES_ETM_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include "Crypto/Crypto.h"
+#include "Crypto/Modes/Cmac.h"
+#include "Crypto/Modes/Ctr.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Etm
+ * Szyfrowanie uwierzytelnione w schemacie encrypt-then-MAC:
+ * szyfrowanie w trybie CTR (@see Ctr) i znacznik CMAC (@see Cmac)
+ * wyznaczany z osobnego kontekstu (para kluczy).
+ * Znacznik obejmuje: długość danych dodatkowych (64 bity, big-endian),
+ * dane dodatkowe (AD), IV i szyfrogram.
+ * Format wyniku: IV || szyfrogram || znacznik (BlockSize bajtów);
+ * pusty tekst jawny też dostaje IV i znacznik (uwierzytelnia same AD).
+ * Szyfrowanie jest jednoprzebiegowe: dane są przetwarzane fragmentami
+ * mieszczącymi się w L1, a każdy zaszyfrowany fragment trafia do CMAC
+ * zanim opuści pamięć podręczną.
+ * Przy deszyfrowaniu znacznik jest sprawdzany przed deszyfrowaniem;
+ * przy błędnym znaczniku dane nie są deszyfrowane wcale.
+ */
+template<typename Cipher>
+class Etm {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int TileSize = 4096;   // bajty przetwarzane między szyfrowaniem a MAC
+
+public:
+    static constexpr int TagSize = Cmac<Cipher>::TagSize;
+
+    /**
+     * @brief encrypt
+     * Szyfrowanie uwierzytelnione. Jeśli IV nie został przekazany
+     * to zostanie losowo wygenerowany.
+     *
+     * @param cipher - kontekst szyfru danych.
+     * @param mac - kontekst szyfru znacznika (inny klucz niż cipher).
+     * @param data - adres jawnych danych.
+     * @param nbytes - rozmiar jawnych danych w bajtach.
+     * @param ad - adres danych dodatkowych (uwierzytelnianych, nieszyfrowanych; może być nullptr).
+     * @param adbytes - rozmiar danych dodatkowych w bajtach.
+     * @param iv - adres wektora IV (może być nullptr).
+     * @return - tuple: adres bufora (IV + szyfrogram + znacznik) + jego rozmiar w bajtach
+     *           (rozmiar -1 przy niepoprawnych argumentach).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt(const Cipher& cipher, const Cipher& mac, const void* const data, const int nbytes,
+            const void* const ad = nullptr, const int adbytes = 0, const void* const iv = nullptr) noexcept
+    {
+        if (nbytes < 0 || (data == nullptr && nbytes > 0)) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int size = BlockSize + nbytes + TagSize;
+        u8* const out = new u8[size];
+        if (iv) {
+            memcpy(out, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(out, BlockSize);
+        }
+
+        Cmac<Cipher> cmac(mac);
+        header(cmac, ad, adbytes, out);
+        const u8* const in = static_cast<const u8*>(data);
+        u8* const ct = out + BlockSize;
+        for (int done = 0; done < nbytes; done += TileSize) {
+            const int n = std::min(TileSize, nbytes - done);
+            Ctr<Cipher>::crypt(cipher, out, u64(done), in + done, ct + done, n);
+            cmac.update(ct + done, n);
+        }
+        cmac.finalize(ct + nbytes);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+    /**
+     * @brief decrypt
+     * Sprawdzenie znacznika i (tylko gdy jest poprawny) deszyfrowanie.
+     *
+     * @param cipher - kontekst szyfru danych.
+     * @param mac - kontekst szyfru znacznika.
+     * @param data - adres danych (IV + szyfrogram + znacznik).
+     * @param nbytes - rozmiar danych w bajtach.
+     * @param ad - adres danych dodatkowych (może być nullptr).
+     * @param adbytes - rozmiar danych dodatkowych w bajtach.
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar 0 dla uwierzytelnionej pustej wiadomości,
+     *           -1 gdy dane są krótsze niż IV + znacznik lub znacznik jest niepoprawny).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt(const Cipher& cipher, const Cipher& mac, const void* const data, const int nbytes,
+            const void* const ad = nullptr, const int adbytes = 0) noexcept
+    {
+        if (data == nullptr || nbytes < BlockSize + TagSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const u8* const in = static_cast<const u8*>(data);
+        const int size = nbytes - BlockSize - TagSize;
+        const u8* const ct = in + BlockSize;
+
+        u8 tag[TagSize];
+        Cmac<Cipher> cmac(mac);
+        header(cmac, ad, adbytes, in);
+        cmac.update(ct, size);
+        cmac.finalize(tag);
+        if (!Crypto::verify_bytes(tag, ct + size, TagSize)) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        if (size == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+
+        u8* const out = new u8[size];
+        Ctr<Cipher>::crypt(cipher, in, 0, ct, out, size);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+private:
+    /// Początek danych uwierzytelnianych: długość AD, AD i IV.
+    static void header(Cmac<Cipher>& cmac, const void* const ad, const int adbytes, const u8* const iv) noexcept {
+        const u64 n = (ad == nullptr) ? 0 : u64(std::max(adbytes, 0));
+        u8 length[8];
+        for (int i = 0; i < 8; i++) {
+            length[i] = u8(n >> (56 - 8 * i));
+        }
+        cmac.update(length, sizeof(length));
+        if (n) {
+            cmac.update(ad, int(n));
+        }
+        cmac.update(iv, BlockSize);
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_ETM_H
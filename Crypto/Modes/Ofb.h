@@ -0,0 +1,153 @@
+#ifndef BEESOFT_CRYPTO_MODES_OFB_H
+#define BEESOFT_CRYPTO_MODES_OFB_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Ofb
+ * Tryb sprzężenia zwrotnego wyjścia (OFB) dla wszystkich szyfrów blokowych.
+ * Strumień powstaje przez wielokrotne szyfrowanie IV i nie zależy od danych,
+ * dlatego szyfrowanie i deszyfrowanie to ta sama operacja (XOR).
+ * Tryb nie wymaga paddingu. Obiekt klasy jest strumieniowym
+ * szyfratorem/deszyfratorem przyjmującym dane w porcjach dowolnej długości.
+ * Kolejne bloki strumienia zależą od poprzednich, więc tryb jest sekwencyjny.
+ */
+template<typename Cipher>
+class Ofb {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+
+    const Cipher& cipher;
+    u32 ks[BlockWords];     // bieżący blok strumienia
+    int used = BlockSize;   // liczba wykorzystanych bajtów strumienia
+
+public:
+    /**
+     * @brief Ofb
+     * Utworzenie strumieniowego szyfratora/deszyfratora.
+     *
+     * @param cipher - kontekst szyfru (musi istnieć przez cały czas życia obiektu).
+     * @param iv - wektor IV (BlockSize bajtów).
+     */
+    Ofb(const Cipher& cipher, const void* const iv) noexcept : cipher(cipher) {
+        memcpy(ks, iv, BlockSize);
+    }
+    ~Ofb() {
+        Crypto::clear_bytes(ks, sizeof(ks));
+    }
+    Ofb(const Ofb&) = delete;
+    Ofb& operator=(const Ofb&) = delete;
+
+    /**
+     * @brief update
+     * Przetworzenie kolejnej porcji danych (dowolnej długości).
+     * Bufory src i dst mogą być tym samym buforem.
+     *
+     * @param src - adres danych wejściowych.
+     * @param dst - adres bufora wynikowego.
+     * @param nbytes - liczba bajtów.
+     */
+    void update(const void* const src, void* const dst, int nbytes) noexcept {
+        const u8* in = static_cast<const u8*>(src);
+        u8* out = static_cast<u8*>(dst);
+
+        while (nbytes > 0) {
+            if (used == BlockSize) {
+                cipher.encrypt_block(ks, ks);
+                used = 0;
+            }
+            const int n = std::min(nbytes, BlockSize - used);
+            Crypto::xor_bytes(out, in, reinterpret_cast<const u8*>(ks) + used, n);
+            used += n;
+            in += n;
+            out += n;
+            nbytes -= n;
+        }
+    }
+
+    /**
+     * @brief encrypt
+     * Szyfrowanie w trybie OFB. Jeśli IV nie został przekazany
+     * to zostanie losowo wygenerowany. Wektor IV jest pierwszym blokiem
+     * zaszyfrowanych danych, dane nie są uzupełniane paddingiem.
+     *
+     * @return - tuple: adres bufora (IV + zaszyfrowane dane) + jego rozmiar w bajtach.
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt(const Cipher& cipher, const void* const data, const int nbytes, const void* iv) noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        u8* const out = new u8[nbytes + BlockSize];
+        if (iv) {
+            memcpy(out, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(out, BlockSize);
+        }
+        Ofb(cipher, out).update(data, out + BlockSize, nbytes);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes + BlockSize);
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie w trybie OFB (pierwszym blokiem danych jest IV).
+     *
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar -1 gdy dane są krótsze od bloku).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt(const Cipher& cipher, const void* const data, const int nbytes) noexcept {
+        if (data == nullptr || nbytes == 0) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        if (nbytes < BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const int size = nbytes - BlockSize;
+        u8* const out = new u8[std::max(size, 1)];
+        const u8* const in = static_cast<const u8*>(data);
+        Ofb(cipher, in).update(in + BlockSize, out, size);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_OFB_H
@@ -0,0 +1,172 @@
+#ifndef BEESOFT_CRYPTO_MODES_SIV_H
+#define BEESOFT_CRYPTO_MODES_SIV_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "Crypto/Crypto.h"
+#include "Crypto/Modes/Cmac.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Siv
+ * Deterministyczne szyfrowanie uwierzytelnione w stylu SIV:
+ * syntetyczny IV (V) jest znacznikiem CMAC danych, a dane są szyfrowane
+ * w trybie CTR z licznikiem V. Te same dane (i dane dodatkowe) przy tym
+ * samym kluczu dają zawsze ten sam szyfrogram, co pozwala deduplikować
+ * zaszyfrowane fragmenty.
+ * V jest wyznaczany dwupoziomowo, żeby MAC dużych danych można było liczyć
+ * równolegle: każdy fragment (ChunkSize bajtów) ma własny znacznik CMAC
+ * (prefiks 0x00 || numer fragmentu), a V to CMAC z prefiksem 0x01
+ * długości i treści danych dodatkowych, długości danych i znaczników
+ * fragmentów. Szyfrowanie CTR jest równoległe (@see Ctr).
+ * Format wyniku: V || szyfrogram; pusty tekst jawny daje samo V.
+ */
+template<typename Cipher>
+class Siv {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int ChunkSize = 64 * 1024;     // fragment z własnym znacznikiem
+
+public:
+    /**
+     * @brief encrypt
+     * Szyfrowanie deterministyczne.
+     *
+     * @param cipher - kontekst szyfru danych.
+     * @param mac - kontekst szyfru znacznika (inny klucz niż cipher).
+     * @param data - adres jawnych danych.
+     * @param nbytes - rozmiar jawnych danych w bajtach.
+     * @param ad - adres danych dodatkowych (może być nullptr).
+     * @param adbytes - rozmiar danych dodatkowych w bajtach.
+     * @return - tuple: adres bufora (V + szyfrogram) + jego rozmiar w bajtach
+     *           (rozmiar -1 przy niepoprawnych argumentach).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    encrypt(const Cipher& cipher, const Cipher& mac, const void* const data, const int nbytes,
+            const void* const ad = nullptr, const int adbytes = 0) noexcept
+    {
+        if (nbytes < 0 || (data == nullptr && nbytes > 0)) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        u8* const out = new u8[nbytes + BlockSize];
+        synthetic_iv(mac, static_cast<const u8*>(data), nbytes, ad, adbytes, out);
+        Ctr<Cipher>::crypt(cipher, out, 0, data, out + BlockSize, nbytes);
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes + BlockSize);
+    }
+
+    /**
+     * @brief decrypt
+     * Deszyfrowanie i sprawdzenie syntetycznego IV; przy niezgodności
+     * odszyfrowane dane są czyszczone i nie są zwracane.
+     *
+     * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+     *           (rozmiar 0 dla uwierzytelnionej pustej wiadomości,
+     *           -1 gdy dane są krótsze niż V lub nieautentyczne).
+     */
+    static std::tuple<std::shared_ptr<void>, int>
+    decrypt(const Cipher& cipher, const Cipher& mac, const void* const data, const int nbytes,
+            const void* const ad = nullptr, const int adbytes = 0) noexcept
+    {
+        if (data == nullptr || nbytes < BlockSize) {
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        const u8* const in = static_cast<const u8*>(data);
+        const int size = nbytes - BlockSize;
+        u8* const out = new u8[std::max(size, 1)];
+        Ctr<Cipher>::crypt(cipher, in, 0, in + BlockSize, out, size);
+
+        u8 v[BlockSize];
+        synthetic_iv(mac, out, size, ad, adbytes, v);
+        if (!Crypto::verify_bytes(v, in, BlockSize)) {
+            Crypto::clear_bytes(out, size);
+            delete[] out;
+            return std::make_tuple(std::shared_ptr<void>(nullptr), -1);
+        }
+        if (size == 0) {
+            delete[] out;
+            return std::make_tuple(std::shared_ptr<void>(nullptr), 0);
+        }
+        return std::make_tuple(std::shared_ptr<void>(out, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
+    }
+
+private:
+    static void synthetic_iv(const Cipher& mac, const u8* const data, const int nbytes,
+                             const void* const ad, const int adbytes, u8* const v) noexcept
+    {
+        const int chunks = (nbytes + ChunkSize - 1) / ChunkSize;
+        std::vector<u8> tags(size_t(chunks) * BlockSize);
+        auto leaves = [&](const int begin, const int end) {
+            Cmac<Cipher> cmac(mac);
+            for (int i = begin; i < end; i++) {
+                u8 prefix[9] = {0x00};
+                encode(u64(i), prefix + 1);
+                cmac.update(prefix, sizeof(prefix));
+                cmac.update(data + i * ChunkSize, std::min(ChunkSize, nbytes - i * ChunkSize));
+                cmac.finalize(tags.data() + i * BlockSize);
+            }
+        };
+        if (nbytes >= Parallel::threshold()) {
+            Parallel::for_each(chunks, 1, leaves);
+        } else {
+            leaves(0, chunks);
+        }
+
+        const int n = (ad == nullptr) ? 0 : std::max(adbytes, 0);
+        u8 prefix[17] = {0x01};
+        encode(u64(n), prefix + 1);
+        encode(u64(nbytes), prefix + 9);
+        Cmac<Cipher> cmac(mac);
+        cmac.update(prefix, sizeof(prefix));
+        if (n) {
+            cmac.update(ad, n);
+        }
+        cmac.update(tags.data(), int(tags.size()));
+        cmac.finalize(v);
+    }
+
+    static void encode(const u64 value, u8* const out) noexcept {
+        for (int i = 0; i < 8; i++) {
+            out[i] = u8(value >> (56 - 8 * i));
+        }
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_SIV_H
@@ -0,0 +1,247 @@
+#ifndef BEESOFT_CRYPTO_MODES_XTS_H
+#define BEESOFT_CRYPTO_MODES_XTS_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Xts
+ * Tryb sektorowy z tweakiem (w stylu XTS, IEEE 1619) dla wszystkich
+ * szyfrów blokowych. Każdy sektor (np. strona 4 KB pliku) jest szyfrowany
+ * niezależnie, w miejscu i bez zmiany rozmiaru, więc dowolną stronę można
+ * odczytać lub zapisać bez dotykania pozostałych.
+ * Tweak pierwszego bloku to numer sektora (little-endian) zaszyfrowany
+ * drugim kontekstem szyfru; tweak kolejnego bloku to poprzedni pomnożony
+ * przez x w ciele GF(2^n) (n = 8 * BlockSize):
+ *  - GF(2^64): x^64 + x^4 + x^3 + x + 1,
+ *  - GF(2^96): x^96 + x^10 + x^9 + x^6 + 1.
+ * Sektor, którego rozmiar nie jest wielokrotnością bloku (np. 4096 bajtów
+ * dla Way3), jest obsługiwany przez kradzież szyfrogramu (ciphertext stealing).
+ * Funkcje wsadowe przetwarzają wiele sektorów naraz, dzieląc je między wątki
+ * (@see Parallel), a bloki sektora kernelem wieloblokowym szyfru.
+ */
+template<typename Cipher>
+class Xts {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+    static constexpr int TileBlocks = 64;
+    static_assert(BlockSize == 8 || BlockSize == 12, "Xts: unsupported block size");
+
+public:
+    /// Opis sektora dla funkcji wsadowych.
+    struct Sector {
+        u64 index;      // numer sektora
+        void* data;     // dane sektora (przetwarzane w miejscu)
+        int nbytes;     // rozmiar sektora (co najmniej BlockSize)
+    };
+
+    /**
+     * @brief encrypt_sector
+     * Szyfrowanie (w miejscu) jednego sektora.
+     *
+     * @param cipher - kontekst szyfru danych.
+     * @param tweak - kontekst szyfru tweaku (inny klucz niż cipher).
+     * @param index - numer sektora.
+     * @param data - adres danych sektora.
+     * @param nbytes - rozmiar sektora w bajtach (co najmniej BlockSize).
+     * @return false gdy sektor jest krótszy od bloku.
+     */
+    static bool encrypt_sector(const Cipher& cipher, const Cipher& tweak, const u64 index, void* const data, const int nbytes) noexcept {
+        return process(cipher, tweak, index, static_cast<u8*>(data), nbytes, true);
+    }
+
+    /**
+     * @brief decrypt_sector
+     * Deszyfrowanie (w miejscu) jednego sektora.
+     * @see encrypt_sector
+     */
+    static bool decrypt_sector(const Cipher& cipher, const Cipher& tweak, const u64 index, void* const data, const int nbytes) noexcept {
+        return process(cipher, tweak, index, static_cast<u8*>(data), nbytes, false);
+    }
+
+    /**
+     * @brief encrypt_sectors
+     * Szyfrowanie (w miejscu) wielu sektorów; duże wsady są dzielone między wątki.
+     *
+     * @param cipher - kontekst szyfru danych.
+     * @param tweak - kontekst szyfru tweaku.
+     * @param sectors - tablica opisów sektorów.
+     * @param count - liczba sektorów.
+     * @return liczba przetworzonych sektorów lub -1 gdy któryś sektor jest
+     *         krótszy od bloku (wtedy żaden sektor nie jest zmieniany).
+     */
+    static int encrypt_sectors(const Cipher& cipher, const Cipher& tweak, const Sector* const sectors, const int count) noexcept {
+        return batch(cipher, tweak, sectors, count, true);
+    }
+
+    /**
+     * @brief decrypt_sectors
+     * Deszyfrowanie (w miejscu) wielu sektorów.
+     * @see encrypt_sectors
+     */
+    static int decrypt_sectors(const Cipher& cipher, const Cipher& tweak, const Sector* const sectors, const int count) noexcept {
+        return batch(cipher, tweak, sectors, count, false);
+    }
+
+    /**
+     * @brief multiply
+     * Mnożenie tweaku (liczby little-endian) przez x w GF(2^n).
+     */
+    static void multiply(u8* const t) noexcept {
+        const u8 carry = t[BlockSize - 1] >> 7;
+        for (int i = BlockSize - 1; i > 0; i--) {
+            t[i] = u8((t[i] << 1) | (t[i - 1] >> 7));
+        }
+        t[0] = u8(t[0] << 1);
+        if (carry) {
+            if constexpr (BlockSize == 8) {
+                t[0] ^= 0x1b;
+            } else {
+                t[0] ^= 0x41;
+                t[1] ^= 0x06;
+            }
+        }
+    }
+
+private:
+    static int batch(const Cipher& cipher, const Cipher& tweak, const Sector* const sectors, const int count, const bool encrypting) noexcept {
+        if (count <= 0) {
+            return 0;
+        }
+        u64 total = 0;
+        for (int i = 0; i < count; i++) {
+            if (sectors[i].data == nullptr || sectors[i].nbytes < BlockSize) {
+                return -1;
+            }
+            total += u64(sectors[i].nbytes);
+        }
+        auto run = [&](const int begin, const int end) {
+            for (int i = begin; i < end; i++) {
+                process(cipher, tweak, sectors[i].index, static_cast<u8*>(sectors[i].data), sectors[i].nbytes, encrypting);
+            }
+        };
+        if (total >= u64(Parallel::threshold())) {
+            Parallel::for_each(count, 1, run);
+        } else {
+            run(0, count);
+        }
+        return count;
+    }
+
+    static bool process(const Cipher& cipher, const Cipher& tweak, const u64 index, u8* const data, const int nbytes, const bool encrypting) noexcept {
+        if (data == nullptr || nbytes < BlockSize) {
+            return false;
+        }
+        u32 t[BlockWords] = {};
+        u8* const tb = reinterpret_cast<u8*>(t);
+        for (int i = 0; i < 8; i++) {
+            tb[i] = u8(index >> (8 * i));
+        }
+        tweak.encrypt_block(t, t);
+
+        const int nblocks = nbytes / BlockSize;
+        const int rest = nbytes % BlockSize;
+        // przy kradzieży szyfrogramu dwa ostatnie bloki są przetwarzane osobno
+        const int body = rest ? nblocks - 1 : nblocks;
+        crypt_blocks(cipher, tb, data, body, encrypting);
+
+        if (rest) {
+            u8* const last = data + body * BlockSize;     // ostatni pełny blok
+            u8* const tail = last + BlockSize;            // niepełny blok
+            u8 t2[BlockSize];
+            memcpy(t2, tb, BlockSize);
+            multiply(t2);
+            // szyfrowanie: (T_m-1, T_m), deszyfrowanie: (T_m, T_m-1)
+            u8 block[BlockSize];
+            memcpy(block, last, BlockSize);
+            crypt_block(cipher, encrypting ? tb : t2, block, encrypting);
+            u8 stolen[BlockSize];
+            memcpy(stolen, tail, rest);
+            memcpy(stolen + rest, block + rest, BlockSize - rest);
+            memcpy(tail, block, rest);
+            crypt_block(cipher, encrypting ? t2 : tb, stolen, encrypting);
+            memcpy(last, stolen, BlockSize);
+            Crypto::clear_bytes(block, sizeof(block));
+            Crypto::clear_bytes(stolen, sizeof(stolen));
+        }
+        Crypto::clear_bytes(t, sizeof(t));
+        return true;
+    }
+
+    /// Przetworzenie nblocks pełnych bloków; po powrocie t zawiera tweak następnego bloku.
+    static void crypt_blocks(const Cipher& cipher, u8* const t, u8* data, int nblocks, const bool encrypting) noexcept {
+        u32 tweaks[TileBlocks * BlockWords];
+        u32 buffer[TileBlocks * BlockWords];
+        while (nblocks > 0) {
+            const int n = std::min(nblocks, TileBlocks);
+            u8* tw = reinterpret_cast<u8*>(tweaks);
+            for (int i = 0; i < n; i++, tw += BlockSize) {
+                memcpy(tw, t, BlockSize);
+                multiply(t);
+            }
+            const int size = n * BlockSize;
+            Crypto::xor_bytes(buffer, data, tweaks, size);
+            if (encrypting) {
+                cipher.encrypt_blocks(buffer, buffer, n);
+            } else {
+                cipher.decrypt_blocks(buffer, buffer, n);
+            }
+            Crypto::xor_bytes(data, buffer, tweaks, size);
+            data += size;
+            nblocks -= n;
+        }
+        Crypto::clear_bytes(tweaks, sizeof(tweaks));
+        Crypto::clear_bytes(buffer, sizeof(buffer));
+    }
+
+    static void crypt_block(const Cipher& cipher, const u8* const t, u8* const block, const bool encrypting) noexcept {
+        u32 buffer[BlockWords];
+        Crypto::xor_bytes(buffer, block, t, BlockSize);
+        if (encrypting) {
+            cipher.encrypt_block(buffer, buffer);
+        } else {
+            cipher.decrypt_block(buffer, buffer);
+        }
+        Crypto::xor_bytes(block, buffer, t, BlockSize);
+        Crypto::clear_bytes(buffer, sizeof(buffer));
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MODES_XTS_H
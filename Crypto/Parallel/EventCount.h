@@ -0,0 +1,120 @@
+#ifndef BEESOFT_CRYPTO_EVENTCOUNT_H
+#define BEESOFT_CRYPTO_EVENTCOUNT_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <atomic>
+#include <climits>
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief EventCount
+ * Usypianie bezczynnych wątków bez blokady (w stylu futex).
+ * Wątek czekający pobiera klucz (@see prepare), ponownie sprawdza
+ * warunek i dopiero wtedy zasypia (@see wait). Powiadomienie zmienia
+ * epokę, więc powiadomienie między prepare a wait nie zostanie zgubione.
+ * Gdy nikt nie czeka, notify to tylko jedna operacja atomowa.
+ * Poza Linuksem oczekiwanie sprowadza się do oddawania procesora.
+ */
+class EventCount {
+    std::atomic<u32> epoch{0};
+    std::atomic<int> waiters{0};
+
+public:
+    /**
+     * @brief prepare
+     * Zgłoszenie zamiaru zaśnięcia.
+     * @return klucz dla wait lub cancel.
+     */
+    u32 prepare() noexcept {
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief cancel
+     * Rezygnacja z zaśnięcia (warunek spełnił się po prepare).
+     */
+    void cancel() noexcept {
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief wait
+     * Uśpienie do powiadomienia, które nastąpiło po prepare.
+     * @param key - klucz zwrócony przez prepare.
+     */
+    void wait(const u32 key) noexcept {
+        while (epoch.load(std::memory_order_acquire) == key) {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<u32*>(&epoch), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+            std::this_thread::yield();
+#endif
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_one() noexcept {
+        notify(1);
+    }
+
+    void notify_all() noexcept {
+        notify(INT_MAX);
+    }
+
+private:
+    void notify(const int count) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+        epoch.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<u32*>(&epoch), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+        (void)count;
+#endif
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_EVENTCOUNT_H
@@ -0,0 +1,183 @@
+#ifndef BEESOFT_CRYPTO_MPMCQUEUE_H
+#define BEESOFT_CRYPTO_MPMCQUEUE_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief MpmcQueue
+ * Ograniczona, bezblokadowa kolejka wielu producentów i wielu
+ * konsumentów (pierścień D. Vyukova). Każda komórka ma numer sekwencji,
+ * który mówi, czy jest gotowa do zapisu, czy do odczytu, więc producenci
+ * i konsumenci synchronizują się tylko jedną operacją CAS na swoim
+ * indeksie. Konsument może pobrać kilka elementów jednym CAS (@see pop_bulk).
+ * Pojemność jest zaokrąglana w górę do potęgi dwójki.
+ */
+template<typename T>
+class MpmcQueue {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(CacheLineSize) std::atomic<size_t> tail{0};    // producenci
+    alignas(CacheLineSize) std::atomic<size_t> head{0};    // konsumenci
+
+public:
+    explicit MpmcQueue(const int capacity)
+        : mask(round_up(capacity) - 1)
+        , cells(new Cell[mask + 1])
+    {
+        for (size_t i = 0; i <= mask; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    int capacity() const noexcept {
+        return int(mask + 1);
+    }
+
+    /**
+     * @brief push
+     * Wstawienie elementu na koniec kolejki.
+     * @param value - element (przenoszony tylko przy powodzeniu).
+     * @return false gdy kolejka jest pełna.
+     */
+    bool push(T&& value) noexcept {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief pop
+     * Pobranie elementu z początku kolejki.
+     * @param value - pobrany element.
+     * @return false gdy kolejka jest pusta.
+     */
+    bool pop(T& value) noexcept {
+        return pop_bulk(&value, 1) == 1;
+    }
+
+    /**
+     * @brief pop_bulk
+     * Pobranie do max elementów z początku kolejki jednym CAS.
+     * Pobierane są kolejne elementy już gotowe do odczytu.
+     *
+     * @param values - bufor na co najmniej max elementów.
+     * @param max - maksymalna liczba elementów.
+     * @return liczba pobranych elementów (0 gdy kolejka jest pusta).
+     */
+    int pop_bulk(T* const values, const int max) noexcept {
+        size_t pos = head.load(std::memory_order_relaxed);
+        int n;
+        for (;;) {
+            n = 0;
+            while (n < max) {
+                const size_t seq = cells[(pos + n) & mask].sequence.load(std::memory_order_acquire);
+                const auto diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + n + 1);
+                if (diff != 0) {
+                    if (n == 0 && diff > 0) {
+                        n = -1;     // inny konsument przesunął już początek
+                    }
+                    break;
+                }
+                n++;
+            }
+            if (n == 0) {
+                return 0;
+            }
+            if (n < 0) {
+                pos = head.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            Cell& cell = cells[(pos + i) & mask];
+            values[i] = std::move(cell.data);
+            cell.sequence.store(pos + i + mask + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    /**
+     * @brief empty
+     * @return true gdy kolejka jest (w chwili sprawdzenia) pusta.
+     */
+    bool empty() const noexcept {
+        const size_t pos = head.load(std::memory_order_acquire);
+        return cells[pos & mask].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+private:
+    static size_t round_up(const int capacity) noexcept {
+        size_t n = 2;
+        while (n < size_t(capacity)) {
+            n <<= 1;
+        }
+        return n;
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_MPMCQUEUE_H
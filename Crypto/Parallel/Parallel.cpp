@@ -0,0 +1,154 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "Parallel.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+using namespace std;
+
+static constexpr int DefaultThreshold = 256 * 1024;  // in bytes
+
+static atomic<int> workers{max(1, int(thread::hardware_concurrency()))};
+static atomic<int> min_bytes{DefaultThreshold};
+static mutex executor_mutex;
+static shared_ptr<Executor> current_executor;
+
+/**
+ * @brief concurrency
+ * @return liczba wątków, na które dzielona jest praca.
+ */
+int Parallel::concurrency() noexcept {
+    return workers.load(memory_order_relaxed);
+}
+
+/**
+ * @brief set_concurrency
+ * Ustawienie liczby wątków (1 wyłącza przetwarzanie równoległe).
+ *
+ * @param n - liczba wątków.
+ */
+void Parallel::set_concurrency(const int n) noexcept {
+    workers.store(max(1, n), memory_order_relaxed);
+}
+
+/**
+ * @brief threshold
+ * @return minimalny rozmiar danych (w bajtach) przetwarzanych równolegle.
+ */
+int Parallel::threshold() noexcept {
+    return min_bytes.load(memory_order_relaxed);
+}
+
+/**
+ * @brief set_threshold
+ * Ustawienie minimalnego rozmiaru danych (w bajtach) przetwarzanych równolegle.
+ *
+ * @param nbytes - próg w bajtach.
+ */
+void Parallel::set_threshold(const int nbytes) noexcept {
+    min_bytes.store(max(0, nbytes), memory_order_relaxed);
+}
+
+/**
+ * @brief executor
+ * Wykonawca fragmentów pracy równoległej. Domyślnie jest to wspólna
+ * pula wątków biblioteki (tworzona przy pierwszym użyciu), w której
+ * jeden wątek mniej niż procesorów - wątek wywołujący też pracuje.
+ *
+ * @return bieżący wykonawca.
+ */
+shared_ptr<Executor> Parallel::executor() noexcept {
+    lock_guard<mutex> lock(executor_mutex);
+    if (!current_executor) {
+        const int cpus = int(thread::hardware_concurrency());
+        current_executor = make_shared<ThreadPool>(max(1, cpus - 1));
+    }
+    return current_executor;
+}
+
+/**
+ * @brief set_executor
+ * Podłączenie wykonawcy aplikacji (nullptr przywraca pulę domyślną).
+ * Zadania zlecone wcześniej wykonywane są przez poprzedniego wykonawcę.
+ *
+ * @param executor - nowy wykonawca.
+ */
+void Parallel::set_executor(shared_ptr<Executor> executor) noexcept {
+    lock_guard<mutex> lock(executor_mutex);
+    current_executor = move(executor);
+}
+
+/**
+ * @brief for_each
+ * Podział zakresu [0, count) na fragmenty i wykonanie ich równolegle.
+ * Granice fragmentów są wielokrotnością ziarna. Pierwszy fragment
+ * wykonywany jest w wątku wywołującym, pozostałe przez wykonawcę
+ * (@see executor); funkcja wraca po zakończeniu wszystkich fragmentów.
+ * Wywołania zagnieżdżone są dozwolone.
+ *
+ * @param count - liczba elementów (np. bloków).
+ * @param grain - ziarno podziału (minimalny fragment).
+ * @param fn - funkcja wykonywana dla fragmentu [begin, end).
+ */
+void Parallel::for_each(const int count, const int grain, const function<void(int, int)>& fn) noexcept {
+    if (count <= 0) {
+        return;
+    }
+    const int g = max(1, grain);
+    const int chunks = min(concurrency(), (count + g - 1) / g);
+    if (chunks <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    // rozmiar fragmentu zaokrąglony w górę do wielokrotności ziarna
+    const int step = ((count + chunks - 1) / chunks + g - 1) / g * g;
+    const auto exec = executor();
+    atomic<int> remaining{0};
+    for (int begin = step; begin < count; begin += step) {
+        const int end = min(count, begin + step);
+        remaining.fetch_add(1, memory_order_relaxed);
+        exec->execute([&fn, &remaining, begin, end] {
+            fn(begin, end);
+            remaining.fetch_sub(1, memory_order_release);
+        });
+    }
+    fn(0, min(count, step));
+    exec->wait([&remaining] { return remaining.load(memory_order_acquire) == 0; });
+}
+
+}} // namespaces
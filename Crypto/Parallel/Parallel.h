@@ -0,0 +1,81 @@
+#ifndef BEESOFT_CRYPTO_PARALLEL_H
+#define BEESOFT_CRYPTO_PARALLEL_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/ThreadPool.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Parallel
+ * Podział pracy trybów szyfrowania na wątki.
+ * Tryby, w których bloki są niezależne (CTR, deszyfrowanie CBC/CFB, ...),
+ * dzielą dane większe od progu (@see threshold) na fragmenty
+ * o rozmiarze będącym wielokrotnością ziarna (np. bloku szyfru).
+ * Fragmenty wykonywane są przez wspólną pulę wątków biblioteki
+ * lub przez wykonawcę ustawionego przez aplikację (@see set_executor).
+ */
+class Parallel {
+public:
+    static int  concurrency() noexcept;
+    static void set_concurrency(const int) noexcept;
+    static int  threshold() noexcept;
+    static void set_threshold(const int) noexcept;
+    static std::shared_ptr<Executor> executor() noexcept;
+    static void set_executor(std::shared_ptr<Executor>) noexcept;
+
+    static void for_each(const int, const int, const std::function<void(int, int)>&) noexcept;
+
+    /**
+     * @brief grain
+     * Najmniejszy fragment (w blokach) dla trybów z niezależnymi blokami:
+     * ok. 4 KB zaokrąglone do wspólnej wielokrotności bloku i linii
+     * pamięci podręcznej, więc wątki nie dzielą linii wyniku.
+     *
+     * @param block_size - rozmiar bloku szyfru w bajtach.
+     * @return liczba bloków.
+     */
+    static constexpr int grain(const int block_size) noexcept {
+        const int unit = std::lcm(block_size, CacheLineSize);
+        return unit * std::max(1, 4096 / unit) / block_size;
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_PARALLEL_H
@@ -0,0 +1,275 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "ThreadPool.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+using namespace std;
+
+// wątek puli: do której puli należy, jego numer i bufor roboczy
+static thread_local const ThreadPool* local_pool = nullptr;
+static thread_local int local_index = -1;
+static thread_local vector<u8>* local_scratch = nullptr;
+
+/**
+ * @brief ThreadPool
+ * Uruchomienie wątków puli.
+ *
+ * @param n - liczba wątków (0 - liczba procesorów).
+ * @param affinity - czy przypiąć wątki do kolejnych procesorów.
+ */
+ThreadPool::ThreadPool(const int n, const bool affinity) {
+    const int cpus = max(1, int(thread::hardware_concurrency()));
+    const int count = (n > 0) ? n : cpus;
+
+    workers.reserve(count);
+    for (int i = 0; i < count; i++) {
+        workers.push_back(make_unique<Worker>());
+    }
+    // wątki startują dopiero, gdy wszystkie kolejki już istnieją
+    for (int i = 0; i < count; i++) {
+        workers[i]->thread = thread([this, i] { work(i); });
+        if (affinity) {
+            pin(workers[i]->thread, i % cpus);
+        }
+    }
+}
+
+/**
+ * @brief ~ThreadPool
+ * Wykonanie pozostałych zadań i zakończenie wątków.
+ */
+ThreadPool::~ThreadPool() {
+    stopping.store(true, memory_order_seq_cst);
+    idle.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief execute
+ * Zlecenie zadania. W wątku puli zadanie trafia do jego kolejki,
+ * w pozostałych wątkach - do kolejki wspólnej. Gdy kolejka wspólna
+ * jest pełna, wątek zlecający sam wykonuje oczekujące zadania.
+ *
+ * @param task - zadanie do wykonania.
+ */
+void ThreadPool::execute(Task&& task) noexcept {
+    const int index = self();
+    pending.fetch_add(1, memory_order_seq_cst);
+    if (index >= 0) {
+        auto& worker = *workers[index];
+        lock_guard<mutex> lock(worker.mutex);
+        worker.tasks.push_back(move(task));
+    } else {
+        while (!injected.push(move(task))) {
+            if (!run_one(-1)) {
+                this_thread::yield();
+            }
+        }
+    }
+    idle.notify_one();
+}
+
+/**
+ * @brief wait
+ * Oczekiwanie na spełnienie warunku z wykonywaniem w tym czasie
+ * oczekujących zadań (także przez wątki spoza puli).
+ *
+ * @param done - warunek zakończenia oczekiwania.
+ */
+void ThreadPool::wait(const function<bool()>& done) noexcept {
+    const int index = self();
+    while (!done()) {
+        if (!run_one(index)) {
+            this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @brief scratch
+ * Bufor roboczy bieżącego wątku. Wątki puli mają własne bufory,
+ * pozostałe wątki - bufor lokalny wątku. Bufor jest ważny do
+ * kolejnego wywołania w tym samym wątku.
+ *
+ * @param nbytes - minimalny rozmiar bufora w bajtach.
+ * @return wskaźnik na bufor.
+ */
+u8* ThreadPool::scratch(const int nbytes) noexcept {
+    static thread_local vector<u8> fallback;
+    auto& buffer = local_scratch ? *local_scratch : fallback;
+    if (int(buffer.size()) < nbytes) {
+        buffer.resize(nbytes);
+    }
+    return buffer.data();
+}
+
+/**
+ * @brief self
+ * @return numer bieżącego wątku w tej puli lub -1.
+ */
+int ThreadPool::self() const noexcept {
+    return (local_pool == this) ? local_index : -1;
+}
+
+/**
+ * @brief pop
+ * Pobranie zadania: z własnej kolejki (od końca), z kolejki wspólnej
+ * (wątek puli pobiera kilka zadań, nadmiar odkłada do swojej kolejki),
+ * a na końcu podkradzenie z początku kolejki innego wątku.
+ *
+ * @param index - numer wątku puli lub -1.
+ * @param task - pobrane zadanie.
+ * @return true jeśli zadanie zostało pobrane.
+ */
+bool ThreadPool::pop(const int index, Task& task) noexcept {
+    if (pending.load(memory_order_acquire) <= 0) {
+        return false;
+    }
+    if (index >= 0) {
+        auto& worker = *workers[index];
+        lock_guard<mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = move(worker.tasks.back());
+            worker.tasks.pop_back();
+            pending.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    if (index >= 0) {
+        Task batch[InjectionBatch];
+        const int n = injected.pop_bulk(batch, InjectionBatch);
+        if (n > 0) {
+            task = move(batch[0]);
+            if (n > 1) {
+                auto& worker = *workers[index];
+                lock_guard<mutex> lock(worker.mutex);
+                for (int i = 1; i < n; i++) {
+                    worker.tasks.push_back(move(batch[i]));
+                }
+            }
+            pending.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    } else if (injected.pop(task)) {
+        pending.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+    const int count = size();
+    for (int i = 1; i <= count; i++) {
+        auto& victim = *workers[(max(index, 0) + i) % count];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief run_one
+ * Wykonanie jednego oczekującego zadania.
+ *
+ * @param index - numer wątku puli lub -1.
+ * @return true jeśli zadanie zostało wykonane.
+ */
+bool ThreadPool::run_one(const int index) noexcept {
+    Task task;
+    if (pop(index, task)) {
+        task();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief work
+ * Pętla wątku puli.
+ *
+ * @param index - numer wątku.
+ */
+void ThreadPool::work(const int index) noexcept {
+    local_pool = this;
+    local_index = index;
+    local_scratch = &workers[index]->scratch;
+
+    for (;;) {
+        if (run_one(index)) {
+            continue;
+        }
+        const u32 key = idle.prepare();
+        if (pending.load(memory_order_seq_cst) > 0) {
+            idle.cancel();
+            continue;
+        }
+        if (stopping.load(memory_order_seq_cst)) {
+            idle.cancel();
+            break;
+        }
+        idle.wait(key);
+    }
+
+    local_scratch = nullptr;
+    local_index = -1;
+    local_pool = nullptr;
+}
+
+/**
+ * @brief pin
+ * Przypięcie wątku do procesora (tylko Linux).
+ *
+ * @param t - wątek.
+ * @param cpu - numer procesora.
+ */
+void ThreadPool::pin(thread& t, [[maybe_unused]] const int cpu) noexcept {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t;
+#endif
+}
+
+}} // namespaces
@@ -0,0 +1,135 @@
+#ifndef BEESOFT_CRYPTO_THREADPOOL_H
+#define BEESOFT_CRYPTO_THREADPOOL_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Crypto/Crypto.h"
+#include "Crypto/Parallel/EventCount.h"
+#include "Crypto/Parallel/MpmcQueue.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief Executor
+ * Interfejs wykonawcy zadań, na którym biblioteka uruchamia pracę
+ * równoległą (@see Parallel::set_executor). Aplikacja może podłączyć
+ * własną implementację, np. pulę wątków serwera, aby biblioteka
+ * nie tworzyła dodatkowych wątków.
+ */
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    virtual ~Executor() = default;
+
+    /**
+     * @brief execute
+     * Zlecenie wykonania zadania (w dowolnym wątku, także w wywołującym).
+     */
+    virtual void execute(Task&&) noexcept = 0;
+
+    /**
+     * @brief wait
+     * Oczekiwanie na spełnienie warunku. Domyślnie oddaje procesor;
+     * pula wątków w tym czasie wykonuje oczekujące zadania.
+     */
+    virtual void wait(const std::function<bool()>& done) noexcept {
+        while (!done()) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+/**
+ * @brief ThreadPool
+ * Pula wątków z podkradaniem zadań (work stealing). Każdy wątek ma
+ * własną kolejkę: zadania zlecone z wątku puli trafiają do jego kolejki
+ * (LIFO), zlecone z zewnątrz - do wspólnej kolejki bezblokadowej
+ * (@see MpmcQueue). Bezczynny wątek pobiera z kolejki wspólnej kilka
+ * zadań naraz (nadmiar trafia do jego kolejki, skąd mogą go podkraść
+ * inni), a następnie podkrada zadania z początku kolejek pozostałych
+ * wątków. Wątki bez pracy śpią na futeksie (@see EventCount).
+ * Oczekiwanie w wątku puli
+ * (@see wait) wykonuje w tym czasie inne zadania, więc zagnieżdżone
+ * wywołania Parallel::for_each nie blokują puli.
+ */
+class ThreadPool : public Executor {
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::vector<u8> scratch;
+        std::thread thread;
+    };
+
+    static constexpr int InjectionCapacity = 4096;   // zadania w kolejce wspólnej
+    static constexpr int InjectionBatch = 8;         // zadania pobierane naraz
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    MpmcQueue<Task> injected{InjectionCapacity};
+    EventCount idle;
+    std::atomic<int> pending{0};
+    std::atomic<bool> stopping{false};
+
+public:
+    explicit ThreadPool(const int = 0, const bool = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const noexcept {
+        return int(workers.size());
+    }
+
+    void execute(Task&&) noexcept override;
+    void wait(const std::function<bool()>&) noexcept override;
+
+    static u8* scratch(const int) noexcept;
+
+private:
+    int self() const noexcept;
+    bool pop(const int, Task&) noexcept;
+    bool run_one(const int) noexcept;
+    void work(const int) noexcept;
+    static void pin(std::thread&, const int) noexcept;
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_THREADPOOL_H
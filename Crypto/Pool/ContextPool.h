@@ -0,0 +1,157 @@
+#ifndef BEESOFT_CRYPTO_CONTEXTPOOL_H
+#define BEESOFT_CRYPTO_CONTEXTPOOL_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief ContextPool
+ * Pula wstępnie zaalokowanych kontekstów szyfrujących (Blowfish, Gost, Way3).
+ * Kontekst pobrany z puli jest inicjowany kluczem w miejscu (@see rekey),
+ * a po zwolnieniu jest czyszczony i wraca do puli.
+ * Dzięki temu zmiana klucza (np. kolejny klient) nie wymaga alokacji pamięci.
+ */
+template<typename Cipher, typename Allocator = std::allocator<Cipher>>
+class ContextPool {
+    std::vector<Cipher, Allocator> contexts;
+    std::vector<int> free_list;
+    mutable std::mutex mutex;
+
+public:
+    /**
+     * @brief Lease
+     * Kontekst wypożyczony z puli. Po zniszczeniu obiektu kontekst
+     * jest czyszczony i zwracany do puli.
+     */
+    class Lease {
+        ContextPool* pool = nullptr;
+        int index = -1;
+    public:
+        Lease() = default;
+        Lease(ContextPool* const p, const int idx) noexcept : pool(p), index(idx) {}
+        ~Lease() { release(); }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other) noexcept : pool(other.pool), index(other.index) {
+            other.pool = nullptr;
+            other.index = -1;
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                pool = other.pool;
+                index = other.index;
+                other.pool = nullptr;
+                other.index = -1;
+            }
+            return *this;
+        }
+
+        explicit operator bool() const noexcept { return pool != nullptr; }
+        const Cipher& operator*() const noexcept { return pool->contexts[index]; }
+        const Cipher* operator->() const noexcept { return &pool->contexts[index]; }
+
+        void release() noexcept {
+            if (pool) {
+                pool->put_back(index);
+                pool = nullptr;
+                index = -1;
+            }
+        }
+    };
+
+    explicit ContextPool(const int capacity, const Allocator& allocator = Allocator())
+        : contexts(capacity, allocator)
+    {
+        free_list.reserve(capacity);
+        for (int i = capacity - 1; i >= 0; i--) {
+            free_list.push_back(i);
+        }
+    }
+
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+
+    /**
+     * @brief acquire
+     * Pobranie wolnego kontekstu z puli i ustawienie w nim klucza.
+     *
+     * @param key - klucz od użytkownika.
+     * @param key_size - rozmiar klucza w bajtach.
+     * @return kontekst lub pusty obiekt (false) jeśli pula jest wyczerpana
+     *         albo klucz jest niepoprawny.
+     */
+    Lease acquire(const void* const key, const int key_size) noexcept {
+        int index = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (free_list.empty()) {
+                return Lease();
+            }
+            index = free_list.back();
+            free_list.pop_back();
+        }
+        // ustawienie klucza poza sekcją krytyczną
+        if (!contexts[index].rekey(key, key_size)) {
+            put_back(index);
+            return Lease();
+        }
+        return Lease(this, index);
+    }
+
+    int capacity() const noexcept {
+        return int(contexts.size());
+    }
+
+    int available() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return int(free_list.size());
+    }
+
+private:
+    void put_back(const int index) noexcept {
+        contexts[index].clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        free_list.push_back(index);
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_CONTEXTPOOL_H
@@ -0,0 +1,233 @@
+#ifndef BEESOFT_CRYPTO_RESERVOIR_KEYSTREAM_RESERVOIR_H
+#define BEESOFT_CRYPTO_RESERVOIR_KEYSTREAM_RESERVOIR_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Crypto/Crypto.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Modes/Ofb.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief KeystreamReservoir
+ * Zapas strumienia klucza (CTR lub OFB) wygenerowany z wyprzedzeniem.
+ * Wątek w tle uzupełnia bufor cykliczny dużymi porcjami (kernelem
+ * wieloblokowym), gdy liczba dostępnych bajtów spadnie poniżej progu
+ * (watermark). Na ścieżce żądania szyfrowanie sprowadza się do XOR
+ * z gotowym strumieniem.
+ * Kolejne żądania dostają kolejne (rozłączne) fragmenty strumienia;
+ * funkcja crypt zwraca pozycję fragmentu w strumieniu, którą należy
+ * przekazać odbiorcy (w trybie CTR odszyfruje on dane przez crypt_ctr).
+ * Kontekst szyfru musi istnieć przez cały czas życia obiektu.
+ */
+template<typename Cipher>
+class KeystreamReservoir {
+    static constexpr int BatchSize = 16 * 1024;     // bajty strumienia na jedno uzupełnienie
+
+public:
+    enum class Mode { Ctr, Ofb };
+
+    struct Stats {
+        u64 requests = 0;   // liczba żądań
+        u64 bytes = 0;      // liczba bajtów zaszyfrowanych ze zbiornika
+        u64 drains = 0;     // żądania, które musiały czekać na strumień
+        u64 refills = 0;    // liczba porcji wygenerowanych w tle
+    };
+
+    /**
+     * @brief KeystreamReservoir
+     * Utworzenie zbiornika; bufor jest od razu w całości wypełniany.
+     *
+     * @param cipher - kontekst szyfru.
+     * @param iv - wektor IV (BlockSize bajtów).
+     * @param mode - rodzaj strumienia (CTR lub OFB).
+     * @param capacity - rozmiar bufora w bajtach.
+     * @param watermark - próg (w bajtach), poniżej którego bufor jest uzupełniany
+     *                    (domyślnie połowa pojemności, co najmniej jeden blok).
+     */
+    KeystreamReservoir(const Cipher& cipher, const void* const iv, const Mode mode = Mode::Ctr,
+                       const int capacity = 256 * 1024, const int watermark = -1)
+        : cipher(cipher)
+        , mode(mode)
+        , capacity(std::max(capacity, Cipher::BlockSize))
+        , watermark(watermark < 0 ? this->capacity / 2 : std::clamp(watermark, Cipher::BlockSize, this->capacity))
+        , buffer(new u8[this->capacity])
+        , ofb(cipher, iv)
+    {
+        memcpy(this->iv, iv, Cipher::BlockSize);
+        while (tail < u64(this->capacity)) {
+            produce();
+        }
+        worker = std::thread(&KeystreamReservoir::run, this);
+    }
+
+    ~KeystreamReservoir() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        refill.notify_one();
+        worker.join();
+        Crypto::clear_bytes(buffer.get(), capacity);
+        Crypto::clear_bytes(iv, sizeof(iv));
+    }
+
+    KeystreamReservoir(const KeystreamReservoir&) = delete;
+    KeystreamReservoir& operator=(const KeystreamReservoir&) = delete;
+
+    /**
+     * @brief crypt
+     * Szyfrowanie/odszyfrowanie (XOR) danych kolejnym fragmentem strumienia.
+     * Bufory src i dst mogą być tym samym buforem.
+     *
+     * @param src - adres danych wejściowych.
+     * @param dst - adres bufora wynikowego.
+     * @param nbytes - liczba bajtów.
+     * @return pozycja pierwszego bajtu danych w strumieniu.
+     */
+    u64 crypt(const void* const src, void* const dst, int nbytes) noexcept {
+        std::lock_guard<std::mutex> order(request);
+        const u8* in = static_cast<const u8*>(src);
+        u8* out = static_cast<u8*>(dst);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        const u64 offset = head;
+        stats.requests++;
+        if (tail - head < u64(nbytes)) {
+            stats.drains++;
+        }
+        while (nbytes > 0) {
+            ready.wait(lock, [this] { return tail > head; });
+            const u64 start = head;
+            const int pos = int(start % capacity);
+            const int n = int(std::min<u64>({u64(nbytes), tail - start, u64(capacity - pos)}));
+            lock.unlock();
+
+            // fragment [head, tail) nie jest modyfikowany przez wątek w tle
+            u8* const ks = buffer.get() + pos;
+            Crypto::xor_bytes(out, in, ks, n);
+            Crypto::clear_bytes(ks, n);
+            in += n;
+            out += n;
+            nbytes -= n;
+
+            lock.lock();
+            head += n;
+            stats.bytes += n;
+            if (tail - head < u64(watermark)) {
+                refill.notify_one();
+            }
+        }
+        return offset;
+    }
+
+    /// Liczba bajtów strumienia gotowych do użycia.
+    int available() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return int(tail - head);
+    }
+
+    Stats statistics() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    const Cipher& cipher;
+    const Mode mode;
+    const int capacity;
+    const int watermark;
+    std::unique_ptr<u8[]> buffer;
+    u8 iv[Cipher::BlockSize];
+    Ofb<Cipher> ofb;                // stan strumienia OFB (używany tylko przez wątek w tle)
+
+    mutable std::mutex mutex;       // chroni head, tail, stats i stop
+    std::mutex request;             // zachowuje ciągłość fragmentów kolejnych żądań
+    std::condition_variable refill;
+    std::condition_variable ready;
+    u64 head = 0;                   // pozycja pierwszego niewykorzystanego bajtu strumienia
+    u64 tail = 0;                   // pozycja końca wygenerowanego strumienia
+    bool stop = false;
+    Stats stats;
+    std::thread worker;
+
+    void run() noexcept {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            refill.wait(lock, [this] { return stop || tail - head < u64(watermark); });
+            if (stop) {
+                return;
+            }
+            while (!stop && tail - head < u64(capacity)) {
+                lock.unlock();
+                produce();
+                lock.lock();
+                ready.notify_all();
+            }
+        }
+    }
+
+    /// Wygenerowanie jednej porcji strumienia (bez przekraczania końca bufora).
+    void produce() noexcept {
+        u64 start, free;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            start = tail;
+            free = u64(capacity) - (tail - head);
+        }
+        const int pos = int(start % capacity);
+        const int n = int(std::min<u64>({u64(BatchSize), free, u64(capacity - pos)}));
+        u8* const ks = buffer.get() + pos;
+
+        memset(ks, 0, n);
+        if (mode == Mode::Ctr) {
+            Ctr<Cipher>::crypt(cipher, iv, start, ks, ks, n);
+        } else {
+            ofb.update(ks, ks, n);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        tail += n;
+        stats.refills++;
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_RESERVOIR_KEYSTREAM_RESERVOIR_H
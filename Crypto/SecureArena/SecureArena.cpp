@@ -0,0 +1,130 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <sys/mman.h>
+#include <unistd.h>
+#include <iostream>
+#include "SecureArena.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+using namespace std;
+
+/**
+ * @brief SecureArena
+ * Konstruktor. Rezerwuje obszar o rozmiarze zaokrąglonym do wielokrotności
+ * strony plus po jednej stronie ochronnej przed i za obszarem.
+ * Jeśli mlock się nie powiedzie (np. limit RLIMIT_MEMLOCK) obszar
+ * jest nadal używalny, ale nie jest zablokowany (@see is_locked).
+ *
+ * @param nbytes - wymagany rozmiar obszaru w bajtach.
+ */
+SecureArena::SecureArena(const size_t nbytes) {
+    const size_t page = size_t(sysconf(_SC_PAGESIZE));
+    capacity = ((nbytes + page - 1) / page) * page;
+    if (capacity == 0) {
+        capacity = page;
+    }
+    region_size = capacity + 2 * page;
+
+    void* const ptr = mmap(nullptr, region_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        cerr << "Error (secure arena): mmap failed" << endl;
+        capacity = 0;
+        region_size = 0;
+        return;
+    }
+    region = static_cast<u8*>(ptr);
+    base = region + page;
+
+    if (mprotect(base, capacity, PROT_READ | PROT_WRITE) != 0) {
+        cerr << "Error (secure arena): mprotect failed" << endl;
+        munmap(region, region_size);
+        region = base = nullptr;
+        capacity = 0;
+        region_size = 0;
+        return;
+    }
+    locked = (mlock(base, capacity) == 0);
+    madvise(base, capacity, MADV_DONTDUMP);
+}
+
+SecureArena::~SecureArena() {
+    if (region) {
+        Crypto::clear_bytes(base, int(capacity));
+        if (locked) {
+            munlock(base, capacity);
+        }
+        munmap(region, region_size);
+    }
+}
+
+/**
+ * @brief allocate
+ * Przydział bloku pamięci z obszaru.
+ *
+ * @param nbytes - rozmiar bloku w bajtach.
+ * @param alignment - wymagane wyrównanie (potęga dwójki).
+ * @return adres bloku lub nullptr gdy brakuje miejsca.
+ */
+void* SecureArena::allocate(const size_t nbytes, const size_t alignment) noexcept {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (base == nullptr) {
+        return nullptr;
+    }
+    const size_t offset = (used + alignment - 1) & ~(alignment - 1);
+    if (offset > capacity || nbytes > capacity - offset) {
+        return nullptr;
+    }
+    used = offset + nbytes;
+    return base + offset;
+}
+
+/**
+ * @brief reset
+ * Wyczyszczenie całego obszaru i zwolnienie wszystkich przydziałów.
+ * Obiekty umieszczone w obszarze nie mogą być później używane.
+ */
+void SecureArena::reset() noexcept {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (base) {
+        Crypto::clear_bytes(base, int(used));
+    }
+    used = 0;
+}
+
+size_t SecureArena::in_use() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
+
+}} // namespaces
@@ -0,0 +1,114 @@
+#ifndef BEESOFT_CRYPTO_SECUREARENA_H
+#define BEESOFT_CRYPTO_SECUREARENA_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief SecureArena
+ * Obszar pamięci na dane tajne (klucze, rozwinięte klucze szyfrów).
+ * Pamięć jest zablokowana w RAM (mlock, nie trafia do swap),
+ * wyłączona ze zrzutów pamięci i otoczona stronami ochronnymi
+ * (przekroczenie zakresu kończy się SIGSEGV).
+ * Przydział jest liniowy; całość jest czyszczona jednym wywołaniem (@see reset)
+ * oraz przy niszczeniu obiektu.
+ */
+class SecureArena {
+    u8* region = nullptr;       // cały obszar wraz ze stronami ochronnymi
+    size_t region_size = 0;
+    u8* base = nullptr;         // obszar do przydziału
+    size_t capacity = 0;
+    size_t used = 0;
+    bool locked = false;
+    mutable std::mutex mutex;
+
+public:
+    explicit SecureArena(const size_t);
+    ~SecureArena();
+
+    SecureArena(const SecureArena&) = delete;
+    SecureArena& operator=(const SecureArena&) = delete;
+
+    void* allocate(const size_t, const size_t = CacheLineSize) noexcept;
+    void reset() noexcept;
+
+    bool valid() const noexcept { return base != nullptr; }
+    bool is_locked() const noexcept { return locked; }
+    size_t size() const noexcept { return capacity; }
+    size_t in_use() const noexcept;
+};
+
+/**
+ * @brief SecureAllocator
+ * Alokator (zgodny z std::allocator) przydzielający pamięć z SecureArena.
+ * Pozwala umieścić np. pulę kontekstów szyfrów w zablokowanej pamięci:
+ * ContextPool<Blowfish, SecureAllocator<Blowfish>>.
+ * Zwolnienie pamięci następuje dopiero przy reset/zniszczeniu obszaru.
+ */
+template<typename T>
+class SecureAllocator {
+    template<typename U> friend class SecureAllocator;
+    SecureArena* arena;
+
+public:
+    using value_type = T;
+
+    explicit SecureAllocator(SecureArena& a) noexcept : arena(&a) {}
+    template<typename U>
+    SecureAllocator(const SecureAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(const size_t n) {
+        void* const ptr = arena->allocate(n * sizeof(T), alignof(T));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* const, const size_t) noexcept
+    {}
+
+    template<typename U>
+    bool operator==(const SecureAllocator<U>& other) const noexcept { return arena == other.arena; }
+    template<typename U>
+    bool operator!=(const SecureAllocator<U>& other) const noexcept { return arena != other.arena; }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_SECUREARENA_H
@@ -0,0 +1,171 @@
+#ifndef BEESOFT_CRYPTO_SEGMENTS_H
+#define BEESOFT_CRYPTO_SEGMENTS_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <sys/uio.h>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/**
+ * @brief SegmentReader
+ * Sekwencyjny odczyt danych z listy segmentów (iovec, jak w readv).
+ * Pozwala czytać dane przekraczające granice segmentów bez ich łączenia.
+ */
+class SegmentReader {
+    const iovec* segments;
+    int count;
+    int index = 0;
+    size_t pos = 0;
+
+public:
+    SegmentReader(const iovec* const s, const int n) noexcept : segments(s), count(n) {
+        skip_empty();
+    }
+
+    /// Liczba bajtów dostępnych w bieżącym segmencie (bez kopiowania).
+    size_t contiguous() const noexcept {
+        return (index < count) ? (segments[index].iov_len - pos) : 0;
+    }
+
+    /// Adres bieżącej pozycji w bieżącym segmencie.
+    const u8* data() const noexcept {
+        return static_cast<const u8*>(segments[index].iov_base) + pos;
+    }
+
+    /// Przesunięcie pozycji (nbytes <= contiguous()).
+    void advance(const size_t nbytes) noexcept {
+        pos += nbytes;
+        skip_empty();
+    }
+
+    /**
+     * @brief read
+     * Odczyt (z ewentualnym przejściem przez granice segmentów)
+     * co najwyżej nbytes bajtów.
+     *
+     * @return liczba odczytanych bajtów.
+     */
+    int read(void* const dst, const int nbytes) noexcept {
+        u8* out = static_cast<u8*>(dst);
+        int done = 0;
+        while (done < nbytes && index < count) {
+            const size_t n = std::min(size_t(nbytes - done), contiguous());
+            memcpy(out + done, data(), n);
+            done += int(n);
+            advance(n);
+        }
+        return done;
+    }
+
+    static size_t total(const iovec* const s, const int n) noexcept {
+        size_t nbytes = 0;
+        for (int i = 0; i < n; i++) {
+            nbytes += s[i].iov_len;
+        }
+        return nbytes;
+    }
+
+private:
+    void skip_empty() noexcept {
+        while (index < count && pos >= segments[index].iov_len) {
+            ++index;
+            pos = 0;
+        }
+    }
+};
+
+/**
+ * @brief SegmentWriter
+ * Sekwencyjny zapis danych do listy segmentów (iovec, jak w writev).
+ */
+class SegmentWriter {
+    const iovec* segments;
+    int count;
+    int index = 0;
+    size_t pos = 0;
+
+public:
+    SegmentWriter(const iovec* const s, const int n) noexcept : segments(s), count(n) {
+        skip_full();
+    }
+
+    /// Liczba bajtów wolnych w bieżącym segmencie.
+    size_t contiguous() const noexcept {
+        return (index < count) ? (segments[index].iov_len - pos) : 0;
+    }
+
+    /// Adres bieżącej pozycji w bieżącym segmencie.
+    u8* data() const noexcept {
+        return static_cast<u8*>(segments[index].iov_base) + pos;
+    }
+
+    /// Przesunięcie pozycji (nbytes <= contiguous()).
+    void advance(const size_t nbytes) noexcept {
+        pos += nbytes;
+        skip_full();
+    }
+
+    /**
+     * @brief write
+     * Zapis nbytes bajtów (z ewentualnym przejściem przez granice segmentów).
+     *
+     * @return liczba zapisanych bajtów.
+     */
+    int write(const void* const src, const int nbytes) noexcept {
+        const u8* in = static_cast<const u8*>(src);
+        int done = 0;
+        while (done < nbytes && index < count) {
+            const size_t n = std::min(size_t(nbytes - done), contiguous());
+            memcpy(data(), in + done, n);
+            done += int(n);
+            advance(n);
+        }
+        return done;
+    }
+
+private:
+    void skip_full() noexcept {
+        while (index < count && pos >= segments[index].iov_len) {
+            ++index;
+            pos = 0;
+        }
+    }
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_SEGMENTS_H
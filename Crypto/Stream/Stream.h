@@ -0,0 +1,438 @@
+#ifndef BEESOFT_CRYPTO_STREAM_H
+#define BEESOFT_CRYPTO_STREAM_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include "Crypto/Crypto.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Modes/Cfb.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Modes/Ofb.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+
+/// Tryb pracy szyfratora/deszyfratora strumieniowego.
+enum class StreamMode {
+    Cbc,
+    Ctr,
+    Cfb,
+    Cfb8,
+    Ofb
+};
+
+/**
+ * @brief Encryptor
+ * Szyfrowanie strumienia danych podawanego w porcjach (update/finalize).
+ * Wynik jest identyczny z jednorazowym szyfrowaniem całych danych
+ * (encrypt_cbc, encrypt_ctr, ...): najpierw IV, potem szyfrogram.
+ * Obiekt przechowuje tylko stan łańcucha i niepełny blok, więc zużycie
+ * pamięci nie zależy od długości strumienia.
+ * update zapisuje co najwyżej nbytes + Overhead bajtów,
+ * finalize - co najwyżej Overhead bajtów.
+ */
+template<typename Cipher>
+class Encryptor {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+
+public:
+    static constexpr int Overhead = 2 * BlockSize;
+
+    /**
+     * @brief Encryptor
+     *
+     * @param cipher - kontekst szyfru (musi istnieć przez cały czas życia obiektu).
+     * @param mode - tryb pracy.
+     * @param iv - wektor IV (nullptr: losowy).
+     * @param padding - rodzaj paddingu (tylko dla CBC).
+     */
+    Encryptor(const Cipher& cipher, const StreamMode mode = StreamMode::Cbc,
+              const void* const iv = nullptr, const Padding padding = Padding::Iso7816) noexcept
+        : cipher(cipher)
+        , mode(mode)
+        , padding(padding)
+    {
+        if (iv) {
+            memcpy(this->iv, iv, BlockSize);
+        } else {
+            Crypto::random_bytes(this->iv, BlockSize);
+        }
+        memcpy(chain, this->iv, BlockSize);
+        if (mode == StreamMode::Cfb || mode == StreamMode::Cfb8) {
+            cfb.emplace(cipher, this->iv, false, (mode == StreamMode::Cfb) ? BlockSize : 1);
+        } else if (mode == StreamMode::Ofb) {
+            ofb.emplace(cipher, this->iv);
+        }
+    }
+    ~Encryptor() {
+        Crypto::clear_bytes(chain, sizeof(chain));
+        Crypto::clear_bytes(buffer, sizeof(buffer));
+    }
+    Encryptor(const Encryptor&) = delete;
+    Encryptor& operator=(const Encryptor&) = delete;
+
+    /**
+     * @brief update
+     * Zaszyfrowanie kolejnej porcji danych. W trybie CBC niepełny blok
+     * (a dla Padding::Cts także ostatni pełny) czeka na kolejne dane.
+     *
+     * @param src - adres jawnych danych.
+     * @param nbytes - liczba bajtów.
+     * @param dst - bufor wynikowy (co najmniej nbytes + Overhead bajtów).
+     * @return liczba zapisanych bajtów (-1 po finalize).
+     */
+    int update(const void* const src, int nbytes, void* const dst) noexcept {
+        if (finished || nbytes < 0) {
+            return -1;
+        }
+        if (nbytes == 0) {
+            return 0;
+        }
+        const u8* in = static_cast<const u8*>(src);
+        u8* out = static_cast<u8*>(dst);
+        if (!started) {
+            memcpy(out, iv, BlockSize);
+            out += BlockSize;
+            started = true;
+        }
+
+        switch (mode) {
+        case StreamMode::Ctr:
+            Ctr<Cipher>::crypt(cipher, iv, offset, in, out, nbytes);
+            offset += u64(nbytes);
+            return int(out - static_cast<u8*>(dst)) + nbytes;
+        case StreamMode::Cfb:
+        case StreamMode::Cfb8:
+            cfb->update(in, out, nbytes);
+            return int(out - static_cast<u8*>(dst)) + nbytes;
+        case StreamMode::Ofb:
+            ofb->update(in, out, nbytes);
+            return int(out - static_cast<u8*>(dst)) + nbytes;
+        case StreamMode::Cbc:
+            break;
+        }
+
+        // bloki do zaszyfrowania teraz: w buforze zostaje co najwyżej limit bajtów
+        const int limit = (padding == Padding::Cts) ? 2 * BlockSize : BlockSize - 1;
+        const int total = buffered + nbytes;
+        int nblocks = (total > limit) ? (total - limit + BlockSize - 1) / BlockSize : 0;
+
+        while (nblocks > 0 && buffered > 0) {
+            const int take = std::max(0, BlockSize - buffered);
+            memcpy(buffer + buffered, in, take);
+            in += take;
+            nbytes -= take;
+            encrypt_block(buffer, out);
+            out += BlockSize;
+            buffered += take - BlockSize;
+            memmove(buffer, buffer + BlockSize, buffered);
+            nblocks--;
+        }
+        for (; nblocks > 0; nblocks--) {
+            encrypt_block(in, out);
+            in += BlockSize;
+            out += BlockSize;
+            nbytes -= BlockSize;
+        }
+        memcpy(buffer + buffered, in, nbytes);
+        buffered += nbytes;
+        return int(out - static_cast<u8*>(dst));
+    }
+
+    /**
+     * @brief finalize
+     * Zakończenie strumienia: zaszyfrowanie ostatniego bloku z paddingiem
+     * (lub kradzieżą szyfrogramu). Pusty strumień daje pusty wynik.
+     *
+     * @param dst - bufor wynikowy (co najmniej Overhead bajtów).
+     * @return liczba zapisanych bajtów (-1 gdy danych nie można uzupełnić paddingiem).
+     */
+    int finalize(void* const dst) noexcept {
+        if (finished) {
+            return -1;
+        }
+        finished = true;
+        if (!started || mode != StreamMode::Cbc) {
+            return 0;
+        }
+        u8* const out = static_cast<u8*>(dst);
+        if (padding == Padding::Cts) {
+            const auto [data, size] = Cbc<Cipher>::encrypt_cts(cipher, buffer, buffered, chain);
+            if (size < 0) {
+                return -1;
+            }
+            memcpy(out, static_cast<const u8*>(data.get()) + BlockSize, size - BlockSize);
+            return size - BlockSize;
+        }
+        const int size = Crypto::padded_size(buffered, BlockSize, padding);
+        if (size < 0) {
+            return -1;
+        }
+        Crypto::pad(buffer, buffered, BlockSize, padding);
+        if (size > 0) {
+            encrypt_block(buffer, out);
+        }
+        return size;
+    }
+
+private:
+    void encrypt_block(const u8* const src, u8* const dst) noexcept {
+        u32 block[BlockWords];
+        memcpy(block, src, BlockSize);
+        for (int i = 0; i < BlockWords; i++) {
+            block[i] ^= chain[i];
+        }
+        cipher.encrypt_block(block, chain);
+        memcpy(dst, chain, BlockSize);
+    }
+
+    const Cipher& cipher;
+    const StreamMode mode;
+    const Padding padding;
+    u8 iv[BlockSize];
+    u32 chain[BlockWords];          // CBC: ostatni blok szyfrogramu
+    u8 buffer[2 * BlockSize];       // CBC: dane czekające na pełny blok
+    int buffered = 0;
+    u64 offset = 0;                 // CTR: pozycja w strumieniu
+    bool started = false;           // czy IV został już zapisany
+    bool finished = false;
+    std::optional<Cfb<Cipher>> cfb;
+    std::optional<Ofb<Cipher>> ofb;
+};
+
+/**
+ * @brief Decryptor
+ * Deszyfrowanie strumienia danych podawanego w porcjach (update/finalize).
+ * Pierwszy blok strumienia to IV. W trybie CBC ostatni pełny blok jest
+ * wstrzymywany do finalize, które usuwa z niego padding.
+ * Zużycie pamięci nie zależy od długości strumienia.
+ * update zapisuje co najwyżej nbytes + Overhead bajtów,
+ * finalize - co najwyżej Overhead bajtów.
+ */
+template<typename Cipher>
+class Decryptor {
+    static constexpr int BlockSize = Cipher::BlockSize;
+    static constexpr int BlockWords = BlockSize / int(sizeof(u32));
+
+public:
+    static constexpr int Overhead = 2 * BlockSize;
+
+    /**
+     * @brief Decryptor
+     *
+     * @param cipher - kontekst szyfru (musi istnieć przez cały czas życia obiektu).
+     * @param mode - tryb pracy.
+     * @param padding - rodzaj paddingu użyty przy szyfrowaniu (tylko dla CBC).
+     */
+    Decryptor(const Cipher& cipher, const StreamMode mode = StreamMode::Cbc,
+              const Padding padding = Padding::Iso7816) noexcept
+        : cipher(cipher)
+        , mode(mode)
+        , padding(padding)
+    {}
+    ~Decryptor() {
+        Crypto::clear_bytes(chain, sizeof(chain));
+        Crypto::clear_bytes(buffer, sizeof(buffer));
+    }
+    Decryptor(const Decryptor&) = delete;
+    Decryptor& operator=(const Decryptor&) = delete;
+
+    /**
+     * @brief update
+     * Odszyfrowanie kolejnej porcji danych.
+     *
+     * @param src - adres zaszyfrowanych danych.
+     * @param nbytes - liczba bajtów.
+     * @param dst - bufor wynikowy (co najmniej nbytes + Overhead bajtów).
+     * @return liczba zapisanych bajtów (-1 po finalize).
+     */
+    int update(const void* const src, int nbytes, void* const dst) noexcept {
+        if (finished || nbytes < 0) {
+            return -1;
+        }
+        const u8* in = static_cast<const u8*>(src);
+        u8* out = static_cast<u8*>(dst);
+        if (have < BlockSize) {
+            const int take = std::min(nbytes, BlockSize - have);
+            memcpy(iv + have, in, take);
+            have += take;
+            in += take;
+            nbytes -= take;
+            if (have == BlockSize) {
+                start();
+            }
+        }
+        if (nbytes == 0) {
+            return 0;
+        }
+
+        switch (mode) {
+        case StreamMode::Ctr:
+            Ctr<Cipher>::crypt(cipher, iv, offset, in, out, nbytes);
+            offset += u64(nbytes);
+            return nbytes;
+        case StreamMode::Cfb:
+        case StreamMode::Cfb8:
+            cfb->update(in, out, nbytes);
+            return nbytes;
+        case StreamMode::Ofb:
+            ofb->update(in, out, nbytes);
+            return nbytes;
+        case StreamMode::Cbc:
+            break;
+        }
+
+        // ostatni blok (dla Padding::Cts - dwa ostatnie) czeka na finalize
+        const int limit = (padding == Padding::Cts) ? 2 * BlockSize : BlockSize;
+        const int total = buffered + nbytes;
+        int nblocks = (total > limit) ? (total - limit + BlockSize - 1) / BlockSize : 0;
+
+        while (nblocks > 0 && buffered > 0) {
+            const int take = std::max(0, BlockSize - buffered);
+            memcpy(buffer + buffered, in, take);
+            in += take;
+            nbytes -= take;
+            decrypt_block(buffer, out);
+            out += BlockSize;
+            buffered += take - BlockSize;
+            memmove(buffer, buffer + BlockSize, buffered);
+            nblocks--;
+        }
+        if (nblocks > 0) {
+            // pierwszy blok z łańcuchem, pozostałe (niezależne) kernelem wieloblokowym
+            decrypt_block(in, out);
+            if (nblocks > 1) {
+                Cbc<Cipher>::decrypt_chain(cipher, in, nblocks - 1, out + BlockSize);
+                memcpy(chain, in + (nblocks - 1) * BlockSize, BlockSize);
+            }
+            in += nblocks * BlockSize;
+            out += nblocks * BlockSize;
+            nbytes -= nblocks * BlockSize;
+        }
+        memcpy(buffer + buffered, in, nbytes);
+        buffered += nbytes;
+        return int(out - static_cast<u8*>(dst));
+    }
+
+    /**
+     * @brief finalize
+     * Zakończenie strumienia: odszyfrowanie wstrzymanych bloków
+     * i usunięcie paddingu. Pusty strumień daje pusty wynik.
+     *
+     * @param dst - bufor wynikowy (co najmniej Overhead bajtów).
+     * @return liczba zapisanych bajtów (-1 przy niepoprawnym rozmiarze lub paddingu).
+     */
+    int finalize(void* const dst) noexcept {
+        if (finished) {
+            return -1;
+        }
+        finished = true;
+        if (have == 0) {
+            return 0;
+        }
+        if (have < BlockSize) {
+            return -1;
+        }
+        if (mode != StreamMode::Cbc) {
+            return 0;
+        }
+        u8* const out = static_cast<u8*>(dst);
+        if (padding == Padding::Cts) {
+            u8 data[3 * BlockSize];
+            memcpy(data, chain, BlockSize);
+            memcpy(data + BlockSize, buffer, buffered);
+            const auto [plain, size] = Cbc<Cipher>::decrypt_cts(cipher, data, BlockSize + buffered);
+            Crypto::clear_bytes(data, sizeof(data));
+            if (size < 0) {
+                return -1;
+            }
+            memcpy(out, plain.get(), size);
+            return size;
+        }
+        if (buffered == 0) {
+            return Crypto::unpad(out, 0, BlockSize, padding);
+        }
+        if (buffered != BlockSize) {
+            return -1;
+        }
+        u8 block[BlockSize];
+        decrypt_block(buffer, block);
+        const int size = Crypto::unpad(block, BlockSize, BlockSize, padding);
+        if (size > 0) {
+            memcpy(out, block, size);
+        }
+        Crypto::clear_bytes(block, BlockSize);
+        return size;
+    }
+
+private:
+    void start() noexcept {
+        memcpy(chain, iv, BlockSize);
+        if (mode == StreamMode::Cfb || mode == StreamMode::Cfb8) {
+            cfb.emplace(cipher, iv, true, (mode == StreamMode::Cfb) ? BlockSize : 1);
+        } else if (mode == StreamMode::Ofb) {
+            ofb.emplace(cipher, iv);
+        }
+    }
+
+    void decrypt_block(const u8* const src, u8* const dst) noexcept {
+        u32 next[BlockWords];
+        u32 block[BlockWords];
+        memcpy(next, src, BlockSize);
+        cipher.decrypt_block(next, block);
+        for (int i = 0; i < BlockWords; i++) {
+            block[i] ^= chain[i];
+        }
+        memcpy(chain, next, BlockSize);
+        memcpy(dst, block, BlockSize);
+    }
+
+    const Cipher& cipher;
+    const StreamMode mode;
+    const Padding padding;
+    u8 iv[BlockSize];
+    int have = 0;                   // odebrane bajty IV
+    u32 chain[BlockWords];          // CBC: ostatni blok szyfrogramu
+    u8 buffer[2 * BlockSize];       // CBC: wstrzymane bloki
+    int buffered = 0;
+    u64 offset = 0;                 // CTR: pozycja w strumieniu
+    bool finished = false;
+    std::optional<Cfb<Cipher>> cfb;
+    std::optional<Ofb<Cipher>> ofb;
+};
+
+}} // namespaces
+#endif // BEESOFT_CRYPTO_STREAM_H
@@ -32,6 +32,13 @@
 #include <cstring>
 #include "Way3.h"
 #include "Crypto/Crypto.h"
+#include "Crypto/Async/Async.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Modes/Cfb.h"
+#include "Crypto/Modes/Cmac.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Modes/Ecb.h"
+#include "Crypto/Modes/Ofb.h"
 
 /*------- namespaces:
 -------------------------------------------------------------------*/
@@ -40,25 +47,85 @@ namespace crypto {
 using namespace std;
 
 static constexpr int Nmbr = 11;         // number of rounds
-static constexpr int BlockSize = 12;    // in bytes (3xu32)
 static constexpr int KeySize = 12;      // in bytes
 static constexpr u32 ercon[12] = {0x0b0b, 0x1616, 0x2c2c, 0x5858, 0xb0b0, 0x7171, 0xe2e2, 0xd5d5, 0xbbbb, 0x6767, 0xcece, 0x8d8d};
 static constexpr u32 drcon[12] = {0xb1b1, 0x7373, 0xe6e6, 0xdddd, 0xabab, 0x4747, 0x8e8e, 0x0d0d, 0x1a1a, 0x3434, 0x6868, 0xd0d0};
 
-Way3::Way3()
+/**
+ * @brief Way3
+ * Konstruktor kontekstu bez klucza (np. dla puli kontekstów).
+ * Przed użyciem kontekst musi zostać zainicjowany kluczem (@see rekey).
+ */
+Way3::Way3() noexcept : k{}, ki{}
 {}
 
+/**
+ * @brief Way3
+ * Konstruktor z kluczem.
+ *
+ * @param key - klucz od użytkownika.
+ * @param key_size - rozmiar klucza w bajtach (musi wynosić 12).
+ */
 Way3::Way3(const void* const key, const int key_size) {
+    rekey(key, key_size);
+}
+
+Way3::~Way3() {
+    clear();
+}
+
+/**
+ * @brief Way3
+ * Konstruktor przenoszący. Kontekst źródłowy zostaje wyczyszczony.
+ *
+ * @param other - kontekst źródłowy.
+ */
+Way3::Way3(Way3&& other) noexcept {
+    memcpy(k, other.k, sizeof(k));
+    memcpy(ki, other.ki, sizeof(ki));
+    other.clear();
+}
+
+/**
+ * @brief operator=
+ * Przypisanie przenoszące. Kontekst źródłowy zostaje wyczyszczony.
+ *
+ * @param other - kontekst źródłowy.
+ * @return referencja do tego kontekstu.
+ */
+Way3& Way3::operator=(Way3&& other) noexcept {
+    if (this != &other) {
+        memcpy(k, other.k, sizeof(k));
+        memcpy(ki, other.ki, sizeof(ki));
+        other.clear();
+    }
+    return *this;
+}
+
+/**
+ * @brief rekey
+ * Inicjalizacja kontekstu (w miejscu) nowym kluczem.
+ *
+ * @param key - klucz od użytkownika.
+ * @param key_size - rozmiar klucza w bajtach (musi wynosić 12).
+ * @return true jeśli klucz został ustawiony, false przy błędnym rozmiarze klucza.
+ */
+bool Way3::rekey(const void* const key, const int key_size) noexcept {
     if (key_size != KeySize) {
         cerr << "Error (blowfish): invalid key size" << endl;
-        return;
+        return false;
     }
     memcpy(k, key, KeySize);
     memcpy(ki, key, KeySize);
     mu(theta(ki));
+    return true;
 }
 
-Way3::~Way3() {
+/**
+ * @brief clear
+ * Bezpieczne wyczyszczenie kontekstu.
+ */
+void Way3::clear() noexcept {
     Crypto::clear_bytes(k, 3 * sizeof(u32));
     Crypto::clear_bytes(ki, 3 * sizeof(u32));
 }
@@ -111,48 +178,113 @@ void Way3::decrypt_block(const u32* const src, u32* const dst) const noexcept {
     memcpy(dst, mu(theta(a)), BlockSize);
 }
 
+/**
+ * @brief encrypt_blocks
+ * Szyfrowanie wielu niezależnych bloków (tryb ECB bez paddingu).
+ * Bloki są przetwarzane po Lanes jednocześnie - rundy kolejnych bloków
+ * przeplatają się, co pozwala procesorowi wykonywać je równolegle.
+ * Bufory mogą być tym samym buforem (szyfrowanie w miejscu).
+ *
+ * @param src - adres bufora z jawnymi blokami.
+ * @param dst - adres bufora na zaszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Way3::encrypt_blocks(const u32* src, u32* dst, int nblocks) const noexcept {
+    for (; nblocks >= Lanes; nblocks -= Lanes, src += 3 * Lanes, dst += 3 * Lanes) {
+        u32 a[Lanes][3];
+        memcpy(a, src, sizeof(a));
+
+        for (int i = 0; i < Nmbr; i++) {
+            for (int l = 0; l < Lanes; l++) {
+                a[l][0] ^= (k[0] ^ (ercon[i] << 16));
+                a[l][1] ^= k[1];
+                a[l][2] ^= (k[2] ^ ercon[i]);
+                rho(a[l]);
+            }
+        }
+        for (int l = 0; l < Lanes; l++) {
+            a[l][0] ^= (k[0] ^ (ercon[Nmbr] << 16));
+            a[l][1] ^= k[1];
+            a[l][2] ^= (k[2] ^ ercon[Nmbr]);
+            theta(a[l]);
+        }
+        memcpy(dst, a, sizeof(a));
+    }
+    for (; nblocks > 0; nblocks--, src += 3, dst += 3) {
+        encrypt_block(src, dst);
+    }
+}
+
+/**
+ * @brief decrypt_blocks
+ * Odszyfrowanie wielu niezależnych bloków (@see encrypt_blocks).
+ *
+ * @param src - adres bufora z zaszyfrowanymi blokami.
+ * @param dst - adres bufora na odszyfrowane bloki.
+ * @param nblocks - liczba bloków.
+ */
+void Way3::decrypt_blocks(const u32* src, u32* dst, int nblocks) const noexcept {
+    for (; nblocks >= Lanes; nblocks -= Lanes, src += 3 * Lanes, dst += 3 * Lanes) {
+        u32 a[Lanes][3];
+        memcpy(a, src, sizeof(a));
+        for (int l = 0; l < Lanes; l++) {
+            mu(a[l]);
+        }
+
+        for (int i = 0; i < Nmbr; i++) {
+            for (int l = 0; l < Lanes; l++) {
+                a[l][0] ^= ki[0] ^ (drcon[i] << 16);
+                a[l][1] ^= ki[1];
+                a[l][2] ^= ki[2] ^ drcon[i];
+                rho(a[l]);
+            }
+        }
+        for (int l = 0; l < Lanes; l++) {
+            a[l][0] ^= ki[0] ^ (drcon[Nmbr] << 16);
+            a[l][1] ^= ki[1];
+            a[l][2] ^= ki[2] ^ drcon[Nmbr];
+            mu(theta(a[l]));
+        }
+        memcpy(dst, a, sizeof(a));
+    }
+    for (; nblocks > 0; nblocks--, src += 3, dst += 3) {
+        decrypt_block(src, dst);
+    }
+}
+
 /**
  * @brief encrypt_ecb
  * Szyfrowanie w trybie ECB.
  * Jeśli rozmiar jawnych danych nie jest wielokrotnością rozmiaru bloku
  * zostanie uzupełniony o tzw. padding.
+ * Duże dane są szyfrowane wielowątkowo (@see Ecb).
  *
  * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
  * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
- * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu (Cts nie jest obsługiwany w ECB).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 gdy danych nie można uzupełnić wskazanym paddingiem).
  */
 std::tuple<shared_ptr<void>, int>
-Way3::encrypt_ecb(const void* const data, const int nbytes) const noexcept {
+Way3::encrypt_ecb(const void* const data, const int nbytes, const Padding padding) const noexcept {
 
     if (data == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
 
-    int size = nbytes;
-    const int n = size % BlockSize;
-    u8* const plain = new u8[size + n];
-    memcpy(plain, data, size);
-    if (n) {
-        // Ponieważ rozmiar bufora danych do zaszyfrownia
-        // nie jest wielokrotnością bloku dodajemy padding
-        // o stosownej długości.
-        bzero(plain + size, n);
-        plain[size] = 128;
-        size += n;
+    const int size = (padding == Padding::Cts) ? -1 : Crypto::padded_size(nbytes, BlockSize, padding);
+    if (size < 0) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
 
+    // Szyfrowanie w miejscu, w buforze wynikowym.
     u8* const cipher = new u8[size];
+    memcpy(cipher, data, nbytes);
+    Crypto::pad(cipher, nbytes, BlockSize, padding);
 
-    u32* src = reinterpret_cast<u32*>(plain);
-    u32* dst = reinterpret_cast<u32*>(cipher);
+    u32* const dst = reinterpret_cast<u32*>(cipher);
+    Ecb<Way3>::encrypt(*this, dst, dst, size/BlockSize);
 
-    for (int i = 0; i < (size/BlockSize); i++) {
-        encrypt_block(src, dst);
-        src += 3;
-        dst += 3;
-    }
-
-    delete[] plain;
     return make_tuple(shared_ptr<void>(cipher, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size);
 }
 
@@ -163,29 +295,30 @@ Way3::encrypt_ecb(const void* const data, const int nbytes) const noexcept {
  *
  * @param data - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
  * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
- * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
  */
 std::tuple<std::shared_ptr<void>, int>
-Way3::decrypt_ecb(const void* const cipher, int nbytes) const noexcept {
+Way3::decrypt_ecb(const void* const cipher, int nbytes, const Padding padding) const noexcept {
 
     if (cipher == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
+    if (nbytes % BlockSize || padding == Padding::Cts) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
 
     u8* const plain  = new u8[nbytes];
-    bzero(plain, nbytes);
 
-    const u32* src = reinterpret_cast<const u32*>(cipher);
-    u32* dst = reinterpret_cast<u32*>(plain);
-
-    for (int i = 0; i < (nbytes/BlockSize); i++) {
-        decrypt_block(src, dst);
-        src += 3;
-        dst += 3;
-    }
+    const u32* const src = reinterpret_cast<const u32*>(cipher);
+    u32* const dst = reinterpret_cast<u32*>(plain);
+    Ecb<Way3>::decrypt(*this, src, dst, nbytes/BlockSize);
 
-    if (const int idx = Crypto::padding_index(plain, nbytes); idx != -1) {
-        nbytes = idx;
+    nbytes = Crypto::unpad(plain, nbytes, BlockSize, padding);
+    if (nbytes < 0) {
+        delete[] plain;
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
     return make_tuple(shared_ptr<void>(plain, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes);
 }
@@ -196,66 +329,59 @@ Way3::decrypt_ecb(const void* const cipher, int nbytes) const noexcept {
  * jako parametr to zostanie losowo wygenerowany.
  * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
  * Jeśli rozmiar jawnych danych nie jest wielokrotnością rozmiaru bloku
- * zostanie uzupełniony o tzw. padding.
+ * zostanie uzupełniony o tzw. padding (lub, dla Padding::Cts,
+ * zastosowana zostanie kradzież szyfrogramu).
  *
  * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
  * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
  * @param iv - adres wektor IV (może być nullptr).
- * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu.
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 gdy danych nie można uzupełnić wskazanym paddingiem).
  */
 std::tuple<std::shared_ptr<void>, int>
-Way3::encrypt_cbc(const void* const data, const int nbytes, void* iv) const noexcept {
+Way3::encrypt_cbc(const void* const data, const int nbytes, void* iv, const Padding padding) const noexcept {
 
     if (data == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
 
-    bool custom_iv = false;
+    u8 random_iv[BlockSize];
     if (iv == nullptr) {
         // Jeśli funkcja wywołująca nie przekazała wektora IV
         // sami generujemy go losowo.
-        iv = new u8[BlockSize];
-        Crypto::random_bytes(iv, BlockSize);
-        custom_iv = true;
+        Crypto::random_bytes(random_iv, BlockSize);
+        iv = random_iv;
     }
 
-    u8* plain = nullptr;
-    int size = nbytes;
-    const int n = size % BlockSize;
-    if (n) {
-        // Ponieważ rozmiar bufora danych do zaszyfrownia
-        // nie jest wielokrotnością bloku dodajemy padding
-        // o stosownej długości.
-        const int dn = BlockSize - n;
-        plain = new u8[size + dn];
-        memcpy(plain, data, size);
-        bzero(plain + size, dn);
-        plain[size] = 128;
-        size += dn;
-    } else {
-        plain = new u8[size];
-        memcpy(plain, data, size);
+    if (padding == Padding::Cts) {
+        return Cbc<Way3>::encrypt_cts(*this, data, nbytes, iv);
     }
 
+    const int size = Crypto::padded_size(nbytes, BlockSize, padding);
+    if (size < 0) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
+
+    // Szyfrowanie w miejscu, w buforze wynikowym (za wektorem IV).
     u8* const cipher = new u8[size + BlockSize];
+    memcpy(cipher, iv, BlockSize);
+    memcpy(cipher + BlockSize, data, nbytes);
+    Crypto::pad(cipher + BlockSize, nbytes, BlockSize, padding);
 
-    u32* src = reinterpret_cast<u32*>(plain);
-    u32* dst = reinterpret_cast<u32*>(cipher);
-    memcpy(dst, iv, BlockSize);
+    const u32* prv = reinterpret_cast<const u32*>(cipher);
+    u32* dst = reinterpret_cast<u32*>(cipher + BlockSize);
 
     u32 tmp[3];
     for (int i = 0; i < (size/BlockSize); i++) {
-        tmp[0] = src[0] ^ dst[0];
-        tmp[1] = src[1] ^ dst[1];
-        tmp[2] = src[2] ^ dst[2];
-        dst += 3;
+        tmp[0] = dst[0] ^ prv[0];
+        tmp[1] = dst[1] ^ prv[1];
+        tmp[2] = dst[2] ^ prv[2];
         encrypt_block(tmp, dst);
-        src += 3;
+        prv = dst;
+        dst += 3;
     }
 
-    if (custom_iv) delete[] static_cast<u8*>(iv);
-    delete[] plain;
-
     return make_tuple(shared_ptr<void>(cipher, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), size + BlockSize);
 }
 
@@ -267,39 +393,280 @@ Way3::encrypt_cbc(const void* const data, const int nbytes, void* iv) const noex
  *
  * @param data - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
  * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
- * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach
+ *           (rozmiar -1 przy niepoprawnym rozmiarze danych lub paddingu).
  */
 std::tuple<std::shared_ptr<void>, int>
-Way3::decrypt_cbc(const void* const cipher, int nbytes) const noexcept {
+Way3::decrypt_cbc(const void* const cipher, int nbytes, const Padding padding) const noexcept {
 
     if (cipher == nullptr || nbytes == 0) {
         return make_tuple(shared_ptr<void>(nullptr), 0);
     }
+    if (padding == Padding::Cts) {
+        return Cbc<Way3>::decrypt_cts(*this, cipher, nbytes);
+    }
+    if (nbytes % BlockSize) {
+        return make_tuple(shared_ptr<void>(nullptr), -1);
+    }
 
     nbytes -= BlockSize;
     u8* const plain  = new u8[nbytes];
-    bzero(plain, nbytes);
-
-    const u32* src = reinterpret_cast<const u32*>(cipher);
-    u32* dst = reinterpret_cast<u32*>(plain);
 
-    for (int i = 0; i < (nbytes/BlockSize); i++) {
-        decrypt_block(src + 3, dst);
+    // bloki są niezależne: duże dane deszyfrowane równolegle, padding tylko w ostatnim bloku
+    Cbc<Way3>::decrypt_chain(*this, cipher, nbytes/BlockSize, plain);
 
-        dst[0] = dst[0] ^ src[0];
-        dst[1] = dst[1] ^ src[1];
-        dst[2] = dst[2] ^ src[2];
-        dst += 3;
-        src += 3;
-    }
-
-    if (const int idx = Crypto::padding_index(plain, nbytes); idx != -1) {
-        nbytes = idx;
+    nbytes = Crypto::unpad(plain, nbytes, BlockSize, padding);
+    if (nbytes < 0) {
+        delete[] plain;
+        return make_tuple(shared_ptr<void>(nullptr), -1);
     }
     return make_tuple(shared_ptr<void>(plain, [](void* ptr) {delete[] static_cast<u8*>(ptr);}), nbytes);
 }
 
 
+/**
+ * @brief encrypt_cbc
+ * Szyfrowanie w trybie CBC danych rozproszonych w segmentach (jak writev).
+ * Łańcuch CBC i niepełne bloki przechodzą przez granice segmentów.
+ * @see Cbc::encrypt_segments
+ *
+ * @param in - segmenty z jawnymi danymi.
+ * @param in_count - liczba segmentów wejściowych.
+ * @param out - segmenty na zaszyfrowane dane (IV + dane z paddingiem).
+ * @param out_count - liczba segmentów wyjściowych.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @param padding - rodzaj paddingu (Cts nie jest obsługiwany).
+ * @return liczba zapisanych bajtów lub -1 przy błędzie.
+ */
+int Way3::encrypt_cbc(const iovec* const in, const int in_count,
+                       const iovec* const out, const int out_count, const void* const iv,
+                       const Padding padding) const noexcept {
+    return Cbc<Way3>::encrypt_segments(*this, in, in_count, out, out_count, iv, padding);
+}
+
+/**
+ * @brief decrypt_cbc
+ * Deszyfrowanie w trybie CBC danych rozproszonych w segmentach (jak readv).
+ * @see Cbc::decrypt_segments
+ *
+ * @param in - segmenty z zaszyfrowanymi danymi (IV + dane).
+ * @param in_count - liczba segmentów wejściowych.
+ * @param out - segmenty na odszyfrowane dane.
+ * @param out_count - liczba segmentów wyjściowych.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return liczba odszyfrowanych bajtów lub -1 przy błędzie.
+ */
+int Way3::decrypt_cbc(const iovec* const in, const int in_count,
+                       const iovec* const out, const int out_count, const Padding padding) const noexcept {
+    return Cbc<Way3>::decrypt_segments(*this, in, in_count, out, out_count, padding);
+}
+
+/**
+ * @brief decrypt_cbc_range
+ * Odszyfrowanie w trybie CBC tylko fragmentu jawnych danych
+ * (bez deszyfrowania całego bufora).
+ * @see Cbc::decrypt_range
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi (IV + dane).
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @param offset - pozycja początku fragmentu w jawnych danych.
+ * @param length - długość fragmentu w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @return - tuple: adres bufora z fragmentem + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::decrypt_cbc_range(const void* const cipher, const int nbytes, const int offset, const int length, const Padding padding) const noexcept {
+    return Cbc<Way3>::decrypt_range(*this, cipher, nbytes, offset, length, padding);
+}
+
+/**
+ * @brief encrypt_cbc_async
+ * Szyfrowanie w trybie CBC w puli wątków biblioteki.
+ * Dane i kontekst szyfru muszą istnieć do zakończenia zadania.
+ * @see Async::encrypt_cbc
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektora IV (może być nullptr).
+ * @param padding - rodzaj paddingu.
+ * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+ * @param cancellation - znacznik anulowania zadania.
+ * @return - future z wynikiem jak w encrypt_cbc ((nullptr, -1) po anulowaniu).
+ */
+std::future<AsyncResult>
+Way3::encrypt_cbc_async(const void* const data, const int nbytes, const void* const iv, const Padding padding,
+                        AsyncCallback callback, const Cancellation cancellation) const {
+    return Async<Way3>::encrypt_cbc(*this, data, nbytes, iv, padding, move(callback), cancellation);
+}
+
+/**
+ * @brief decrypt_cbc_async
+ * Deszyfrowanie w trybie CBC w puli wątków biblioteki.
+ * Dane i kontekst szyfru muszą istnieć do zakończenia zadania.
+ * @see Async::decrypt_cbc
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi (IV + dane).
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @param padding - rodzaj paddingu użyty przy szyfrowaniu.
+ * @param callback - funkcja wywoływana z wynikiem (może być pusta).
+ * @param cancellation - znacznik anulowania zadania.
+ * @return - future z wynikiem jak w decrypt_cbc ((nullptr, -1) po anulowaniu).
+ */
+std::future<AsyncResult>
+Way3::decrypt_cbc_async(const void* const cipher, const int nbytes, const Padding padding,
+                        AsyncCallback callback, const Cancellation cancellation) const {
+    return Async<Way3>::decrypt_cbc(*this, cipher, nbytes, padding, move(callback), cancellation);
+}
+
+/**
+ * @brief encrypt_ctr
+ * Szyfrowanie w trybie CTR (bez paddingu). Jeśli IV nie został przekazany
+ * jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Ctr
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::encrypt_ctr(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Ctr<Way3>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_ctr
+ * Deszyfrowanie w trybie CTR (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::decrypt_ctr(const void* const cipher, const int nbytes) const noexcept {
+    return Ctr<Way3>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief crypt_ctr
+ * Szyfrowanie/odszyfrowanie w trybie CTR fragmentu danych zaczynającego
+ * się od dowolnego bajtu strumienia (swobodny dostęp).
+ *
+ * @param iv - wartość początkowa licznika.
+ * @param offset - pozycja pierwszego bajtu w strumieniu.
+ * @param src - adres danych wejściowych.
+ * @param dst - adres bufora wynikowego (może być równy src).
+ * @param nbytes - liczba bajtów.
+ */
+void Way3::crypt_ctr(const void* const iv, const u64 offset, const void* const src, void* const dst, const int nbytes) const noexcept {
+    Ctr<Way3>::crypt(*this, iv, offset, src, dst, nbytes);
+}
+
+/**
+ * @brief encrypt_cfb
+ * Szyfrowanie w trybie pełnoblokowym CFB (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Cfb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::encrypt_cfb(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Cfb<Way3>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_cfb
+ * Deszyfrowanie w trybie pełnoblokowym CFB (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::decrypt_cfb(const void* const cipher, const int nbytes) const noexcept {
+    return Cfb<Way3>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief encrypt_cfb8
+ * Szyfrowanie w trybie 8-bitowym CFB (CFB8) (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Cfb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::encrypt_cfb8(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Cfb<Way3>::encrypt(*this, data, nbytes, iv, 1);
+}
+
+/**
+ * @brief decrypt_cfb8
+ * Deszyfrowanie w trybie 8-bitowym CFB (CFB8) (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::decrypt_cfb8(const void* const cipher, const int nbytes) const noexcept {
+    return Cfb<Way3>::decrypt(*this, cipher, nbytes, 1);
+}
+
+/**
+ * @brief encrypt_ofb
+ * Szyfrowanie w trybie OFB (bez paddingu). Jeśli IV nie został
+ * przekazany jako parametr to zostanie losowo wygenerowany.
+ * Wektor IV jest pierwszym blokiem zaszyfrowanych danych.
+ * @see Ofb
+ *
+ * @param data - adres bufora z jawnymi danymi do zaszyfrowania.
+ * @param nbytes - rozmiar bufora z jawnymi danymi w bajtach.
+ * @param iv - adres wektor IV (może być nullptr).
+ * @return - tuple: adres bufora z zaszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::encrypt_ofb(const void* const data, const int nbytes, const void* const iv) const noexcept {
+    return Ofb<Way3>::encrypt(*this, data, nbytes, iv);
+}
+
+/**
+ * @brief decrypt_ofb
+ * Deszyfrowanie w trybie OFB (pierwszym blokiem danych jest IV).
+ *
+ * @param cipher - adres bufora z zaszyfrowanymi danymi do odszyfrowania.
+ * @param nbytes - rozmiar bufora z zaszyfrowanymi danymi w bajtach.
+ * @return - tuple: adres bufora z odszyfrowanymi danymi + jego rozmiar w bajtach.
+ */
+std::tuple<std::shared_ptr<void>, int>
+Way3::decrypt_ofb(const void* const cipher, const int nbytes) const noexcept {
+    return Ofb<Way3>::decrypt(*this, cipher, nbytes);
+}
+
+/**
+ * @brief cmac
+ * Wyznaczenie kodu uwierzytelniającego CMAC danych.
+ * @see Cmac
+ *
+ * @param data - adres danych.
+ * @param nbytes - rozmiar danych w bajtach.
+ * @param tag - adres bufora na znacznik (BlockSize bajtów).
+ */
+void Way3::cmac(const void* const data, const int nbytes, void* const tag) const noexcept {
+    Cmac<Way3>::compute(*this, data, nbytes, tag);
+}
+
 
 /********************************************************************
  *                                                                  *
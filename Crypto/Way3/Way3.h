@@ -31,9 +31,11 @@
 /*------- include files:
 -------------------------------------------------------------------*/
 #include <cstdint>
+#include <sys/uio.h>
 #include <memory>
 #include <tuple>
 #include "Crypto/Crypto.h"
+#include "Crypto/Async/AsyncTypes.h"
 
 /*------- namespaces:
 -------------------------------------------------------------------*/
@@ -41,22 +43,53 @@ namespace beesoft {
 namespace crypto {
 
 
-class Way3 {
+class alignas(CacheLineSize) Way3 {
     u32 k[3];
     u32 ki[3];
 public:
-    Way3(); // only for tests of helper methods
+    static constexpr int Lanes = 4;        // blocks per multi-block kernel step
+    static constexpr int BlockSize = 12;    // in bytes
+
+    Way3() noexcept; // unkeyed context (pools, tests of helper methods)
     Way3(const void* const, const int);
     ~Way3();
 
-    std::tuple<std::shared_ptr<void>, int> encrypt_cbc(const void* const, const int, void* = nullptr) const noexcept;
-    std::tuple<std::shared_ptr<void>, int> decrypt_cbc(const void* const, int) const noexcept;
+    Way3(const Way3&) = delete;
+    Way3& operator=(const Way3&) = delete;
+    Way3(Way3&&) noexcept;
+    Way3& operator=(Way3&&) noexcept;
+
+    bool rekey(const void* const, const int) noexcept;
+    void clear() noexcept;
+
+    std::tuple<std::shared_ptr<void>, int> encrypt_cbc(const void* const, const int, void* = nullptr, const Padding = Padding::Iso7816) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cbc(const void* const, int, const Padding = Padding::Iso7816) const noexcept;
+    int encrypt_cbc(const iovec* const, const int, const iovec* const, const int, const void* const = nullptr, const Padding = Padding::Iso7816) const noexcept;
+    int decrypt_cbc(const iovec* const, const int, const iovec* const, const int, const Padding = Padding::Iso7816) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cbc_range(const void* const, const int, const int, const int, const Padding = Padding::Iso7816) const noexcept;
+    std::future<AsyncResult> encrypt_cbc_async(const void* const, const int, const void* const = nullptr, const Padding = Padding::Iso7816, AsyncCallback = {}, const Cancellation = {}) const;
+    std::future<AsyncResult> decrypt_cbc_async(const void* const, const int, const Padding = Padding::Iso7816, AsyncCallback = {}, const Cancellation = {}) const;
+
+    std::tuple<std::shared_ptr<void>, int> encrypt_ctr(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_ctr(const void* const, const int) const noexcept;
+    void crypt_ctr(const void* const, const u64, const void* const, void* const, const int) const noexcept;
+
+    std::tuple<std::shared_ptr<void>, int> encrypt_cfb(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cfb(const void* const, const int) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> encrypt_cfb8(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_cfb8(const void* const, const int) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> encrypt_ofb(const void* const, const int, const void* const = nullptr) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_ofb(const void* const, const int) const noexcept;
+
+    void cmac(const void* const, const int, void* const) const noexcept;
 
     void encrypt_block(const u32* const, u32* const) const noexcept;
     void decrypt_block(const u32* const, u32* const) const noexcept;
+    void encrypt_blocks(const u32*, u32*, int) const noexcept;
+    void decrypt_blocks(const u32*, u32*, int) const noexcept;
 
-    std::tuple<std::shared_ptr<void>, int> encrypt_ecb(const void* const, const int) const noexcept;
-    std::tuple<std::shared_ptr<void>, int> decrypt_ecb(const void* const, int) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> encrypt_ecb(const void* const, const int, const Padding = Padding::Iso7816) const noexcept;
+    std::tuple<std::shared_ptr<void>, int> decrypt_ecb(const void* const, int, const Padding = Padding::Iso7816) const noexcept;
 
 public:
     u32* gamma(u32* const) const noexcept;
@@ -0,0 +1,24 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        ../Crypto/Blowfish/Blowfish.cpp \
+        ../Crypto/Crypto.cpp \
+        ../Crypto/Drbg/Drbg.cpp \
+        ../Crypto/Gost/Gost.cpp \
+        ../Crypto/Parallel/Parallel.cpp \
+        ../Crypto/Parallel/ThreadPool.cpp \
+        ../Crypto/SecureArena/SecureArena.cpp \
+        ../Crypto/Way3/Way3.cpp \
+        main.cpp
+
+HEADERS += \
+   ../Crypto/Blowfish/Blowfish.h \
+   ../Crypto/Crypto.h \
+   ../Crypto/Modes/Cbc.h \
+   ../Crypto/Parallel/EventCount.h \
+   ../Crypto/Parallel/MpmcQueue.h
@@ -0,0 +1,213 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Crypto/Blowfish/Blowfish.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Parallel/EventCount.h"
+#include "Crypto/Parallel/MpmcQueue.h"
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+using namespace std;
+using namespace beesoft::crypto;
+
+/*------- local constants:
+-------------------------------------------------------------------*/
+static constexpr int Messages = 200000;    // wiadomości na producenta
+static constexpr int Batch = 16;           // zadania pobierane naraz przez konsumenta
+
+/**
+ * @brief MutexQueue
+ * Kolejka odniesienia: std::deque chroniona blokadą,
+ * konsumenci czekają na zmiennej warunkowej.
+ */
+template<typename T>
+class MutexQueue {
+    deque<T> items;
+    mutex lock;
+    condition_variable ready;
+public:
+    void push(T&& value) {
+        {
+            lock_guard<mutex> guard(lock);
+            items.push_back(move(value));
+        }
+        ready.notify_one();
+    }
+    int pop_bulk(T* const values, const int max, const atomic<bool>& done) {
+        unique_lock<mutex> guard(lock);
+        ready.wait(guard, [&] { return !items.empty() || done.load(); });
+        int n = 0;
+        while (n < max && !items.empty()) {
+            values[n++] = move(items.front());
+            items.pop_front();
+        }
+        return n;
+    }
+    void wake_all() {
+        lock_guard<mutex> guard(lock);
+        ready.notify_all();
+    }
+};
+
+/**
+ * @brief LockFreeQueue
+ * Kolejka badana: MpmcQueue z usypianiem konsumentów na futeksie.
+ */
+template<typename T>
+class LockFreeQueue {
+    MpmcQueue<T> items{1 << 14};
+    EventCount idle;
+public:
+    void push(T&& value) {
+        while (!items.push(move(value))) {
+            this_thread::yield();
+        }
+        idle.notify_one();
+    }
+    int pop_bulk(T* const values, const int max, const atomic<bool>& done) {
+        for (;;) {
+            if (const int n = items.pop_bulk(values, max)) {
+                return n;
+            }
+            const u32 key = idle.prepare();
+            if (!items.empty() || done.load()) {
+                idle.cancel();
+                if (done.load()) {
+                    return items.pop_bulk(values, max);
+                }
+                continue;
+            }
+            idle.wait(key);
+        }
+    }
+    void wake_all() {
+        idle.notify_all();
+    }
+};
+
+/**
+ * @brief run
+ * Producenci zlecają szyfrowanie CBC wiadomości o zadanym rozmiarze,
+ * konsumenci pobierają je paczkami i szyfrują jednym Cbc::encrypt_batch.
+ *
+ * @return liczba zaszyfrowanych wiadomości na sekundę.
+ */
+template<typename Queue>
+double run(const Blowfish& cipher, const int nbytes, const int producers, const int consumers) {
+    using Job = Cbc<Blowfish>::Job;
+    constexpr int bs = Blowfish::BlockSize;
+    const int size = Crypto::padded_size(nbytes, bs, Padding::Pkcs7) + bs;
+
+    vector<u8> plain(nbytes);
+    Crypto::random_bytes(plain.data(), nbytes);
+    u8 iv[bs] = {};
+
+    Queue queue;
+    atomic<bool> done{false};
+    atomic<int> processed{0};
+    vector<thread> threads;
+
+    const auto start = chrono::steady_clock::now();
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&] {
+            vector<u8> out(Batch * size);
+            Job jobs[Batch];
+            for (;;) {
+                const int n = queue.pop_bulk(jobs, Batch, done);
+                if (n == 0) {
+                    if (done.load()) {
+                        break;
+                    }
+                    continue;
+                }
+                for (int i = 0; i < n; i++) {
+                    jobs[i].out = out.data() + i * size;
+                }
+                Cbc<Blowfish>::encrypt_batch(cipher, jobs, n, Padding::Pkcs7);
+                processed += n;
+            }
+        });
+    }
+    vector<thread> senders;
+    for (int p = 0; p < producers; p++) {
+        senders.emplace_back([&] {
+            for (int i = 0; i < Messages; i++) {
+                queue.push(Job{plain.data(), nbytes, iv, nullptr, 0});
+            }
+        });
+    }
+    for (auto& t : senders) {
+        t.join();
+    }
+    while (processed.load() < producers * Messages) {
+        this_thread::yield();
+    }
+    done = true;
+    queue.wake_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return producers * Messages / elapsed.count();
+}
+
+/**
+ * @brief main
+ * Porównanie kolejek zadań przy małych wiadomościach (64-256 bajtów).
+ * Opcjonalne argumenty: liczba producentów i konsumentów.
+ */
+int main(int argc, char* argv[]) {
+    u8 key[16];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish cipher(key, 16);
+    const int cpus = max(2, int(thread::hardware_concurrency()));
+    const int producers = (argc > 1) ? max(1, atoi(argv[1])) : max(1, cpus / 2);
+    const int consumers = (argc > 2) ? max(1, atoi(argv[2])) : max(1, cpus - producers);
+
+    cout << "producers: " << producers << ", consumers: " << consumers << endl;
+    cout << setw(8) << "bytes" << setw(16) << "mutex [msg/s]" << setw(16) << "mpmc [msg/s]" << endl;
+    for (const int nbytes : {64, 128, 256}) {
+        const double locked = run<MutexQueue<Cbc<Blowfish>::Job>>(cipher, nbytes, producers, consumers);
+        const double lockfree = run<LockFreeQueue<Cbc<Blowfish>::Job>>(cipher, nbytes, producers, consumers);
+        cout << setw(8) << nbytes << setw(16) << fixed << setprecision(0) << locked << setw(16) << lockfree << endl;
+    }
+    return 0;
+}
@@ -1,18 +1,46 @@
 TEMPLATE = app
-CONFIG += console c++17
+CONFIG += console c++17 thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
 SOURCES += \
         Crypto/Blowfish/Blowfish.cpp \
         Crypto/Crypto.cpp \
+        Crypto/Drbg/Drbg.cpp \
         Crypto/Gost/Gost.cpp \
+        Crypto/Parallel/Parallel.cpp \
+        Crypto/Parallel/ThreadPool.cpp \
+        Crypto/SecureArena/SecureArena.cpp \
         Crypto/Way3/Way3.cpp \
         main.cpp
 
 HEADERS += \
+   Crypto/Async/Async.h \
+   Crypto/Async/AsyncTypes.h \
+   Crypto/Batch/Coalescer.h \
+   Crypto/Batch/KeyedBatch.h \
    Crypto/Blowfish/Blowfish.h \
    Crypto/Blowfish/BlowfishData.h \
    Crypto/Crypto.h \
+   Crypto/Drbg/Drbg.h \
    Crypto/Gost/Gost.h \
+   Crypto/Modes/Cascade.h \
+   Crypto/Modes/Cbc.h \
+   Crypto/Modes/Cfb.h \
+   Crypto/Modes/Cmac.h \
+   Crypto/Modes/Ctr.h \
+   Crypto/Modes/Ecb.h \
+   Crypto/Modes/Etm.h \
+   Crypto/Modes/Ofb.h \
+   Crypto/Modes/Siv.h \
+   Crypto/Modes/Xts.h \
+   Crypto/Parallel/EventCount.h \
+   Crypto/Parallel/MpmcQueue.h \
+   Crypto/Parallel/Parallel.h \
+   Crypto/Parallel/ThreadPool.h \
+   Crypto/Pool/ContextPool.h \
+   Crypto/Reservoir/KeystreamReservoir.h \
+   Crypto/SecureArena/SecureArena.h \
+   Crypto/Segments/Segments.h \
+   Crypto/Stream/Stream.h \
    Crypto/Way3/Way3.h
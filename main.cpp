@@ -33,10 +33,33 @@
 #include <memory>
 #include <cassert>
 #include <vector>
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Crypto/Batch/Coalescer.h"
+#include "Crypto/Batch/KeyedBatch.h"
 #include "Crypto/Blowfish/Blowfish.h"
 #include "Crypto/Gost/Gost.h"
 #include "Crypto/Way3/Way3.h"
+#include "Crypto/Pool/ContextPool.h"
+#include "Crypto/Drbg/Drbg.h"
+#include "Crypto/SecureArena/SecureArena.h"
+#include "Crypto/Parallel/Parallel.h"
+#include "Crypto/Parallel/MpmcQueue.h"
+#include "Crypto/Parallel/ThreadPool.h"
+#include "Crypto/Modes/Cascade.h"
+#include "Crypto/Modes/Cbc.h"
+#include "Crypto/Modes/Cfb.h"
+#include "Crypto/Modes/Cmac.h"
+#include "Crypto/Modes/Ctr.h"
+#include "Crypto/Modes/Etm.h"
+#include "Crypto/Modes/Ofb.h"
+#include "Crypto/Modes/Siv.h"
+#include "Crypto/Modes/Xts.h"
+#include "Crypto/Reservoir/KeystreamReservoir.h"
+#include "Crypto/Stream/Stream.h"
 #include "Crypto/Crypto.h"
 
 /*------- namespaces:
@@ -57,6 +80,7 @@ void way3_test_cbc_without_iv();
 
 void test_gost();
 void gost_test_block();
+void gost_test_multikey();
 void gost_test_ecb();
 void gost_test_cbc_without_iv();
 
@@ -66,12 +90,133 @@ void blowfish_test_ecb();
 void blowfish_test_cbc_with_iv();
 void blowfish_test_cbc_without_iv();
 
+void test_pool();
+void pool_test_move();
+void pool_test_acquire();
+void pool_test_secure_arena();
+
+void test_segments();
+void segments_test_cbc();
+
+void test_padding();
+void padding_test_modes();
+void padding_test_cts();
+
+void test_ctr();
+void ctr_test_blocks();
+void ctr_test_counter();
+void ctr_test_random_access();
+void ctr_test_parallel();
+
+void test_drbg();
+void drbg_test_generate();
+void drbg_test_fork();
+
+void test_feedback();
+void feedback_test_definition();
+void feedback_test_streaming();
+void feedback_test_parallel();
+
+void test_reservoir();
+void reservoir_test_ctr();
+void reservoir_test_ofb();
+
+void test_xts();
+void xts_test_multiply();
+void xts_test_sector();
+void xts_test_batch();
+
+void test_cmac();
+void cmac_test_definition();
+void cmac_test_streaming();
+void cmac_test_batch();
+
+void test_etm();
+void etm_test_roundtrip();
+void etm_test_forgery();
+
+void test_siv();
+void siv_test_deterministic();
+void siv_test_parallel();
+
+void test_range();
+void range_test_cbc();
+
+void test_cascade();
+void cascade_test_stages();
+void cascade_test_roundtrip();
+
+void test_ecb();
+void ecb_test_parallel();
+void cbc_test_parallel_decrypt();
+void cbc_test_batch();
+
+void test_keyed_batch();
+void keyed_batch_test_cbc();
+
+void test_thread_pool();
+void thread_pool_test_nested();
+void thread_pool_test_executor();
+void thread_pool_test_scratch();
+void thread_pool_test_queue();
+
+void test_async();
+void async_test_roundtrip();
+void async_test_cancel();
+
+void test_coalescer();
+void coalescer_test_batches();
+void coalescer_test_deadline();
+
+void test_stream();
+void stream_test_cbc();
+void stream_test_modes();
+void stream_test_errors();
+
 int main() {
     test_blowfish();
     cout << endl;
     test_gost();
     cout << endl;
     test_way3();
+    cout << endl;
+    test_pool();
+    cout << endl;
+    test_segments();
+    cout << endl;
+    test_drbg();
+    cout << endl;
+    test_padding();
+    cout << endl;
+    test_ctr();
+    cout << endl;
+    test_feedback();
+    cout << endl;
+    test_reservoir();
+    cout << endl;
+    test_xts();
+    cout << endl;
+    test_cmac();
+    cout << endl;
+    test_etm();
+    cout << endl;
+    test_siv();
+    cout << endl;
+    test_range();
+    cout << endl;
+    test_cascade();
+    cout << endl;
+    test_ecb();
+    cout << endl;
+    test_keyed_batch();
+    cout << endl;
+    test_thread_pool();
+    cout << endl;
+    test_async();
+    cout << endl;
+    test_coalescer();
+    cout << endl;
+    test_stream();
     return 0;
 }
 
@@ -400,6 +545,7 @@ void test_gost() {
     gost_test_block();
     gost_test_ecb();
     gost_test_cbc_without_iv();
+    gost_test_multikey();
 }
 
 void gost_test_block() {
@@ -566,6 +712,36 @@ void gost_test_cbc_without_iv() {
     cout << "gosth_test_cbc_without_iv (random keys): OK" << endl;
 }
 
+/**
+ * @brief gost_test_multikey
+ * Blok szyfrowany kernelem wielokluczowym jest identyczny z blokiem
+ * szyfrowanym kontekstem swojego klucza.
+ */
+void gost_test_multikey() {
+    constexpr int count = 19;
+    vector<Gost> contexts(count);
+    vector<const Gost*> lanes(count);
+    for (int i = 0; i < count; i++) {
+        u8 key[32];
+        Crypto::random_bytes(key, sizeof(key));
+        contexts[i].rekey(key, 32);
+        lanes[i] = &contexts[i];
+    }
+    u32 plain[2 * count], encrypted[2 * count], decrypted[2 * count];
+    Crypto::random_bytes(plain, sizeof(plain));
+
+    Gost::encrypt_multikey(lanes.data(), plain, encrypted, count);
+    for (int i = 0; i < count; i++) {
+        u32 expected[2];
+        contexts[i].encrypt_block(plain + 2 * i, expected);
+        assert(encrypted[2 * i] == expected[0] && encrypted[2 * i + 1] == expected[1]);
+    }
+    Gost::decrypt_multikey(lanes.data(), encrypted, decrypted, count);
+    assert(Crypto::compare_bytes(decrypted, plain, sizeof(plain)));
+
+    cout << "gost_test_multikey: OK" << endl;
+}
+
 /********************************************************************
  *                                                                  *
  *                     B L O W F I S H                              *
@@ -803,3 +979,2203 @@ void blowfish_test_cbc_with_iv() {
     }
     cout << "blowfish_test_cbc_with_iv: OK" << endl;
 }
+
+/********************************************************************
+ *                                                                  *
+ *                            P O O L                               *
+ *                                                                  *
+ ********************************************************************/
+
+void test_pool() {
+    pool_test_move();
+    pool_test_acquire();
+    pool_test_secure_arena();
+}
+
+/**
+ * @brief pool_test_move
+ */
+void pool_test_move() {
+    const auto key = string("TESTKEY");
+    u32 plain[] = {1, 2};
+    u32 expected[] = {0xdf333fd2, 0x30a71bb4};
+    u32 buffer[] = {0, 0};
+
+    vector<Blowfish> contexts;
+    for (int i = 0; i < 4; i++) {
+        contexts.push_back(Blowfish(key.data(), key.size()));
+    }
+    for (const auto& bf : contexts) {
+        bf.encrypt_block(plain, buffer);
+        assert(buffer[0] == expected[0]);
+        assert(buffer[1] == expected[1]);
+    }
+
+    Blowfish moved(std::move(contexts[0]));
+    moved.encrypt_block(plain, buffer);
+    assert(buffer[0] == expected[0]);
+    assert(buffer[1] == expected[1]);
+    // kontekst źródłowy jest wyczyszczony
+    contexts[0].encrypt_block(plain, buffer);
+    assert(buffer[0] != expected[0] || buffer[1] != expected[1]);
+
+    u8 key32[32] = {
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 0,
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 0,
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 0,
+        1, 2
+    };
+    Gost gt;
+    gt = Gost(key32, 32);
+    gt.encrypt_block(plain, buffer);
+    gt.decrypt_block(buffer, buffer);
+    assert(buffer[0] == plain[0] && buffer[1] == plain[1]);
+
+    vector<Way3> ways(2);
+    ways[1] = Way3(key32, 12);
+    u32 w3_plain[] = {1, 2, 3};
+    u32 w3_buffer[3];
+    ways[1].encrypt_block(w3_plain, w3_buffer);
+    ways[1].decrypt_block(w3_buffer, w3_buffer);
+    assert(Crypto::compare_bytes(w3_plain, w3_buffer, sizeof(w3_plain)));
+
+    cout << "pool_test_move: OK" << endl;
+}
+
+/**
+ * @brief pool_test_acquire
+ */
+void pool_test_acquire() {
+    const auto key = string("TESTKEY");
+    u32 plain[] = {1, 2};
+    u32 expected[] = {0xdf333fd2, 0x30a71bb4};
+    u32 buffer[] = {0, 0};
+
+    ContextPool<Blowfish> pool(2);
+    assert(pool.capacity() == 2 && pool.available() == 2);
+    {
+        auto a = pool.acquire(key.data(), key.size());
+        auto b = pool.acquire("1234", 4);
+        assert(a && b);
+        assert(pool.available() == 0);
+        assert(!pool.acquire(key.data(), key.size()));
+
+        a->encrypt_block(plain, buffer);
+        assert(buffer[0] == expected[0]);
+        assert(buffer[1] == expected[1]);
+        b.release();
+        assert(pool.available() == 1);
+    }
+    assert(pool.available() == 2);
+
+    // niepoprawny klucz nie zabiera kontekstu z puli
+    ContextPool<Gost> gost_pool(1);
+    assert(!gost_pool.acquire(key.data(), key.size()));
+    assert(gost_pool.available() == 1);
+
+    cout << "pool_test_acquire: OK" << endl;
+}
+
+/**
+ * @brief pool_test_secure_arena
+ */
+void pool_test_secure_arena() {
+    SecureArena arena(10000);
+    assert(arena.valid());
+    assert(arena.size() >= 10000);
+
+    u8* const a = static_cast<u8*>(arena.allocate(100));
+    u8* const b = static_cast<u8*>(arena.allocate(1));
+    assert(a && b);
+    assert(reinterpret_cast<uintptr_t>(b) % CacheLineSize == 0);
+    assert(arena.allocate(arena.size()) == nullptr);
+
+    memset(a, 0xaa, 100);
+    arena.reset();
+    assert(arena.in_use() == 0);
+    for (int i = 0; i < 100; i++) {
+        assert(a[i] == 0);
+    }
+
+    // pula kontekstów umieszczona w zablokowanej pamięci
+    const auto key = string("TESTKEY");
+    u32 plain[] = {1, 2};
+    u32 expected[] = {0xdf333fd2, 0x30a71bb4};
+    u32 buffer[] = {0, 0};
+    {
+        ContextPool<Blowfish, SecureAllocator<Blowfish>> pool(2, SecureAllocator<Blowfish>(arena));
+        auto bf = pool.acquire(key.data(), key.size());
+        assert(bf);
+        assert(arena.in_use() >= 2 * sizeof(Blowfish));
+        bf->encrypt_block(plain, buffer);
+        assert(buffer[0] == expected[0]);
+        assert(buffer[1] == expected[1]);
+    }
+    arena.reset();
+
+    cout << "pool_test_secure_arena: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                        S E G M E N T S                           *
+ *                                                                  *
+ ********************************************************************/
+
+void test_segments() {
+    segments_test_cbc();
+}
+
+/**
+ * @brief segments_test_cbc
+ * Szyfrowanie danych podzielonych na segmenty musi dać ten sam wynik
+ * co szyfrowanie danych w jednym buforze. Test używa PKCS#7, bo przy
+ * domyślnym (dawnym) paddingu ISO 7816 losowe dane wyrównane do bloku
+ * mogą przypadkiem kończyć się wzorcem paddingu.
+ */
+void segments_test_cbc() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+
+        for (int nbytes = 1; nbytes < 100; nbytes += 7) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+            const auto [expected, n] = cipher.encrypt_cbc(plain.data(), nbytes, iv, Padding::Pkcs7);
+
+            // wejście: nagłówek 3 bajty + reszta w kawałkach po 5 bajtów
+            vector<iovec> in;
+            in.push_back({plain.data(), size_t(std::min(3, nbytes))});
+            for (int i = 3; i < nbytes; i += 5) {
+                in.push_back({plain.data() + i, size_t(std::min(5, nbytes - i))});
+            }
+            // wyjście: dwa segmenty o nierównych rozmiarach
+            vector<u8> encrypted(n);
+            const int split = n / 3 + 1;
+            iovec out[] = {{encrypted.data(), size_t(split)}, {encrypted.data() + split, size_t(n - split)}};
+
+            assert(cipher.encrypt_cbc(in.data(), int(in.size()), out, 2, iv, Padding::Pkcs7) == n);
+            assert(Crypto::compare_bytes(encrypted.data(), expected.get(), n));
+
+            vector<u8> decrypted(n);
+            iovec dec_in[] = {{encrypted.data(), size_t(5)}, {encrypted.data() + 5, size_t(n - 5)}};
+            iovec dec_out[] = {{decrypted.data(), size_t(1)}, {decrypted.data() + 1, size_t(n - 1)}};
+            assert(cipher.decrypt_cbc(dec_in, 2, dec_out, 2, Padding::Pkcs7) == nbytes);
+            assert(Crypto::compare_bytes(decrypted.data(), plain.data(), nbytes));
+
+            // za mały bufor wyjściowy
+            iovec small[] = {{encrypted.data(), size_t(n - 1)}};
+            assert(cipher.encrypt_cbc(in.data(), int(in.size()), small, 1, iv, Padding::Pkcs7) == -1);
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "segments_test_cbc: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                            D R B G                               *
+ *                                                                  *
+ ********************************************************************/
+
+void test_drbg() {
+    drbg_test_generate();
+    drbg_test_fork();
+}
+
+/**
+ * @brief drbg_test_generate
+ */
+void drbg_test_generate() {
+    u8 a[12] = {};
+    u8 b[12] = {};
+    Crypto::random_bytes(a, sizeof(a));
+    Crypto::random_bytes(b, sizeof(b));
+    assert(!Crypto::compare_bytes(a, b, sizeof(a)));
+
+    // duże żądanie (poza buforem generatora)
+    vector<u8> big(100000);
+    Crypto::random_bytes(big.data(), int(big.size()));
+    int histogram[256] = {};
+    for (const u8 c : big) {
+        histogram[c]++;
+    }
+    for (const int count : histogram) {
+        assert(count > 250 && count < 550);
+    }
+
+    // każdy wątek ma własny generator
+    Drbg drbg;
+    drbg.generate(a, sizeof(a));
+    drbg.generate(b, 5);
+    assert(!Crypto::compare_bytes(a, b, 5));
+
+    cout << "drbg_test_generate: OK" << endl;
+}
+
+/**
+ * @brief drbg_test_fork
+ * Proces potomny nie może powtórzyć bajtów wygenerowanych przez rodzica.
+ */
+void drbg_test_fork() {
+    u8 warmup[8];
+    Crypto::random_bytes(warmup, sizeof(warmup));
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    const pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        u8 child[16];
+        Crypto::random_bytes(child, sizeof(child));
+        _exit(write(fds[1], child, sizeof(child)) == sizeof(child) ? 0 : 1);
+    }
+    u8 parent[16];
+    u8 child[16];
+    Crypto::random_bytes(parent, sizeof(parent));
+    assert(read(fds[0], child, sizeof(child)) == sizeof(child));
+    int status = 0;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+    assert(!Crypto::compare_bytes(parent, child, sizeof(parent)));
+
+    cout << "drbg_test_fork: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                         P A D D I N G                            *
+ *                                                                  *
+ ********************************************************************/
+
+void test_padding() {
+    padding_test_modes();
+    padding_test_cts();
+}
+
+/**
+ * @brief padding_test_modes
+ */
+void padding_test_modes() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        for (int nbytes = 1; nbytes <= 4 * bs; nbytes++) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+            plain[nbytes - 1] |= 0x01;  // dane wyrównane do bloku nie mogą wyglądać jak padding ISO 7816
+            const bool aligned = (nbytes % bs) == 0;
+
+            for (const Padding padding : {Padding::None, Padding::Pkcs7, Padding::Iso7816}) {
+                const auto [ecb, n] = cipher.encrypt_ecb(plain.data(), nbytes, padding);
+                const auto [cbc, m] = cipher.encrypt_cbc(plain.data(), nbytes, nullptr, padding);
+                if (padding == Padding::None && !aligned) {
+                    assert(n == -1 && m == -1);
+                    continue;
+                }
+                const int expected = (padding == Padding::Pkcs7) ? (nbytes / bs + 1) * bs : (nbytes + bs - 1) / bs * bs;
+                assert(n == expected && m == expected + bs);
+
+                const auto [ecb_plain, k] = cipher.decrypt_ecb(ecb.get(), n, padding);
+                assert(k == nbytes && Crypto::compare_bytes(ecb_plain.get(), plain.data(), k));
+                const auto [cbc_plain, l] = cipher.decrypt_cbc(cbc.get(), m, padding);
+                assert(l == nbytes && Crypto::compare_bytes(cbc_plain.get(), plain.data(), l));
+            }
+        }
+
+        // niepoprawny padding PKCS#7
+        u8 block[bs] = {};
+        const auto [bad, n] = cipher.encrypt_ecb(block, bs, Padding::None);
+        assert(n == bs);
+        assert(std::get<1>(cipher.decrypt_ecb(bad.get(), n, Padding::Pkcs7)) == -1);
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "padding_test_modes: OK" << endl;
+}
+
+/**
+ * @brief padding_test_cts
+ */
+void padding_test_cts() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+
+        u8 short_data[bs - 1] = {};
+        assert(std::get<1>(cipher.encrypt_cbc(short_data, bs - 1, iv, Padding::Cts)) == -1);
+
+        for (int nbytes = bs; nbytes <= 5 * bs; nbytes++) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+
+            const auto [encrypted, n] = cipher.encrypt_cbc(plain.data(), nbytes, iv, Padding::Cts);
+            assert(n == nbytes + bs);
+            const auto [decrypted, k] = cipher.decrypt_cbc(encrypted.get(), n, Padding::Cts);
+            assert(k == nbytes && Crypto::compare_bytes(decrypted.get(), plain.data(), k));
+
+            // dla pełnych bloków początek jest taki sam jak w zwykłym CBC...
+            if (nbytes % bs == 0 && nbytes > 2 * bs) {
+                const auto [cbc, m] = cipher.encrypt_cbc(plain.data(), nbytes, iv, Padding::None);
+                assert(m == n);
+                const u8* const c = static_cast<const u8*>(cbc.get());
+                const u8* const e = static_cast<const u8*>(encrypted.get());
+                assert(Crypto::compare_bytes(c, e, n - 2 * bs));
+                // ... a dwa ostatnie są zamienione miejscami
+                assert(Crypto::compare_bytes(c + n - 2 * bs, e + n - bs, bs));
+                assert(Crypto::compare_bytes(c + n - bs, e + n - 2 * bs, bs));
+            }
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "padding_test_cts: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                             C T R                                *
+ *                                                                  *
+ ********************************************************************/
+
+void test_ctr() {
+    ctr_test_blocks();
+    ctr_test_counter();
+    ctr_test_random_access();
+    ctr_test_parallel();
+}
+
+/**
+ * @brief ctr_test_blocks
+ * Kernel wieloblokowy musi dawać wyniki identyczne z encrypt_block/decrypt_block.
+ */
+void ctr_test_blocks() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int words = std::decay_t<decltype(cipher)>::BlockSize / 4;
+        for (int n = 0; n < 11; n++) {
+            vector<u32> plain(n * words + 1);
+            Crypto::random_bytes(plain.data(), int(plain.size() * sizeof(u32)));
+            vector<u32> expected(plain.size());
+            vector<u32> result(plain.size());
+            for (int i = 0; i < n; i++) {
+                cipher.encrypt_block(&plain[i * words], &expected[i * words]);
+            }
+            cipher.encrypt_blocks(plain.data(), result.data(), n);
+            assert(Crypto::compare_bytes(result.data(), expected.data(), n * words * 4));
+            cipher.decrypt_blocks(result.data(), result.data(), n);
+            assert(Crypto::compare_bytes(result.data(), plain.data(), n * words * 4));
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "ctr_test_blocks: OK" << endl;
+}
+
+/**
+ * @brief ctr_test_counter
+ * Licznik jest liczbą big-endian o rozmiarze całego bloku.
+ */
+void ctr_test_counter() {
+    u8 iv[12] = {0x00, 0x00, 0x00, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe};
+    u8 expected[12] = {0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+    u8 counter[12];
+    Ctr<Way3>::counter_block(iv, 3, counter);
+    assert(Crypto::compare_bytes(counter, expected, 12));
+
+    u8 iv8[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xff};
+    u8 expected8[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00};
+    Ctr<Gost>::counter_block(iv8, 0x10001, counter);
+    assert(Crypto::compare_bytes(counter, expected8, 8));
+
+    cout << "ctr_test_counter: OK" << endl;
+}
+
+/**
+ * @brief ctr_test_random_access
+ */
+void ctr_test_random_access() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        vector<u8> plain(1000);
+        Crypto::random_bytes(plain.data(), int(plain.size()));
+
+        const auto [encrypted, n] = cipher.encrypt_ctr(plain.data(), int(plain.size()));
+        assert(n == int(plain.size()) + bs);
+        const auto [decrypted, k] = cipher.decrypt_ctr(encrypted.get(), n);
+        assert(k == int(plain.size()) && Crypto::compare_bytes(decrypted.get(), plain.data(), k));
+
+        // dowolny fragment odszyfrowany niezależnie od reszty
+        const u8* const iv = static_cast<const u8*>(encrypted.get());
+        for (int offset = 0; offset < 40; offset += 3) {
+            for (int length = 1; length < 50; length += 7) {
+                u8 part[64];
+                cipher.crypt_ctr(iv, offset + 500, iv + bs + offset + 500, part, length);
+                assert(Crypto::compare_bytes(part, plain.data() + offset + 500, length));
+            }
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "ctr_test_random_access: OK" << endl;
+}
+
+/**
+ * @brief ctr_test_parallel
+ * Wynik przetwarzania wielowątkowego jest identyczny z jednowątkowym.
+ */
+void ctr_test_parallel() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    auto check = [&](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+        vector<u8> plain(100003);
+        Crypto::random_bytes(plain.data(), int(plain.size()));
+
+        Parallel::set_concurrency(1);
+        vector<u8> serial(plain.size());
+        cipher.crypt_ctr(iv, 5, plain.data(), serial.data(), int(plain.size()));
+
+        Parallel::set_concurrency(4);
+        Parallel::set_threshold(1024);
+        vector<u8> parallel(plain.size());
+        cipher.crypt_ctr(iv, 5, plain.data(), parallel.data(), int(plain.size()));
+        assert(serial == parallel);
+
+        Parallel::set_threshold(threshold);
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "ctr_test_parallel: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                   C F B   /   O F B                              *
+ *                                                                  *
+ ********************************************************************/
+
+void test_feedback() {
+    feedback_test_definition();
+    feedback_test_streaming();
+    feedback_test_parallel();
+}
+
+/**
+ * @brief feedback_test_definition
+ * Pierwsze segmenty wyznaczone wprost z definicji trybów.
+ */
+void feedback_test_definition() {
+    u8 key[16];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+
+    u32 iv[2], plain[4], ks[2];
+    Crypto::random_bytes(iv, sizeof(iv));
+    Crypto::random_bytes(plain, sizeof(plain));
+
+    // CFB: C1 = P1 ^ E(IV), C2 = P2 ^ E(C1)
+    const auto [cfb, n1] = bf.encrypt_cfb(plain, 16, iv);
+    assert(n1 == 24);
+    const u32* const c = static_cast<const u32*>(cfb.get()) + 2;
+    bf.encrypt_block(iv, ks);
+    assert(c[0] == (plain[0] ^ ks[0]) && c[1] == (plain[1] ^ ks[1]));
+    bf.encrypt_block(c, ks);
+    assert(c[2] == (plain[2] ^ ks[0]) && c[3] == (plain[3] ^ ks[1]));
+
+    // CFB8: C1 = P1 ^ MSB8(E(IV))
+    const auto [cfb8, n2] = bf.encrypt_cfb8(plain, 16, iv);
+    assert(n2 == 24);
+    bf.encrypt_block(iv, ks);
+    assert(static_cast<const u8*>(cfb8.get())[8] == (reinterpret_cast<const u8*>(plain)[0] ^ reinterpret_cast<const u8*>(ks)[0]));
+
+    // OFB: O1 = E(IV), O2 = E(O1)
+    const auto [ofb, n3] = bf.encrypt_ofb(plain, 16, iv);
+    assert(n3 == 24);
+    const u32* const o = static_cast<const u32*>(ofb.get()) + 2;
+    bf.encrypt_block(iv, ks);
+    assert(o[0] == (plain[0] ^ ks[0]) && o[1] == (plain[1] ^ ks[1]));
+    bf.encrypt_block(ks, ks);
+    assert(o[2] == (plain[2] ^ ks[0]) && o[3] == (plain[3] ^ ks[1]));
+
+    cout << "feedback_test_definition: OK" << endl;
+}
+
+/**
+ * @brief feedback_test_streaming
+ * Wynik przetwarzania porcjami dowolnej długości jest identyczny
+ * z wynikiem funkcji jednorazowych.
+ */
+void feedback_test_streaming() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+        vector<u8> plain(1001);
+        Crypto::random_bytes(plain.data(), int(plain.size()));
+        const int size = int(plain.size());
+
+        auto chunked = [&](auto&& stream, const u8* src, u8* dst) {
+            for (int done = 0, step = 1; done < size; step = step * 3 % 37 + 1) {
+                const int n = std::min(step, size - done);
+                stream.update(src + done, dst + done, n);
+                done += n;
+            }
+        };
+
+        for (const int segment : {bs, 1}) {
+            const auto [encrypted, n] = (segment == 1)
+                    ? cipher.encrypt_cfb8(plain.data(), size, iv)
+                    : cipher.encrypt_cfb(plain.data(), size, iv);
+            assert(n == size + bs);
+            const u8* const ct = static_cast<const u8*>(encrypted.get()) + bs;
+
+            vector<u8> buffer(plain);
+            chunked(Cfb<Cipher>(cipher, iv, false, segment), buffer.data(), buffer.data());
+            assert(Crypto::compare_bytes(buffer.data(), ct, size));
+            chunked(Cfb<Cipher>(cipher, iv, true, segment), buffer.data(), buffer.data());
+            assert(buffer == plain);
+
+            const auto [decrypted, k] = (segment == 1)
+                    ? cipher.decrypt_cfb8(encrypted.get(), n)
+                    : cipher.decrypt_cfb(encrypted.get(), n);
+            assert(k == size);
+            assert(Crypto::compare_bytes(decrypted.get(), plain.data(), size));
+        }
+
+        const auto [encrypted, n] = cipher.encrypt_ofb(plain.data(), size, iv);
+        vector<u8> buffer(plain);
+        chunked(Ofb<Cipher>(cipher, iv), buffer.data(), buffer.data());
+        assert(Crypto::compare_bytes(buffer.data(), static_cast<const u8*>(encrypted.get()) + bs, size));
+        const auto [decrypted, k] = cipher.decrypt_ofb(encrypted.get(), n);
+        assert(k == size);
+        assert(Crypto::compare_bytes(decrypted.get(), plain.data(), size));
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "feedback_test_streaming: OK" << endl;
+}
+
+/**
+ * @brief feedback_test_parallel
+ * Wielowątkowe deszyfrowanie CFB daje te same dane co szyfrowanie sekwencyjne.
+ */
+void feedback_test_parallel() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+    Parallel::set_concurrency(4);
+    Parallel::set_threshold(1024);
+
+    auto check = [](const auto& cipher) {
+        vector<u8> plain(100003);
+        Crypto::random_bytes(plain.data(), int(plain.size()));
+        const int size = int(plain.size());
+        {
+            const auto [encrypted, n] = cipher.encrypt_cfb(plain.data(), size);
+            const auto [decrypted, k] = cipher.decrypt_cfb(encrypted.get(), n);
+            assert(k == size);
+            assert(Crypto::compare_bytes(decrypted.get(), plain.data(), size));
+        }
+        {
+            const auto [encrypted, n] = cipher.encrypt_cfb8(plain.data(), size);
+            const auto [decrypted, k] = cipher.decrypt_cfb8(encrypted.get(), n);
+            assert(k == size);
+            assert(Crypto::compare_bytes(decrypted.get(), plain.data(), size));
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "feedback_test_parallel: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                     R E S E R V O I R                            *
+ *                                                                  *
+ ********************************************************************/
+
+void test_reservoir() {
+    reservoir_test_ctr();
+    reservoir_test_ofb();
+}
+
+/**
+ * @brief reservoir_test_ctr
+ * Każde żądanie jest zaszyfrowane fragmentem strumienia CTR
+ * od zwróconej pozycji; żądania większe od zbiornika też działają
+ * (także przy zerowym progu uzupełniania).
+ */
+void reservoir_test_ctr() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        u8 iv[Cipher::BlockSize];
+        Crypto::random_bytes(iv, sizeof(iv));
+        KeystreamReservoir<Cipher> reservoir(cipher, iv, KeystreamReservoir<Cipher>::Mode::Ctr, 4096, 1024);
+        assert(reservoir.available() == 4096);
+
+        u64 expected_offset = 0;
+        u64 total = 0;
+        for (const int size : {1, 13, 100, 3000, 20000, 7, 4096}) {
+            vector<u8> plain(size);
+            Crypto::random_bytes(plain.data(), size);
+            vector<u8> encrypted(size);
+            const u64 offset = reservoir.crypt(plain.data(), encrypted.data(), size);
+            assert(offset == expected_offset);
+            expected_offset += size;
+            total += size;
+
+            vector<u8> decrypted(size);
+            cipher.crypt_ctr(iv, offset, encrypted.data(), decrypted.data(), size);
+            assert(decrypted == plain);
+        }
+        const auto stats = reservoir.statistics();
+        assert(stats.requests == 7);
+        assert(stats.bytes == total);
+        assert(stats.drains >= 1);
+        assert(stats.refills >= 1);
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    {   // zerowy próg nie może wstrzymać uzupełniania bufora
+        u8 iv[Blowfish::BlockSize];
+        Crypto::random_bytes(iv, sizeof(iv));
+        KeystreamReservoir<Blowfish> reservoir(bf, iv, KeystreamReservoir<Blowfish>::Mode::Ctr, 1024, 0);
+        vector<u8> data(5000);
+        assert(reservoir.crypt(data.data(), data.data(), int(data.size())) == 0);
+        assert(reservoir.crypt(data.data(), data.data(), 100) == data.size());
+    }
+
+    cout << "reservoir_test_ctr: OK" << endl;
+}
+
+/**
+ * @brief reservoir_test_ofb
+ * Kolejne żądania tworzą ciągły strumień OFB.
+ */
+void reservoir_test_ofb() {
+    u8 key[16];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    u8 iv[Blowfish::BlockSize];
+    Crypto::random_bytes(iv, sizeof(iv));
+
+    vector<u8> plain(10000);
+    Crypto::random_bytes(plain.data(), int(plain.size()));
+    vector<u8> encrypted(plain.size());
+    {
+        KeystreamReservoir<Blowfish> reservoir(bf, iv, KeystreamReservoir<Blowfish>::Mode::Ofb, 2048);
+        for (int done = 0, step = 1; done < int(plain.size()); step = step * 7 % 1500 + 1) {
+            const int n = std::min(step, int(plain.size()) - done);
+            assert(reservoir.crypt(plain.data() + done, encrypted.data() + done, n) == u64(done));
+            done += n;
+        }
+    }
+    const auto [expected, n] = bf.encrypt_ofb(plain.data(), int(plain.size()), iv);
+    assert(Crypto::compare_bytes(encrypted.data(), static_cast<const u8*>(expected.get()) + Blowfish::BlockSize, int(plain.size())));
+
+    cout << "reservoir_test_ofb: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                           X T S                                  *
+ *                                                                  *
+ ********************************************************************/
+
+void test_xts() {
+    xts_test_multiply();
+    xts_test_sector();
+    xts_test_batch();
+}
+
+/**
+ * @brief xts_test_multiply
+ * Mnożenie przez x z redukcją wielomianem ciała.
+ */
+void xts_test_multiply() {
+    u8 t8[8] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80};
+    const u8 expected8[8] = {0x02 ^ 0x1b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    Xts<Blowfish>::multiply(t8);
+    assert(Crypto::compare_bytes(t8, expected8, 8));
+
+    u8 t12[12] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0};
+    const u8 expected12[12] = {0x41, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80};
+    Xts<Way3>::multiply(t12);
+    assert(Crypto::compare_bytes(t12, expected12, 12));
+
+    cout << "xts_test_multiply: OK" << endl;
+}
+
+/**
+ * @brief xts_test_sector
+ * Sektory (także niewyrównane do bloku) są odwracalne, zachowują rozmiar
+ * i zależą od numeru sektora.
+ */
+void xts_test_sector() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16), bf_tweak(key + 32, 16);
+    const Gost gt(key, 32), gt_tweak(key + 32, 32);
+    const Way3 w3(key, 12), w3_tweak(key + 32, 12);
+
+    auto check = [](const auto& cipher, const auto& tweak) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        for (const int nbytes : {bs, bs + 1, 2 * bs - 1, 100, 512, 4096, 4099}) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+
+            vector<u8> a(plain), b(plain);
+            assert(Xts<Cipher>::encrypt_sector(cipher, tweak, 7, a.data(), nbytes));
+            assert(Xts<Cipher>::encrypt_sector(cipher, tweak, 8, b.data(), nbytes));
+            assert(a != plain && a != b);
+
+            assert(Xts<Cipher>::decrypt_sector(cipher, tweak, 7, a.data(), nbytes));
+            assert(a == plain);
+            assert(Xts<Cipher>::decrypt_sector(cipher, tweak, 8, b.data(), nbytes));
+            assert(b == plain);
+        }
+        u8 small[bs - 1] = {};
+        assert(!Xts<Cipher>::encrypt_sector(cipher, tweak, 0, small, bs - 1));
+    };
+    check(bf, bf_tweak);
+    check(gt, gt_tweak);
+    check(w3, w3_tweak);
+
+    cout << "xts_test_sector: OK" << endl;
+}
+
+/**
+ * @brief xts_test_batch
+ * Przetwarzanie wsadowe (wielowątkowe) daje wyniki identyczne
+ * z przetwarzaniem sektorów pojedynczo.
+ */
+void xts_test_batch() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16), bf_tweak(key + 32, 16);
+    const Gost gt(key, 32), gt_tweak(key + 32, 32);
+    const Way3 w3(key, 12), w3_tweak(key + 32, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+    Parallel::set_concurrency(4);
+    Parallel::set_threshold(1024);
+
+    auto check = [](const auto& cipher, const auto& tweak) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int page = 4096;
+        constexpr int count = 37;
+        vector<u8> plain(count * page);
+        Crypto::random_bytes(plain.data(), int(plain.size()));
+
+        vector<u8> batch(plain);
+        vector<typename Xts<Cipher>::Sector> sectors;
+        for (int i = 0; i < count; i++) {
+            sectors.push_back({u64(1000 + 3 * i), batch.data() + i * page, page});
+        }
+        assert(Xts<Cipher>::encrypt_sectors(cipher, tweak, sectors.data(), count) == count);
+
+        vector<u8> single(plain);
+        for (int i = 0; i < count; i++) {
+            Xts<Cipher>::encrypt_sector(cipher, tweak, u64(1000 + 3 * i), single.data() + i * page, page);
+        }
+        assert(batch == single);
+
+        assert(Xts<Cipher>::decrypt_sectors(cipher, tweak, sectors.data(), count) == count);
+        assert(batch == plain);
+
+        sectors[5].nbytes = Cipher::BlockSize - 1;
+        assert(Xts<Cipher>::encrypt_sectors(cipher, tweak, sectors.data(), count) == -1);
+        assert(batch == plain);
+    };
+    check(bf, bf_tweak);
+    check(gt, gt_tweak);
+    check(w3, w3_tweak);
+
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "xts_test_batch: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                          C M A C                                 *
+ *                                                                  *
+ ********************************************************************/
+
+void test_cmac() {
+    cmac_test_definition();
+    cmac_test_streaming();
+    cmac_test_batch();
+}
+
+/**
+ * @brief cmac_test_definition
+ * Znaczniki wiadomości jedno- i dwublokowych wyznaczone wprost z definicji.
+ */
+void cmac_test_definition() {
+    u8 key[16];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+
+    // K1 = L * x, K2 = L * x^2, L = E(0)
+    u32 l[2] = {}, k1[2], k2[2];
+    bf.encrypt_block(l, l);
+    memcpy(k1, l, 8);
+    Cmac<Blowfish>::multiply(reinterpret_cast<u8*>(k1));
+    memcpy(k2, k1, 8);
+    Cmac<Blowfish>::multiply(reinterpret_cast<u8*>(k2));
+
+    // pełny blok: T = E(M ^ K1)
+    u32 m[2], t[2], tag[2];
+    Crypto::random_bytes(m, sizeof(m));
+    t[0] = m[0] ^ k1[0];
+    t[1] = m[1] ^ k1[1];
+    bf.encrypt_block(t, t);
+    bf.cmac(m, 8, tag);
+    assert(Crypto::compare_bytes(tag, t, 8));
+
+    // pusta wiadomość: T = E(10..0 ^ K2)
+    u8 pad[8] = {0x80};
+    Crypto::xor_bytes(t, pad, k2, 8);
+    bf.encrypt_block(t, t);
+    bf.cmac(nullptr, 0, tag);
+    assert(Crypto::compare_bytes(tag, t, 8));
+
+    // mnożenie big-endian z redukcją
+    u8 b[12] = {0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+    const u8 expected[12] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x02 ^ 0x41};
+    Cmac<Way3>::multiply(b);
+    assert(Crypto::compare_bytes(b, expected, 12));
+
+    cout << "cmac_test_definition: OK" << endl;
+}
+
+/**
+ * @brief cmac_test_streaming
+ * Znacznik nie zależy od podziału danych na porcje; zmiana danych
+ * lub znacznika jest wykrywana.
+ */
+void cmac_test_streaming() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        for (const int nbytes : {1, bs - 1, bs, bs + 1, 2 * bs, 1000}) {
+            vector<u8> data(nbytes);
+            Crypto::random_bytes(data.data(), nbytes);
+            u8 tag[bs], streamed[bs];
+            cipher.cmac(data.data(), nbytes, tag);
+
+            Cmac<Cipher> mac(cipher);
+            for (int done = 0, step = 1; done < nbytes; step = step * 5 % 23 + 1) {
+                const int n = std::min(step, nbytes - done);
+                mac.update(data.data() + done, n);
+                done += n;
+            }
+            mac.finalize(streamed);
+            assert(Crypto::compare_bytes(tag, streamed, bs));
+            assert(Cmac<Cipher>::verify(cipher, data.data(), nbytes, tag));
+
+            data[nbytes / 2] ^= 0x01;
+            assert(!Cmac<Cipher>::verify(cipher, data.data(), nbytes, tag));
+            data[nbytes / 2] ^= 0x01;
+            tag[0] ^= 0x80;
+            assert(!Cmac<Cipher>::verify(cipher, data.data(), nbytes, tag));
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "cmac_test_streaming: OK" << endl;
+}
+
+/**
+ * @brief cmac_test_batch
+ * Znaczniki wyznaczone wsadowo (przeplatane łańcuchy, wiele wątków)
+ * są identyczne z wyznaczonymi pojedynczo.
+ */
+void cmac_test_batch() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        constexpr int count = 301;
+        vector<vector<u8>> data(count);
+        vector<typename Cmac<Cipher>::Message> messages(count);
+        vector<u8> tags(count * bs);
+        for (int i = 0; i < count; i++) {
+            data[i].resize((i * 37) % 200);
+            Crypto::random_bytes(data[i].data(), int(data[i].size()));
+            messages[i] = {data[i].data(), int(data[i].size()), tags.data() + i * bs};
+        }
+        Cmac<Cipher>::compute_batch(cipher, messages.data(), count);
+        for (int i = 0; i < count; i++) {
+            u8 tag[bs];
+            cipher.cmac(data[i].data(), int(data[i].size()), tag);
+            assert(Crypto::compare_bytes(tag, tags.data() + i * bs, bs));
+        }
+    };
+    for (const int n : {1, 4}) {
+        Parallel::set_concurrency(n);
+        Parallel::set_threshold(1024);
+        check(bf);
+        check(gt);
+        check(w3);
+    }
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "cmac_test_batch: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                  E N C R Y P T - T H E N - M A C                 *
+ *                                                                  *
+ ********************************************************************/
+
+void test_etm() {
+    etm_test_roundtrip();
+    etm_test_forgery();
+}
+
+/**
+ * @brief etm_test_roundtrip
+ * Szyfrogram to CTR z tym samym IV, znacznik to CMAC nagłówka i szyfrogramu.
+ */
+void etm_test_roundtrip() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16), bf_mac(key + 32, 16);
+    const Gost gt(key, 32), gt_mac(key + 32, 32);
+    const Way3 w3(key, 12), w3_mac(key + 32, 12);
+
+    auto check = [](const auto& cipher, const auto& mac) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        const string ad = "record #17";
+        for (const int nbytes : {1, bs, 100, 10000}) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+
+            const auto [encrypted, n] = Etm<Cipher>::encrypt(cipher, mac, plain.data(), nbytes, ad.data(), int(ad.size()));
+            assert(n == bs + nbytes + Etm<Cipher>::TagSize);
+            const u8* const out = static_cast<const u8*>(encrypted.get());
+
+            vector<u8> ctr(nbytes);
+            cipher.crypt_ctr(out, 0, plain.data(), ctr.data(), nbytes);
+            assert(Crypto::compare_bytes(out + bs, ctr.data(), nbytes));
+
+            const auto [decrypted, k] = Etm<Cipher>::decrypt(cipher, mac, encrypted.get(), n, ad.data(), int(ad.size()));
+            assert(k == nbytes);
+            assert(Crypto::compare_bytes(decrypted.get(), plain.data(), nbytes));
+
+            const auto [plain_only, m] = Etm<Cipher>::encrypt(cipher, mac, plain.data(), nbytes);
+            assert(std::get<1>(Etm<Cipher>::decrypt(cipher, mac, plain_only.get(), m)) == nbytes);
+        }
+    };
+    check(bf, bf_mac);
+    check(gt, gt_mac);
+    check(w3, w3_mac);
+
+    cout << "etm_test_roundtrip: OK" << endl;
+}
+
+/**
+ * @brief etm_test_forgery
+ * Zmiana IV, szyfrogramu, znacznika lub danych dodatkowych
+ * jest wykrywana przed deszyfrowaniem, także dla pustej wiadomości.
+ */
+void etm_test_forgery() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Gost gt(key, 32), mac(key + 32, 32);
+
+    vector<u8> plain(1000);
+    Crypto::random_bytes(plain.data(), int(plain.size()));
+    const string ad = "header";
+    const auto [encrypted, n] = Etm<Gost>::encrypt(gt, mac, plain.data(), int(plain.size()), ad.data(), int(ad.size()));
+    vector<u8> data(static_cast<const u8*>(encrypted.get()), static_cast<const u8*>(encrypted.get()) + n);
+
+    for (const int pos : {0, 8, 500, n - 1}) {
+        data[pos] ^= 0x01;
+        const auto [decrypted, k] = Etm<Gost>::decrypt(gt, mac, data.data(), n, ad.data(), int(ad.size()));
+        assert(decrypted == nullptr && k == -1);
+        data[pos] ^= 0x01;
+    }
+    const string other = "headeR";
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, data.data(), n, other.data(), int(other.size()))) == -1);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, data.data(), n)) == -1);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, gt, data.data(), n, ad.data(), int(ad.size()))) == -1);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, data.data(), 16, ad.data(), int(ad.size()))) == -1);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, data.data(), n, ad.data(), int(ad.size()))) == int(plain.size()));
+
+    // pusta wiadomość jest uwierzytelniona, obcięcie do zera bajtów - nie
+    constexpr int empty_size = Gost::BlockSize + Etm<Gost>::TagSize;
+    const auto [empty, e] = Etm<Gost>::encrypt(gt, mac, nullptr, 0, ad.data(), int(ad.size()));
+    assert(e == empty_size);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, empty.get(), e, ad.data(), int(ad.size()))) == 0);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, empty.get(), e, other.data(), int(other.size()))) == -1);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, empty.get(), e - 1, ad.data(), int(ad.size()))) == -1);
+    assert(std::get<1>(Etm<Gost>::decrypt(gt, mac, data.data(), 0, ad.data(), int(ad.size()))) == -1);
+
+    cout << "etm_test_forgery: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                           S I V                                  *
+ *                                                                  *
+ ********************************************************************/
+
+void test_siv() {
+    siv_test_deterministic();
+    siv_test_parallel();
+}
+
+/**
+ * @brief siv_test_deterministic
+ * Te same dane dają ten sam szyfrogram, różne dane (lub dane dodatkowe)
+ * różne; zmiany szyfrogramu (także pustego) i obcięcie są wykrywane.
+ */
+void siv_test_deterministic() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16), bf_mac(key + 32, 16);
+    const Gost gt(key, 32), gt_mac(key + 32, 32);
+    const Way3 w3(key, 12), w3_mac(key + 32, 12);
+
+    auto check = [](const auto& cipher, const auto& mac) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        for (const int nbytes : {1, bs, 1000}) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+
+            const auto [a, n] = Siv<Cipher>::encrypt(cipher, mac, plain.data(), nbytes);
+            const auto [b, m] = Siv<Cipher>::encrypt(cipher, mac, plain.data(), nbytes);
+            assert(n == nbytes + bs && m == n);
+            assert(Crypto::compare_bytes(a.get(), b.get(), n));
+
+            const auto [c, k] = Siv<Cipher>::encrypt(cipher, mac, plain.data(), nbytes, "x", 1);
+            assert(k == n && !Crypto::compare_bytes(a.get(), c.get(), bs));
+            plain[0] ^= 0x01;
+            const auto [d, l] = Siv<Cipher>::encrypt(cipher, mac, plain.data(), nbytes);
+            assert(l == n && !Crypto::compare_bytes(a.get(), d.get(), bs));
+            plain[0] ^= 0x01;
+
+            const auto [decrypted, size] = Siv<Cipher>::decrypt(cipher, mac, a.get(), n);
+            assert(size == nbytes && Crypto::compare_bytes(decrypted.get(), plain.data(), nbytes));
+            assert(std::get<1>(Siv<Cipher>::decrypt(cipher, mac, c.get(), n)) == -1);
+
+            vector<u8> forged(static_cast<const u8*>(a.get()), static_cast<const u8*>(a.get()) + n);
+            forged[n - 1] ^= 0x01;
+            assert(std::get<1>(Siv<Cipher>::decrypt(cipher, mac, forged.data(), n)) == -1);
+        }
+    };
+    check(bf, bf_mac);
+    check(gt, gt_mac);
+    check(w3, w3_mac);
+
+    // pusta wiadomość to samo V (uwierzytelnia dane dodatkowe), krótsze dane są odrzucane
+    const auto [empty, e] = Siv<Gost>::encrypt(gt, gt_mac, nullptr, 0, "x", 1);
+    assert(e == Gost::BlockSize);
+    assert(std::get<1>(Siv<Gost>::decrypt(gt, gt_mac, empty.get(), e, "x", 1)) == 0);
+    assert(std::get<1>(Siv<Gost>::decrypt(gt, gt_mac, empty.get(), e, "y", 1)) == -1);
+    assert(std::get<1>(Siv<Gost>::decrypt(gt, gt_mac, empty.get(), e - 1, "x", 1)) == -1);
+    assert(std::get<1>(Siv<Gost>::decrypt(gt, gt_mac, empty.get(), 0, "x", 1)) == -1);
+
+    cout << "siv_test_deterministic: OK" << endl;
+}
+
+/**
+ * @brief siv_test_parallel
+ * Wynik nie zależy od liczby wątków.
+ */
+void siv_test_parallel() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Way3 w3(key, 12), mac(key + 32, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    vector<u8> plain(300001);
+    Crypto::random_bytes(plain.data(), int(plain.size()));
+    const int size = int(plain.size());
+
+    Parallel::set_concurrency(1);
+    const auto [serial, n] = Siv<Way3>::encrypt(w3, mac, plain.data(), size);
+    Parallel::set_concurrency(4);
+    Parallel::set_threshold(1024);
+    const auto [parallel, m] = Siv<Way3>::encrypt(w3, mac, plain.data(), size);
+    assert(n == m && Crypto::compare_bytes(serial.get(), parallel.get(), n));
+    const auto [decrypted, k] = Siv<Way3>::decrypt(w3, mac, parallel.get(), m);
+    assert(k == size && Crypto::compare_bytes(decrypted.get(), plain.data(), size));
+
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "siv_test_parallel: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                         R A N G E                                *
+ *                                                                  *
+ ********************************************************************/
+
+void test_range() {
+    range_test_cbc();
+}
+
+/**
+ * @brief range_test_cbc
+ * Fragment odszyfrowany wprost jest identyczny z fragmentem
+ * całych odszyfrowanych danych; zakres jest przycinany do ich długości.
+ */
+void range_test_cbc() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        for (const Padding padding : {Padding::Pkcs7, Padding::Iso7816, Padding::Cts}) {
+            const int nbytes = 1001;
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+            const auto [encrypted, n] = cipher.encrypt_cbc(plain.data(), nbytes, nullptr, padding);
+
+            for (const auto& [offset, length] : {std::pair(0, 1), std::pair(5, 3), std::pair(bs - 1, 2),
+                                                std::pair(100, 250), std::pair(990, 100), std::pair(0, nbytes)}) {
+                const auto [part, k] = cipher.decrypt_cbc_range(encrypted.get(), n, offset, length, padding);
+                const int expected = std::min(length, nbytes - offset);
+                assert(k == expected);
+                assert(Crypto::compare_bytes(part.get(), plain.data() + offset, k));
+            }
+            assert(std::get<1>(cipher.decrypt_cbc_range(encrypted.get(), n, nbytes, 10, padding)) == 0);
+            assert(std::get<1>(cipher.decrypt_cbc_range(encrypted.get(), n, -1, 10, padding)) == -1);
+        }
+        // niepoprawny rozmiar szyfrogramu
+        u8 data[3 * bs] = {};
+        assert(std::get<1>(cipher.decrypt_cbc_range(data, 3 * bs - 1, 0, 4, Padding::Pkcs7)) == -1);
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "range_test_cbc: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                       C A S C A D E                              *
+ *                                                                  *
+ ********************************************************************/
+
+void test_cascade() {
+    cascade_test_stages();
+    cascade_test_roundtrip();
+}
+
+/**
+ * @brief cascade_test_stages
+ * Kaskada jest równoważna kolejnym wywołaniom CBC (bez paddingu)
+ * na danych uzupełnionych raz do wspólnej wielokrotności bloków.
+ */
+void cascade_test_stages() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Way3 w3(key + 16, 12);
+
+    static_assert(Cascade<Blowfish, Way3>::Alignment == 24);
+    static_assert(Cascade<Blowfish, Way3>::HeaderSize == 20);
+
+    // jeden etap: identycznie jak encrypt_cbc z PKCS#7
+    u8 iv[8];
+    Crypto::random_bytes(iv, sizeof(iv));
+    vector<u8> plain(40000);
+    Crypto::random_bytes(plain.data(), int(plain.size()));
+    const auto [single, n] = Cascade<Blowfish>(bf).encrypt(plain.data(), int(plain.size()), iv);
+    const auto [cbc, m] = bf.encrypt_cbc(plain.data(), int(plain.size()), iv, Padding::Pkcs7);
+    assert(n == m && Crypto::compare_bytes(single.get(), cbc.get(), n));
+
+    // dwa etapy: Blowfish, a potem Way3 na szyfrogramie Blowfish
+    u8 ivs[20];
+    Crypto::random_bytes(ivs, sizeof(ivs));
+    const int size = int(plain.size());
+    vector<u8> padded(Crypto::padded_size(size, 24, Padding::Pkcs7));
+    memcpy(padded.data(), plain.data(), size);
+    Crypto::pad(padded.data(), size, 24, Padding::Pkcs7);
+    const auto [first, k] = bf.encrypt_cbc(padded.data(), int(padded.size()), ivs, Padding::None);
+    const auto [second, l] = w3.encrypt_cbc(static_cast<u8*>(first.get()) + 8, k - 8, ivs + 8, Padding::None);
+
+    const auto [cascade, c] = Cascade<Blowfish, Way3>(bf, w3).encrypt(plain.data(), size, ivs);
+    assert(c == 8 + l);
+    assert(Crypto::compare_bytes(cascade.get(), ivs, 8));
+    assert(Crypto::compare_bytes(static_cast<u8*>(cascade.get()) + 8, second.get(), l));
+
+    cout << "cascade_test_stages: OK" << endl;
+}
+
+/**
+ * @brief cascade_test_roundtrip
+ */
+void cascade_test_roundtrip() {
+    u8 key[64];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key + 16, 32);
+    const Way3 w3(key + 48, 12);
+    const Cascade<Blowfish, Gost, Way3> cascade(bf, gt, w3);
+
+    for (const int nbytes : {1, 23, 24, 25, 16384, 16385, 100000}) {
+        vector<u8> plain(nbytes);
+        Crypto::random_bytes(plain.data(), nbytes);
+        const auto [encrypted, n] = cascade.encrypt(plain.data(), nbytes);
+        assert(n == 28 + (nbytes / 24 + 1) * 24);
+        const auto [decrypted, k] = cascade.decrypt(encrypted.get(), n);
+        assert(k == nbytes && Crypto::compare_bytes(decrypted.get(), plain.data(), k));
+    }
+    u8 data[28 + 24] = {};
+    assert(std::get<1>(cascade.decrypt(data, 28 + 12)) == -1);
+
+    cout << "cascade_test_roundtrip: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                           E C B                                  *
+ *                                                                  *
+ ********************************************************************/
+
+void test_ecb() {
+    ecb_test_parallel();
+    cbc_test_parallel_decrypt();
+    cbc_test_batch();
+}
+
+/**
+ * @brief ecb_test_parallel
+ * Wynik przetwarzania wielowątkowego jest identyczny z jednowątkowym.
+ */
+void ecb_test_parallel() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    auto check = [](const auto& cipher) {
+        vector<u8> plain(100003);
+        Crypto::random_bytes(plain.data(), int(plain.size()));
+        const int size = int(plain.size());
+
+        Parallel::set_concurrency(1);
+        const auto [serial, n] = cipher.encrypt_ecb(plain.data(), size, Padding::Pkcs7);
+        Parallel::set_concurrency(4);
+        Parallel::set_threshold(1024);
+        const auto [parallel, m] = cipher.encrypt_ecb(plain.data(), size, Padding::Pkcs7);
+        assert(n == m && Crypto::compare_bytes(serial.get(), parallel.get(), n));
+
+        const auto [decrypted, k] = cipher.decrypt_ecb(parallel.get(), m, Padding::Pkcs7);
+        assert(k == size && Crypto::compare_bytes(decrypted.get(), plain.data(), size));
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "ecb_test_parallel: OK" << endl;
+}
+
+/**
+ * @brief cbc_test_parallel_decrypt
+ * Wielowątkowe deszyfrowanie CBC daje dane identyczne z jednowątkowym
+ * dla wszystkich rodzajów paddingu.
+ */
+void cbc_test_parallel_decrypt() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    auto check = [](const auto& cipher) {
+        for (const Padding padding : {Padding::Pkcs7, Padding::Iso7816, Padding::None}) {
+            vector<u8> plain(padding == Padding::None ? 98304 : 100003);
+            Crypto::random_bytes(plain.data(), int(plain.size()));
+            const int size = int(plain.size());
+            const auto [encrypted, n] = cipher.encrypt_cbc(plain.data(), size, nullptr, padding);
+
+            Parallel::set_concurrency(1);
+            const auto [serial, k] = cipher.decrypt_cbc(encrypted.get(), n, padding);
+            Parallel::set_concurrency(4);
+            Parallel::set_threshold(1024);
+            const auto [parallel, l] = cipher.decrypt_cbc(encrypted.get(), n, padding);
+            assert(k == size && l == size);
+            assert(Crypto::compare_bytes(serial.get(), plain.data(), size));
+            assert(Crypto::compare_bytes(parallel.get(), plain.data(), size));
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "cbc_test_parallel_decrypt: OK" << endl;
+}
+
+/**
+ * @brief cbc_test_batch
+ * Wiadomości szyfrowane wsadowo (przeplatane łańcuchy) są identyczne
+ * z szyfrowanymi pojedynczo przez encrypt_cbc.
+ */
+void cbc_test_batch() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        constexpr int count = 203;
+        for (const Padding padding : {Padding::Pkcs7, Padding::Iso7816}) {
+            vector<vector<u8>> plain(count), out(count), ivs(count);
+            vector<typename Cbc<Cipher>::Job> jobs(count);
+            for (int i = 0; i < count; i++) {
+                plain[i].resize((i * 29) % 300 + 1);
+                Crypto::random_bytes(plain[i].data(), int(plain[i].size()));
+                plain[i].back() |= 0x01;
+                ivs[i].resize(bs);
+                Crypto::random_bytes(ivs[i].data(), bs);
+                out[i].resize(plain[i].size() + 2 * bs);
+                jobs[i] = {plain[i].data(), int(plain[i].size()), ivs[i].data(), out[i].data(), 0};
+            }
+            jobs[7].nbytes = 0;
+            assert(Cbc<Cipher>::encrypt_batch(cipher, jobs.data(), count, padding) == count - 1);
+            assert(jobs[7].size == 0);
+
+            for (int i = 0; i < count; i++) {
+                if (i == 7) {
+                    continue;
+                }
+                const auto [expected, n] = cipher.encrypt_cbc(plain[i].data(), int(plain[i].size()), ivs[i].data(), padding);
+                assert(jobs[i].size == n);
+                assert(Crypto::compare_bytes(out[i].data(), expected.get(), n));
+            }
+        }
+        u8 buffer[64] = {};
+        typename Cbc<Cipher>::Job cts = {buffer, 20, nullptr, buffer, 0};
+        assert(Cbc<Cipher>::encrypt_batch(cipher, &cts, 1, Padding::Cts) == 0 && cts.size == -1);
+    };
+    for (const int n : {1, 4}) {
+        Parallel::set_concurrency(n);
+        Parallel::set_threshold(1024);
+        check(bf);
+        check(gt);
+        check(w3);
+    }
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "cbc_test_batch: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                    K E Y E D   B A T C H                         *
+ *                                                                  *
+ ********************************************************************/
+
+void test_keyed_batch() {
+    keyed_batch_test_cbc();
+}
+
+/**
+ * @brief keyed_batch_test_cbc
+ * Wyniki wsadu wiadomości pod różnymi kluczami leżą we wspólnym buforze
+ * w kolejności wiadomości i są identyczne z encrypt_cbc ich kontekstów.
+ */
+void keyed_batch_test_cbc() {
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    auto check = [](auto* contexts, const int ncontexts) {
+        using Cipher = std::remove_pointer_t<decltype(contexts)>;
+        constexpr int bs = Cipher::BlockSize;
+        constexpr int count = 150;
+        vector<vector<u8>> plain(count);
+        vector<typename KeyedBatch<Cipher>::Request> requests(count);
+        vector<typename KeyedBatch<Cipher>::Result> results(count);
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+        for (int i = 0; i < count; i++) {
+            plain[i].resize((i * 13) % 90 + 1);
+            Crypto::random_bytes(plain[i].data(), int(plain[i].size()));
+            requests[i] = {&contexts[(i * 7) % ncontexts], plain[i].data(), int(plain[i].size()), iv};
+        }
+        requests[3].context = nullptr;
+
+        const auto [arena, total] = KeyedBatch<Cipher>::encrypt_cbc(requests.data(), count, results.data());
+        int offset = 0;
+        for (int i = 0; i < count; i++) {
+            assert(results[i].offset == offset);
+            if (i == 3) {
+                assert(results[i].size == -1);
+                continue;
+            }
+            const auto [expected, n] = requests[i].context->encrypt_cbc(plain[i].data(), int(plain[i].size()), iv, Padding::Pkcs7);
+            assert(results[i].size == n);
+            assert(Crypto::compare_bytes(static_cast<u8*>(arena.get()) + offset, expected.get(), n));
+            offset += n;
+        }
+        assert(total == offset);
+    };
+
+    constexpr int ncontexts = 11;
+    vector<Blowfish> bf(ncontexts);
+    vector<Gost> gt(ncontexts);
+    vector<Way3> w3(ncontexts);
+    for (int i = 0; i < ncontexts; i++) {
+        u8 key[32];
+        Crypto::random_bytes(key, sizeof(key));
+        bf[i].rekey(key, 16);
+        gt[i].rekey(key, 32);
+        w3[i].rekey(key, 12);
+    }
+    for (const int n : {1, 4}) {
+        Parallel::set_concurrency(n);
+        Parallel::set_threshold(1024);
+        check(bf.data(), ncontexts);
+        check(gt.data(), ncontexts);
+        check(w3.data(), ncontexts);
+    }
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "keyed_batch_test_cbc: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                    T H R E A D   P O O L                         *
+ *                                                                  *
+ ********************************************************************/
+
+void test_thread_pool() {
+    thread_pool_test_nested();
+    thread_pool_test_executor();
+    thread_pool_test_scratch();
+    thread_pool_test_queue();
+}
+
+/**
+ * @brief thread_pool_test_nested
+ * Zagnieżdżone wywołania for_each na małej puli kończą się
+ * (oczekujący wątek wykonuje zadania) i obejmują cały zakres.
+ */
+void thread_pool_test_nested() {
+    const int concurrency = Parallel::concurrency();
+    Parallel::set_executor(std::make_shared<ThreadPool>(2, true));
+    Parallel::set_concurrency(4);
+
+    vector<int> hits(64 * 64);
+    Parallel::for_each(64, 4, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            Parallel::for_each(64, 4, [&, i](int first, int last) {
+                for (int j = first; j < last; j++) {
+                    hits[i * 64 + j]++;
+                }
+            });
+        }
+    });
+    assert(std::all_of(hits.begin(), hits.end(), [](int n) { return n == 1; }));
+
+    Parallel::set_executor(nullptr);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "thread_pool_test_nested: OK" << endl;
+}
+
+/**
+ * @brief thread_pool_test_executor
+ * Praca równoległa trafia do wykonawcy aplikacji, a wynik
+ * jest identyczny z jednowątkowym.
+ */
+void thread_pool_test_executor() {
+    struct Inline : Executor {
+        int tasks = 0;
+        void execute(Task&& task) noexcept override {
+            tasks++;
+            task();
+        }
+    };
+
+    u8 key[16], iv[8];
+    Crypto::random_bytes(key, sizeof(key));
+    Crypto::random_bytes(iv, sizeof(iv));
+    const Blowfish bf(key, 16);
+    vector<u8> plain(100000);
+    Crypto::random_bytes(plain.data(), int(plain.size()));
+
+    const int concurrency = Parallel::concurrency();
+    const int threshold = Parallel::threshold();
+
+    Parallel::set_concurrency(1);
+    vector<u8> serial(plain.size());
+    bf.crypt_ctr(iv, 0, plain.data(), serial.data(), int(plain.size()));
+
+    const auto executor = std::make_shared<Inline>();
+    Parallel::set_executor(executor);
+    Parallel::set_concurrency(4);
+    Parallel::set_threshold(1024);
+    vector<u8> parallel(plain.size());
+    bf.crypt_ctr(iv, 0, plain.data(), parallel.data(), int(plain.size()));
+    assert(serial == parallel);
+    assert(executor->tasks == 3);
+
+    Parallel::set_executor(nullptr);
+    Parallel::set_threshold(threshold);
+    Parallel::set_concurrency(concurrency);
+
+    cout << "thread_pool_test_executor: OK" << endl;
+}
+
+/**
+ * @brief thread_pool_test_scratch
+ * Każdy wątek puli ma własny bufor roboczy.
+ */
+void thread_pool_test_scratch() {
+    ThreadPool pool(3);
+    std::mutex mutex;
+    vector<u8*> buffers;
+    std::atomic<int> remaining{pool.size()};
+
+    // każde zadanie czeka na pozostałe, więc wykonuje je inny wątek
+    for (int i = 0; i < pool.size(); i++) {
+        pool.execute([&] {
+            u8* const buffer = ThreadPool::scratch(4096);
+            std::memset(buffer, 0xa5, 4096);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffers.push_back(buffer);
+            }
+            remaining--;
+            while (remaining.load() > 0) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    // bez pool.wait - zadania mają wykonać wyłącznie wątki puli
+    while (remaining.load() > 0) {
+        std::this_thread::yield();
+    }
+
+    std::sort(buffers.begin(), buffers.end());
+    assert(buffers.size() == 3);
+    assert(std::unique(buffers.begin(), buffers.end()) == buffers.end());
+    assert(ThreadPool::scratch(16) != buffers[0]);
+
+    cout << "thread_pool_test_scratch: OK" << endl;
+}
+
+/**
+ * @brief thread_pool_test_queue
+ * Kolejka MPMC: kolejność FIFO, ograniczona pojemność i każdy element
+ * odebrany dokładnie raz przy wielu producentach i konsumentach.
+ */
+void thread_pool_test_queue() {
+    MpmcQueue<int> queue(5);
+    assert(queue.capacity() == 8);
+    for (int i = 0; i < 8; i++) {
+        int v = i;
+        assert(queue.push(std::move(v)));
+    }
+    int v = 8;
+    assert(!queue.push(std::move(v)));
+    int values[8];
+    assert(queue.pop_bulk(values, 3) == 3);
+    assert(values[0] == 0 && values[1] == 1 && values[2] == 2);
+    assert(queue.pop_bulk(values, 8) == 5);
+    assert(values[0] == 3 && values[4] == 7);
+    assert(queue.empty() && !queue.pop(v));
+
+    constexpr int Producers = 3, Consumers = 3, Items = 20000;
+    MpmcQueue<int> shared(64);
+    vector<std::atomic<int>> seen(Producers * Items);
+    std::atomic<int> received{0};
+    vector<std::thread> threads;
+    for (int p = 0; p < Producers; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < Items; i++) {
+                int item = p * Items + i;
+                while (!shared.push(std::move(item))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < Consumers; c++) {
+        threads.emplace_back([&] {
+            int batch[16];
+            while (received.load() < Producers * Items) {
+                const int n = shared.pop_bulk(batch, 16);
+                for (int i = 0; i < n; i++) {
+                    seen[batch[i]]++;
+                }
+                received += n;
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(std::all_of(seen.begin(), seen.end(), [](const auto& n) { return n.load() == 1; }));
+
+    cout << "thread_pool_test_queue: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                          A S Y N C                               *
+ *                                                                  *
+ ********************************************************************/
+
+void test_async() {
+    async_test_roundtrip();
+    async_test_cancel();
+}
+
+/**
+ * @brief async_test_roundtrip
+ * Wyniki zadań asynchronicznych są identyczne z encrypt_cbc/decrypt_cbc,
+ * a funkcja zwrotna otrzymuje ten sam wynik co future (jej wyjątek
+ * zastępuje wynik w future).
+ */
+void async_test_roundtrip() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        constexpr int bs = std::decay_t<decltype(cipher)>::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+
+        for (const int nbytes : {0, 1, bs, 1000, 300001}) {
+            vector<u8> plain(nbytes + 1);
+            Crypto::random_bytes(plain.data(), nbytes);
+            for (const auto padding : {Padding::Pkcs7, Padding::Cts}) {
+                if (padding == Padding::Cts && nbytes <= bs) {
+                    continue;
+                }
+                const auto [expected, expected_size] = cipher.encrypt_cbc(plain.data(), nbytes, iv, padding);
+
+                std::atomic<int> calls{0};
+                auto future = cipher.encrypt_cbc_async(plain.data(), nbytes, iv, padding,
+                                                       [&](const AsyncResult& r) { calls += (std::get<1>(r) == expected_size); });
+                const auto [cipher_data, cipher_size] = future.get();
+                assert(calls == 1);
+                assert(cipher_size == expected_size);
+                assert(Crypto::compare_bytes(cipher_data.get(), expected.get(), cipher_size));
+
+                const auto [plain_data, plain_size] = cipher.decrypt_cbc_async(cipher_data.get(), cipher_size, padding).get();
+                assert(plain_size == nbytes);
+                assert(Crypto::compare_bytes(plain_data.get(), plain.data(), nbytes));
+            }
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    // wyjątek funkcji zwrotnej trafia do future, nie kończy procesu
+    u8 plain[100] = {0};
+    auto future = bf.encrypt_cbc_async(plain, sizeof(plain), nullptr, Padding::Pkcs7,
+                                       [](const AsyncResult&) { throw std::runtime_error("callback"); });
+    bool thrown = false;
+    try {
+        future.get();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    cout << "async_test_roundtrip: OK" << endl;
+}
+
+/**
+ * @brief async_test_cancel
+ * Zadanie anulowane przed wykonaniem kończy się wynikiem (nullptr, -1),
+ * przekazywanym także funkcji zwrotnej; pozostałe zadania nie są dotknięte.
+ */
+void async_test_cancel() {
+    // wykonawca wstrzymujący zadania do jawnego uruchomienia
+    struct Deferred : Executor {
+        vector<Task> tasks;
+        void execute(Task&& task) noexcept override {
+            tasks.push_back(std::move(task));
+        }
+        void run() {
+            for (auto& task : tasks) {
+                task();
+            }
+            tasks.clear();
+        }
+    };
+
+    u8 key[16];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    vector<u8> plain(100000);
+    Crypto::random_bytes(plain.data(), int(plain.size()));
+    const auto [cipher, size] = bf.encrypt_cbc(plain.data(), int(plain.size()), nullptr, Padding::Pkcs7);
+
+    const auto executor = std::make_shared<Deferred>();
+    Parallel::set_executor(executor);
+
+    Cancellation cancellation;
+    int failures = 0;
+    auto count = [&](const AsyncResult& r) { failures += (std::get<1>(r) == -1); };
+    auto cancelled_encrypt = bf.encrypt_cbc_async(plain.data(), int(plain.size()), nullptr, Padding::Pkcs7, count, cancellation);
+    auto cancelled_decrypt = bf.decrypt_cbc_async(cipher.get(), size, Padding::Pkcs7, count, cancellation);
+    auto kept = bf.decrypt_cbc_async(cipher.get(), size, Padding::Pkcs7, count);
+    cancellation.cancel();
+    assert(executor->tasks.size() == 3);
+    executor->run();
+    Parallel::set_executor(nullptr);
+
+    assert(failures == 2);
+    const auto [encrypted, encrypted_size] = cancelled_encrypt.get();
+    assert(encrypted == nullptr && encrypted_size == -1);
+    const auto [decrypted, decrypted_size] = cancelled_decrypt.get();
+    assert(decrypted == nullptr && decrypted_size == -1);
+    const auto [data, data_size] = kept.get();
+    assert(data_size == int(plain.size()));
+    assert(Crypto::compare_bytes(data.get(), plain.data(), data_size));
+
+    cout << "async_test_cancel: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                      C O A L E S C E R                           *
+ *                                                                  *
+ ********************************************************************/
+
+void test_coalescer() {
+    coalescer_test_batches();
+    coalescer_test_deadline();
+}
+
+/**
+ * @brief coalescer_test_batches
+ * Żądania łączone we wsady dają wyniki identyczne z encrypt_cbc,
+ * a histogram rozmiarów wsadów obejmuje wszystkie żądania.
+ */
+void coalescer_test_batches() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        constexpr int count = 100;
+
+        vector<vector<u8>> plain(count);
+        vector<vector<u8>> ivs(count, vector<u8>(bs));
+        for (int i = 0; i < count; i++) {
+            plain[i].resize(i * 7 % 300 + 1);
+            Crypto::random_bytes(plain[i].data(), int(plain[i].size()));
+            Crypto::random_bytes(ivs[i].data(), bs);
+        }
+
+        Coalescer<Cipher> coalescer(cipher, std::chrono::milliseconds(5), 8);
+        std::atomic<int> calls{0};
+        vector<std::future<AsyncResult>> results;
+        for (int i = 0; i < count; i++) {
+            results.push_back(coalescer.submit(plain[i].data(), int(plain[i].size()), ivs[i].data(),
+                                               [&](const AsyncResult&) { calls++; }));
+        }
+        for (int i = 0; i < count; i++) {
+            const auto [data, size] = results[i].get();
+            const auto [expected, expected_size] = cipher.encrypt_cbc(plain[i].data(), int(plain[i].size()), ivs[i].data(), Padding::Pkcs7);
+            assert(size == expected_size);
+            assert(Crypto::compare_bytes(data.get(), expected.get(), size));
+        }
+        assert(calls == count);
+
+        const auto stats = coalescer.statistics();
+        assert(stats.requests == count);
+        u64 requests = 0, batches = 0;
+        for (int n = 0; n < int(stats.sizes.size()); n++) {
+            requests += n * stats.sizes[n];
+            batches += stats.sizes[n];
+        }
+        assert(requests == count && batches == stats.batches);
+        assert(stats.full + stats.expired == stats.batches);
+        assert(stats.batches < count);
+        u64 latencies = 0;
+        for (const u64 n : stats.latency) {
+            latencies += n;
+        }
+        assert(latencies == count);
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "coalescer_test_batches: OK" << endl;
+}
+
+/**
+ * @brief coalescer_test_deadline
+ * Pojedyncze żądanie jest wysyłane po upływie terminu (wsad z jednym
+ * żądaniem), a puste żądanie daje wynik (nullptr, 0). Wyjątek funkcji
+ * zwrotnej nie zatrzymuje wątku wsadów.
+ */
+void coalescer_test_deadline() {
+    u8 key[16], plain[20];
+    Crypto::random_bytes(key, sizeof(key));
+    Crypto::random_bytes(plain, sizeof(plain));
+    const Blowfish bf(key, 16);
+
+    Coalescer<Blowfish> coalescer(bf, std::chrono::microseconds(200), 64);
+    const auto [data, size] = coalescer.submit(plain, sizeof(plain)).get();
+    assert(size == 32);
+    const auto [decrypted, decrypted_size] = bf.decrypt_cbc(data.get(), size, Padding::Pkcs7);
+    assert(decrypted_size == int(sizeof(plain)));
+    assert(Crypto::compare_bytes(decrypted.get(), plain, sizeof(plain)));
+
+    const auto [empty, empty_size] = coalescer.submit(nullptr, 0).get();
+    assert(empty == nullptr && empty_size == 0);
+
+    const auto stats = coalescer.statistics();
+    assert(stats.batches == 2 && stats.expired == 2 && stats.sizes[1] == 2);
+
+    // wyjątek funkcji zwrotnej trafia do future, a wątek wsadów działa dalej
+    auto failed = coalescer.submit(plain, sizeof(plain), nullptr, [](const AsyncResult&) { throw std::runtime_error("callback"); });
+    bool thrown = false;
+    try {
+        failed.get();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(std::get<1>(coalescer.submit(plain, sizeof(plain)).get()) == 32);
+
+    cout << "coalescer_test_deadline: OK" << endl;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                         S T R E A M                              *
+ *                                                                  *
+ ********************************************************************/
+
+void test_stream() {
+    stream_test_cbc();
+    stream_test_modes();
+    stream_test_errors();
+}
+
+/**
+ * @brief stream_run
+ * Przepuszczenie danych przez szyfrator/deszyfrator strumieniowy
+ * w porcjach losowej wielkości (-1 gdy finalize zgłosi błąd).
+ */
+template<typename Stream>
+static int stream_run(Stream& stream, const u8* const data, const int nbytes, vector<u8>& out) {
+    out.assign(nbytes + 2 * Stream::Overhead, 0);
+    int written = 0;
+    for (int pos = 0; pos < nbytes; ) {
+        u8 n;
+        Crypto::random_bytes(&n, 1);
+        const int chunk = std::min(nbytes - pos, int(n % 40));
+        const int w = stream.update(data + pos, chunk, out.data() + written);
+        assert(w >= 0 && w <= chunk + Stream::Overhead);
+        written += w;
+        pos += chunk;
+    }
+    const int w = stream.finalize(out.data() + written);
+    if (w < 0) {
+        return -1;
+    }
+    assert(w <= Stream::Overhead);
+    return written + w;
+}
+
+/**
+ * @brief stream_test_cbc
+ * Szyfrowanie i deszyfrowanie CBC w porcjach daje wyniki identyczne
+ * z encrypt_cbc/decrypt_cbc dla wszystkich rodzajów paddingu. Ostatni bajt
+ * danych jest nieparzysty, bo losowe dane wyrównane do bloku mogłyby
+ * przypadkiem kończyć się wzorcem paddingu ISO 7816.
+ */
+void stream_test_cbc() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+
+        for (const int nbytes : {0, 1, bs - 1, bs, bs + 1, 2 * bs, 3 * bs + 5, 1000, 4096}) {
+            vector<u8> plain(nbytes + 1);
+            Crypto::random_bytes(plain.data(), nbytes);
+            if (nbytes > 0) {
+                plain[nbytes - 1] |= 0x01;
+            }
+            for (const auto padding : {Padding::None, Padding::Pkcs7, Padding::Iso7816, Padding::Cts}) {
+                const auto [expected, expected_size] = cipher.encrypt_cbc(plain.data(), nbytes, iv, padding);
+
+                vector<u8> cipher_data, plain_data;
+                Encryptor<Cipher> encryptor(cipher, StreamMode::Cbc, iv, padding);
+                const int cipher_size = stream_run(encryptor, plain.data(), nbytes, cipher_data);
+                if (expected_size < 0) {
+                    assert(cipher_size == -1);
+                    continue;
+                }
+                assert(cipher_size == expected_size);
+                assert(Crypto::compare_bytes(cipher_data.data(), expected.get(), cipher_size));
+
+                Decryptor<Cipher> decryptor(cipher, StreamMode::Cbc, padding);
+                const int plain_size = stream_run(decryptor, cipher_data.data(), cipher_size, plain_data);
+                assert(plain_size == nbytes);
+                assert(Crypto::compare_bytes(plain_data.data(), plain.data(), nbytes));
+            }
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "stream_test_cbc: OK" << endl;
+}
+
+/**
+ * @brief stream_test_modes
+ * Tryby strumieniowe (CTR, CFB, CFB8, OFB) przetwarzane w porcjach
+ * dają wyniki identyczne z jednorazowym szyfrowaniem.
+ */
+void stream_test_modes() {
+    u8 key[32];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    const Gost gt(key, 32);
+    const Way3 w3(key, 12);
+
+    auto check = [](const auto& cipher) {
+        using Cipher = std::decay_t<decltype(cipher)>;
+        constexpr int bs = Cipher::BlockSize;
+        u8 iv[bs];
+        Crypto::random_bytes(iv, bs);
+
+        for (const int nbytes : {1, bs - 1, bs + 3, 1000}) {
+            vector<u8> plain(nbytes);
+            Crypto::random_bytes(plain.data(), nbytes);
+            const std::tuple<std::shared_ptr<void>, int> expected[] = {
+                cipher.encrypt_ctr(plain.data(), nbytes, iv),
+                cipher.encrypt_cfb(plain.data(), nbytes, iv),
+                cipher.encrypt_cfb8(plain.data(), nbytes, iv),
+                cipher.encrypt_ofb(plain.data(), nbytes, iv)
+            };
+            const StreamMode modes[] = {StreamMode::Ctr, StreamMode::Cfb, StreamMode::Cfb8, StreamMode::Ofb};
+            for (int i = 0; i < 4; i++) {
+                const auto& [expected_data, expected_size] = expected[i];
+                vector<u8> cipher_data, plain_data;
+                Encryptor<Cipher> encryptor(cipher, modes[i], iv);
+                const int cipher_size = stream_run(encryptor, plain.data(), nbytes, cipher_data);
+                assert(cipher_size == expected_size);
+                assert(Crypto::compare_bytes(cipher_data.data(), expected_data.get(), cipher_size));
+
+                Decryptor<Cipher> decryptor(cipher, modes[i]);
+                const int plain_size = stream_run(decryptor, cipher_data.data(), cipher_size, plain_data);
+                assert(plain_size == nbytes);
+                assert(Crypto::compare_bytes(plain_data.data(), plain.data(), nbytes));
+            }
+        }
+    };
+    check(bf);
+    check(gt);
+    check(w3);
+
+    cout << "stream_test_modes: OK" << endl;
+}
+
+/**
+ * @brief stream_test_errors
+ * Uszkodzony padding, niepełny blok lub samo IV kończą finalize błędem;
+ * po finalize obiekt nie przyjmuje danych.
+ */
+void stream_test_errors() {
+    u8 key[16];
+    Crypto::random_bytes(key, sizeof(key));
+    const Blowfish bf(key, 16);
+    constexpr int bs = Blowfish::BlockSize;
+
+    u8 plain[100];
+    Crypto::random_bytes(plain, sizeof(plain));
+    const auto [data, size] = bf.encrypt_cbc(plain, sizeof(plain), nullptr, Padding::Pkcs7);
+    const u8* const in = static_cast<const u8*>(data.get());
+    u8 out[200];
+
+    {   // niepełny ostatni blok
+        Decryptor<Blowfish> decryptor(bf, StreamMode::Cbc, Padding::Pkcs7);
+        const int n = decryptor.update(in, size - 1, out);
+        assert(n >= 0 && decryptor.finalize(out + n) == -1);
+        assert(decryptor.update(in, 1, out) == -1);
+    }
+    {   // uszkodzony padding (ostatni bajt odszyfrowanego bloku)
+        vector<u8> bad(in, in + size);
+        bad[size - bs - 1] ^= 0x5a;
+        Decryptor<Blowfish> decryptor(bf, StreamMode::Cbc, Padding::Pkcs7);
+        const int n = decryptor.update(bad.data(), size, out);
+        assert(n >= 0 && decryptor.finalize(out + n) == -1);
+    }
+    {   // niepełne IV
+        Decryptor<Blowfish> decryptor(bf, StreamMode::Ctr);
+        assert(decryptor.update(in, bs - 1, out) == 0);
+        assert(decryptor.finalize(out) == -1);
+    }
+    {   // dane niewyrównane bez paddingu
+        Encryptor<Blowfish> encryptor(bf, StreamMode::Cbc, nullptr, Padding::None);
+        const int n = encryptor.update(plain, 10, out);
+        assert(n == 2 * bs && encryptor.finalize(out + n) == -1);  // IV + pełny blok
+        assert(encryptor.update(plain, 1, out) == -1);
+    }
+
+    cout << "stream_test_errors: OK" << endl;
+}
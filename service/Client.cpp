@@ -0,0 +1,208 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "Client.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+namespace service {
+using namespace std;
+
+Client::~Client() {
+    if (region) {
+        munmap(region, region_size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * @brief connect
+ * Połączenie z usługą.
+ *
+ * @param path - ścieżka gniazda.
+ * @return true jeśli połączenie zostało nawiązane.
+ */
+bool Client::connect(const string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    return fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+/**
+ * @brief attach
+ * Utworzenie regionu pamięci współdzielonej (memfd zabezpieczony przed
+ * zmianą rozmiaru) i przekazanie go usłudze. Wywołanie jest synchroniczne,
+ * więc nie może być wtedy żadnych żądań w toku.
+ *
+ * @param nbytes - rozmiar regionu w bajtach.
+ * @return adres regionu lub nullptr.
+ */
+u8* Client::attach(const size_t nbytes) {
+    const int memfd = memfd_create("cryptod", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        return nullptr;
+    }
+    void* const p = (ftruncate(memfd, off_t(nbytes)) == 0 && fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0)
+            ? mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0)
+            : MAP_FAILED;
+    if (p == MAP_FAILED) {
+        close(memfd);
+        return nullptr;
+    }
+
+    const Header header{0, 0, u8(Op::Attach), 0, 0};
+    iovec iov{const_cast<Header*>(&header), sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* const cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cm), &memfd, sizeof(int));
+
+    const bool sent = sendmsg(fd, &msg, MSG_NOSIGNAL) == ssize_t(sizeof(header));
+    close(memfd);
+    Header response;
+    vector<u8> data;
+    if (!sent || !receive(response, data) || Status(response.op) != Status::Ok) {
+        munmap(p, nbytes);
+        return nullptr;
+    }
+    if (region) {
+        munmap(region, region_size);
+    }
+    region = static_cast<u8*>(p);
+    region_size = nbytes;
+    return region;
+}
+
+/**
+ * @brief send
+ * Wysłanie ramki (nagłówek + header.length bajtów danych).
+ */
+bool Client::send(const Header& header, const void* const data) noexcept {
+    iovec iov[2] = {{const_cast<Header*>(&header), sizeof(header)}, {const_cast<void*>(data), header.length}};
+    size_t left = sizeof(header) + header.length;
+    int first = 0;
+    while (left > 0) {
+        const ssize_t n = writev(fd, iov + first, 2 - first);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        left -= size_t(n);
+        size_t done = size_t(n);
+        while (first < 2 && done >= iov[first].iov_len) {
+            done -= iov[first].iov_len;
+            first++;
+        }
+        if (first < 2) {
+            iov[first].iov_base = static_cast<u8*>(iov[first].iov_base) + done;
+            iov[first].iov_len -= done;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief finish
+ * Zamknięcie strony zapisu (koniec żądań); odpowiedzi
+ * na wysłane żądania można nadal odbierać.
+ */
+void Client::finish() noexcept {
+    ::shutdown(fd, SHUT_WR);
+}
+
+/**
+ * @brief receive
+ * Odebranie ramki odpowiedzi.
+ */
+bool Client::receive(Header& header, vector<u8>& data) noexcept {
+    if (!read_all(&header, sizeof(header)) || header.length > u32(MaxLength)) {
+        return false;
+    }
+    data.resize(header.length);
+    return read_all(data.data(), header.length);
+}
+
+/**
+ * @brief call
+ * Synchroniczne żądanie z danymi inline.
+ *
+ * @return status odpowiedzi (BadRequest przy błędzie połączenia).
+ */
+Status Client::call(const Op op, const u16 key, const void* const data, const u32 nbytes, vector<u8>& result) noexcept {
+    Header header{nbytes, 0, u8(op), 0, key};
+    if (!send(header, data) || !receive(header, result)) {
+        return Status::BadRequest;
+    }
+    return Status(header.op);
+}
+
+bool Client::read_all(void* const buffer, size_t nbytes) noexcept {
+    u8* p = static_cast<u8*>(buffer);
+    while (nbytes > 0) {
+        const ssize_t n = read(fd, p, nbytes);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        nbytes -= size_t(n);
+    }
+    return true;
+}
+
+}}} // namespaces
@@ -0,0 +1,80 @@
+#ifndef BEESOFT_CRYPTO_SERVICE_CLIENT_H
+#define BEESOFT_CRYPTO_SERVICE_CLIENT_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <string>
+#include <vector>
+#include "Protocol.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+namespace service {
+
+/**
+ * @brief Client
+ * Klient usługi cryptod: połączenie z gniazdem, wysyłanie ramek
+ * (także potokowo - wiele żądań przed odebraniem odpowiedzi)
+ * i opcjonalny region pamięci współdzielonej dla dużych danych.
+ */
+class Client {
+    int fd = -1;
+    u8* region = nullptr;
+    size_t region_size = 0;
+
+public:
+    Client() = default;
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    bool connect(const std::string&);
+    u8* attach(const size_t);
+    bool send(const Header&, const void* const) noexcept;
+    bool receive(Header&, std::vector<u8>&) noexcept;
+    void finish() noexcept;
+    Status call(const Op, const u16, const void* const, const u32, std::vector<u8>&) noexcept;
+
+    u8* shared() const noexcept {
+        return region;
+    }
+    size_t shared_size() const noexcept {
+        return region_size;
+    }
+
+private:
+    bool read_all(void* const, size_t) noexcept;
+};
+
+}}} // namespaces
+#endif // BEESOFT_CRYPTO_SERVICE_CLIENT_H
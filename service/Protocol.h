@@ -0,0 +1,103 @@
+#ifndef BEESOFT_CRYPTO_SERVICE_PROTOCOL_H
+#define BEESOFT_CRYPTO_SERVICE_PROTOCOL_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <cstdint>
+#include "Crypto/Crypto.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+namespace service {
+
+using u16 = uint16_t;
+
+/**
+ * Protokół usługi cryptod (gniazdo domeny Unix, strumień ramek).
+ * Każda ramka to nagłówek Header i length bajtów danych. Klient i serwer
+ * pracują na tej samej maszynie, więc pola mają natywną kolejność bajtów.
+ *
+ * Encrypt: dane to tekst jawny, odpowiedź: IV + szyfrogram (CBC, PKCS#7).
+ * Decrypt: dane to IV + szyfrogram, odpowiedź: tekst jawny.
+ * Attach:  brak danych, ramce towarzyszy deskryptor memfd (SCM_RIGHTS);
+ *          region jest mapowany przez serwer na czas połączenia.
+ * Z flagą Shared dane ramki to SharedRef: wejście i wyjście leżą w regionie
+ * przekazanym przez Attach, a odpowiedź zawiera tylko SharedResult.
+ *
+ * Odpowiedź ma ten sam identyfikator co żądanie, a w polu op - Status.
+ * Odpowiedzi na żądania z jednej porcji mogą przyjść w innej kolejności.
+ */
+
+static constexpr int MaxFrame = 16 * 1024 * 1024;   // maksymalny rozmiar danych do zaszyfrowania (inline)
+static constexpr int MaxLength = MaxFrame + 64;     // maksymalna długość ramki (szyfrogram: + IV i padding)
+
+enum class Op : u8 {
+    Encrypt = 1,
+    Decrypt = 2,
+    Attach  = 3
+};
+
+enum class Status : u8 {
+    Ok = 0,
+    BadRequest,     // nieznana operacja lub błędna ramka
+    UnknownKey,     // brak klucza o podanym identyfikatorze
+    BadData,        // niepoprawny rozmiar danych lub padding
+    BadRegion       // brak regionu lub odwołanie poza region
+};
+
+enum Flags : u8 {
+    Shared = 0x01   // dane w regionie pamięci współdzielonej
+};
+
+struct Header {
+    u32 length;     // liczba bajtów danych za nagłówkiem
+    u32 id;         // identyfikator żądania (kopiowany do odpowiedzi)
+    u8  op;         // żądanie: Op, odpowiedź: Status
+    u8  flags;      // Flags
+    u16 key;        // identyfikator klucza
+};
+static_assert(sizeof(Header) == 12, "unexpected header layout");
+
+struct SharedRef {
+    u64 input;      // pozycja danych wejściowych w regionie
+    u64 output;     // pozycja bufora wynikowego w regionie
+    u32 nbytes;     // rozmiar danych wejściowych
+    u32 capacity;   // rozmiar bufora wynikowego
+};
+static_assert(sizeof(SharedRef) == 24, "unexpected shared reference layout");
+
+struct SharedResult {
+    u32 nbytes;     // rozmiar wyniku zapisanego w buforze wynikowym
+};
+
+}}} // namespaces
+#endif // BEESOFT_CRYPTO_SERVICE_PROTOCOL_H
@@ -0,0 +1,829 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "Server.h"
+#include "Crypto/Modes/Cbc.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+namespace service {
+using namespace std;
+
+/*------- local constants:
+-------------------------------------------------------------------*/
+static constexpr int ReadBudget = 1024 * 1024;     // bajty odczytywane z połączenia w jednym obrocie pętli
+static const char* const CipherNames[] = {"blowfish", "gost", "way3"};
+
+/**
+ * @brief block_size
+ * @return rozmiar bloku szyfru kontekstu.
+ */
+static int block_size(const Context& context) noexcept {
+    return visit([](const auto& cipher) { return decay_t<decltype(cipher)>::BlockSize; }, context);
+}
+
+/********************************************************************
+ *                                                                  *
+ *                         K E Y R I N G                            *
+ *                                                                  *
+ ********************************************************************/
+
+Keyring::~Keyring() {
+    for (auto& [id, entry] : entries) {
+        Crypto::clear_bytes(entry.key.data(), int(entry.key.size()));
+    }
+}
+
+/**
+ * @brief add
+ * Dodanie klucza (po sprawdzeniu, że szyfr go akceptuje).
+ *
+ * @param id - identyfikator klucza.
+ * @param name - nazwa szyfru (blowfish, gost, way3).
+ * @param key - adres klucza.
+ * @param nbytes - rozmiar klucza w bajtach.
+ * @return true jeśli klucz został dodany.
+ */
+bool Keyring::add(const u16 id, const string& name, const void* const key, const int nbytes) {
+    const auto it = find(begin(CipherNames), end(CipherNames), name);
+    if (it == end(CipherNames) || entries.count(id)) {
+        return false;
+    }
+    Entry entry{int(it - begin(CipherNames)), vector<u8>(static_cast<const u8*>(key), static_cast<const u8*>(key) + nbytes)};
+
+    bool valid = false;
+    switch (entry.kind) {
+    case 0: valid = Blowfish().rekey(key, nbytes); break;
+    case 1: valid = Gost().rekey(key, nbytes); break;
+    case 2: valid = Way3().rekey(key, nbytes); break;
+    }
+    if (!valid) {
+        Crypto::clear_bytes(entry.key.data(), nbytes);
+        return false;
+    }
+    entries.emplace(id, move(entry));
+    return true;
+}
+
+/**
+ * @brief load
+ * Wczytanie kluczy z pliku (wiersze: <id> <szyfr> <klucz hex>).
+ *
+ * @param path - ścieżka pliku.
+ * @return true jeśli wszystkie wiersze są poprawne.
+ */
+bool Keyring::load(const string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        cerr << "Error (cryptod): cannot open " << path << endl;
+        return false;
+    }
+    // cały plik w jednym buforze, czyszczonym po parsowaniu (bez kopii kluczy na stercie)
+    vector<char> text;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok) {
+        text.resize(size_t(st.st_size));
+        size_t done = 0;
+        while (ok && done < text.size()) {
+            const ssize_t n = ::read(fd, text.data() + done, text.size() - done);
+            ok = n > 0 || (n < 0 && errno == EINTR);
+            done += size_t(max<ssize_t>(n, 0));
+        }
+    }
+    ::close(fd);
+    if (!ok) {
+        Crypto::clear_bytes(text.data(), int(text.size()));
+        cerr << "Error (cryptod): cannot read " << path << endl;
+        return false;
+    }
+
+    const auto digit = [](const char c) {
+        return isxdigit(static_cast<unsigned char>(c)) ? (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10)) : -1;
+    };
+    const char* pos = text.data();
+    const char* const last = text.data() + text.size();
+    int number = 0;
+    ok = true;
+    while (ok && pos < last) {
+        number++;
+        const char* eol = static_cast<const char*>(memchr(pos, '\n', size_t(last - pos)));
+        eol = eol ? eol : last;
+        const char* const hash = static_cast<const char*>(memchr(pos, '#', size_t(eol - pos)));
+        const char* const end = hash ? hash : eol;
+
+        // podział wiersza na pola (bez kopiowania)
+        string_view fields[4];
+        int count = 0;
+        for (const char* p = pos; p < end && count < 4; ) {
+            while (p < end && isspace(static_cast<unsigned char>(*p))) {
+                p++;
+            }
+            const char* const begin = p;
+            while (p < end && !isspace(static_cast<unsigned char>(*p))) {
+                p++;
+            }
+            if (p > begin) {
+                fields[count++] = string_view(begin, size_t(p - begin));
+            }
+        }
+        pos = eol + 1;
+        if (count == 0) {
+            continue;   // pusty wiersz lub komentarz
+        }
+
+        unsigned id = 0;
+        bool valid = count == 3 && fields[0].size() <= 5 && fields[2].size() % 2 == 0;
+        for (size_t i = 0; valid && i < fields[0].size(); i++) {
+            valid = isdigit(static_cast<unsigned char>(fields[0][i]));
+            id = id * 10 + unsigned(fields[0][i] - '0');
+        }
+        valid = valid && id <= 0xffff;
+
+        vector<u8> key;
+        key.reserve(fields[2].size() / 2);
+        const string_view hex = fields[2];
+        for (size_t i = 0; valid && i < hex.size(); i += 2) {
+            const int hi = digit(hex[i]), lo = digit(hex[i + 1]);
+            valid = hi >= 0 && lo >= 0;
+            key.push_back(u8(hi << 4 | lo));
+        }
+        valid = valid && add(u16(id), string(fields[1]), key.data(), int(key.size()));
+        Crypto::clear_bytes(key.data(), int(key.size()));
+        if (!valid) {
+            cerr << "Error (cryptod): invalid key in " << path << ":" << number << endl;
+            ok = false;
+        }
+    }
+    Crypto::clear_bytes(text.data(), int(text.size()));
+    return ok;
+}
+
+/**
+ * @brief contexts
+ * @return nowe konteksty szyfrów dla wszystkich kluczy.
+ */
+map<u16, Context> Keyring::contexts() const {
+    map<u16, Context> result;
+    for (const auto& [id, entry] : entries) {
+        auto it = result.end();
+        switch (entry.kind) {
+        case 0: it = result.try_emplace(id, in_place_type<Blowfish>).first; break;
+        case 1: it = result.try_emplace(id, in_place_type<Gost>).first; break;
+        case 2: it = result.try_emplace(id, in_place_type<Way3>).first; break;
+        }
+        visit([&entry = entry](auto& cipher) { cipher.rekey(entry.key.data(), int(entry.key.size())); }, it->second);
+    }
+    return result;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                           S H A R D                              *
+ *                                                                  *
+ ********************************************************************/
+
+Shard::Shard(const int cpu, const Keyring& keyring)
+    : cpu(cpu)
+    , keys(keyring.contexts())
+{}
+
+Shard::~Shard() {
+    shutdown();
+    while (!connections.empty()) {
+        close(*connections.begin()->second);
+    }
+    if (wakefd >= 0) {
+        ::close(wakefd);
+    }
+    if (epfd >= 0) {
+        ::close(epfd);
+    }
+}
+
+/**
+ * @brief start
+ * Utworzenie pętli zdarzeń i uruchomienie wątku shardu
+ * przypiętego do jego procesora.
+ *
+ * @return true jeśli shard działa.
+ */
+bool Shard::start() {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epfd < 0 || wakefd < 0) {
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &event)) {
+        return false;
+    }
+
+    thread = std::thread(&Shard::run, this);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+    return true;
+}
+
+/**
+ * @brief adopt
+ * Przekazanie shardowi przyjętego połączenia (wywoływane z innego wątku).
+ *
+ * @param fd - deskryptor połączenia (nieblokujący).
+ */
+void Shard::adopt(const int fd) {
+    {
+        lock_guard<mutex> lock(inbox_mutex);
+        inbox.push_back(fd);
+    }
+    const u64 one = 1;
+    [[maybe_unused]] const auto n = write(wakefd, &one, sizeof(one));
+}
+
+/**
+ * @brief shutdown
+ * Zatrzymanie wątku shardu.
+ */
+void Shard::shutdown() noexcept {
+    stop.store(true);
+    if (wakefd >= 0) {
+        const u64 one = 1;
+        [[maybe_unused]] const auto n = write(wakefd, &one, sizeof(one));
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief run
+ * Pętla zdarzeń: odczyt wszystkich gotowych połączeń, wspólne
+ * przetworzenie odebranych żądań, wysłanie odpowiedzi.
+ */
+void Shard::run() noexcept {
+    epoll_event events[MaxEvents];
+    vector<Request> requests;
+    vector<Connection*> active;
+
+    while (!stop.load(memory_order_relaxed)) {
+        const int n = epoll_wait(epfd, events, MaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            auto* const c = static_cast<Connection*>(events[i].data.ptr);
+            if (c == nullptr) {
+                u64 value;
+                [[maybe_unused]] const auto r = read(wakefd, &value, sizeof(value));
+                accept_inbox();
+                continue;
+            }
+            if (!c->eof && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                if (!receive(*c)) {
+                    c->closing = true;
+                }
+                parse(*c, requests);
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                c->closing = true;  // odpowiedzi nie mogą już zostać dostarczone
+            }
+            active.push_back(c);
+        }
+
+        process(requests);
+        requests.clear();
+
+        for (Connection* const c : active) {
+            c->in.erase(c->in.begin(), c->in.begin() + c->parsed);
+            c->parsed = 0;
+            flush(*c);
+            // po końcu żądań (half-close) połączenie żyje do wysłania wszystkich odpowiedzi
+            if (c->closing || (c->eof && c->out.empty())) {
+                close(*c);
+            } else {
+                watch(*c);
+            }
+        }
+        active.clear();
+    }
+}
+
+/**
+ * @brief accept_inbox
+ * Rejestracja połączeń przekazanych przez adopt.
+ */
+void Shard::accept_inbox() noexcept {
+    vector<int> fds;
+    {
+        lock_guard<mutex> lock(inbox_mutex);
+        fds.swap(inbox);
+    }
+    for (const int fd : fds) {
+        auto connection = make_unique<Connection>();
+        connection->fd = fd;
+        connection->events = EPOLLIN | EPOLLRDHUP;
+        epoll_event event{};
+        event.events = connection->events;
+        event.data.ptr = connection.get();
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event)) {
+            ::close(fd);
+            continue;
+        }
+        connections.emplace(connection.get(), move(connection));
+    }
+}
+
+/**
+ * @brief receive
+ * Odczyt dostępnych danych (i deskryptorów SCM_RIGHTS) z połączenia.
+ * Koniec strumienia (klient zamknął stronę zapisu) ustawia eof.
+ *
+ * @return false gdy wystąpił błąd.
+ */
+bool Shard::receive(Connection& c) noexcept {
+    // budżet dotyczy bajtów odczytanych w tym obrocie, nie zawartości bufora
+    // (inaczej ramka większa od budżetu nigdy nie zostałaby odebrana)
+    for (const size_t limit = c.in.size() + size_t(ReadBudget); c.in.size() < limit; ) {
+        const size_t old = c.in.size();
+        c.in.resize(old + ReadChunk);
+
+        iovec iov{c.in.data() + old, size_t(ReadChunk)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        const ssize_t n = recvmsg(c.fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        c.in.resize(old + max<ssize_t>(n, 0));
+        if (n > 0) {
+            for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+                if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS) {
+                    int fd;
+                    memcpy(&fd, CMSG_DATA(cm), sizeof(fd));
+                    if (c.descriptor >= 0) {
+                        ::close(c.descriptor);
+                    }
+                    c.descriptor = fd;
+                }
+            }
+            continue;
+        }
+        if (n == 0) {
+            c.eof = true;
+            return true;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+/**
+ * @brief parse
+ * Wydzielenie kompletnych ramek z odebranych danych.
+ * Dane żądań wskazują na bufor połączenia (ważne do końca obrotu pętli).
+ */
+void Shard::parse(Connection& c, vector<Request>& requests) noexcept {
+    size_t pos = 0;
+    while (c.in.size() - pos >= sizeof(Header)) {
+        Header header;
+        memcpy(&header, c.in.data() + pos, sizeof(header));
+        if (header.length > u32(MaxLength)) {
+            c.closing = true;
+            break;
+        }
+        if (c.in.size() - pos - sizeof(header) < header.length) {
+            break;
+        }
+        requests.push_back({&c, header, c.in.data() + pos + sizeof(header)});
+        pos += sizeof(header) + header.length;
+    }
+    c.parsed = pos;
+}
+
+/**
+ * @brief process
+ * Obsługa żądań z jednego obrotu pętli. Żądania szyfrowania
+ * są zbierane i szyfrowane wsadami (@see encrypt).
+ */
+void Shard::process(vector<Request>& requests) noexcept {
+    vector<Request> encrypts;
+    for (const Request& r : requests) {
+        switch (Op(r.header.op)) {
+        case Op::Encrypt:
+            encrypts.push_back(r);
+            break;
+        case Op::Decrypt:
+            decrypt(r);
+            break;
+        case Op::Attach:
+            attach(r);
+            break;
+        default:
+            reply(*r.connection, r, Status::BadRequest, 0);
+        }
+    }
+    encrypt(encrypts);
+}
+
+/**
+ * @brief attach
+ * Zmapowanie regionu pamięci współdzielonej przekazanego przez klienta.
+ * Region musi być zabezpieczony przed zmniejszeniem (F_SEAL_SHRINK).
+ */
+void Shard::attach(const Request& r) noexcept {
+    Connection& c = *r.connection;
+    const int fd = c.descriptor;
+    c.descriptor = -1;
+
+    struct stat st;
+    const int seals = (fd >= 0) ? fcntl(fd, F_GET_SEALS) : -1;
+    const bool valid = fd >= 0 && r.header.length == 0
+            && seals >= 0 && (seals & F_SEAL_SHRINK)
+            && fstat(fd, &st) == 0 && st.st_size > 0;
+    void* const region = valid ? mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (region == MAP_FAILED) {
+        reply(c, r, Status::BadRegion, 0);
+        return;
+    }
+    if (c.region) {
+        munmap(c.region, c.region_size);
+    }
+    c.region = static_cast<u8*>(region);
+    c.region_size = size_t(st.st_size);
+    reply(c, r, Status::Ok, 0);
+}
+
+/**
+ * @brief encrypt
+ * Szyfrowanie żądań: najpierw rezerwacja miejsca na wszystkie odpowiedzi,
+ * potem jedno wywołanie Cbc::encrypt_batch na każdy klucz, zapisujące
+ * szyfrogramy wprost do buforów odpowiedzi (lub regionów współdzielonych).
+ */
+void Shard::encrypt(vector<Request>& requests) noexcept {
+    struct Pending {
+        u16 key;
+        Connection* connection;
+        const u8* data;
+        u32 nbytes;
+        size_t offset;      // pozycja szyfrogramu w out (gdy output == nullptr)
+        u8* output;         // szyfrogram w regionie współdzielonym
+    };
+    vector<Pending> pending;
+    pending.reserve(requests.size());
+
+    for (const Request& r : requests) {
+        Connection& c = *r.connection;
+        const auto key = keys.find(r.header.key);
+        if (key == keys.end()) {
+            reply(c, r, Status::UnknownKey, 0);
+            continue;
+        }
+        const int bs = block_size(key->second);
+        Pending p{r.header.key, &c, r.data, r.header.length, 0, nullptr};
+        if (r.header.flags & Shared) {
+            SharedRef ref;
+            if (r.header.length != sizeof(ref)) {
+                reply(c, r, Status::BadRequest, 0);
+                continue;
+            }
+            memcpy(&ref, r.data, sizeof(ref));
+            const u64 size = u64(Crypto::padded_size(int(ref.nbytes), bs, Padding::Pkcs7)) + bs;
+            if (ref.nbytes > u32(MaxFrame) * 64 || !locate(c, ref.input, ref.nbytes)
+                    || ref.capacity < size || !locate(c, ref.output, ref.capacity)) {
+                reply(c, r, Status::BadRegion, 0);
+                continue;
+            }
+            p.data = c.region + ref.input;
+            p.nbytes = ref.nbytes;
+            p.output = c.region + ref.output;
+            const SharedResult result{u32(ref.nbytes ? size : 0)};
+            const size_t offset = reply(c, r, Status::Ok, sizeof(result));
+            memcpy(c.out.data() + offset, &result, sizeof(result));
+        } else {
+            if (r.header.length > u32(MaxFrame)) {
+                reply(c, r, Status::BadRequest, 0);
+                continue;
+            }
+            const int size = r.header.length ? Crypto::padded_size(int(r.header.length), bs, Padding::Pkcs7) + bs : 0;
+            p.offset = reply(c, r, Status::Ok, u32(size));
+        }
+        if (p.nbytes > 0) {
+            pending.push_back(p);
+        }
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    // wszystkie odpowiedzi zarezerwowane - bufory out już się nie przesuną
+    stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) { return a.key < b.key; });
+    for (size_t first = 0; first < pending.size();) {
+        size_t last = first;
+        while (last < pending.size() && pending[last].key == pending[first].key) {
+            last++;
+        }
+        visit([&](const auto& cipher) {
+            using Cipher = decay_t<decltype(cipher)>;
+            vector<typename Cbc<Cipher>::Job> jobs;
+            jobs.reserve(last - first);
+            for (size_t i = first; i < last; i++) {
+                const Pending& p = pending[i];
+                u8* const out = p.output ? p.output : p.connection->out.data() + p.offset;
+                jobs.push_back({p.data, int(p.nbytes), nullptr, out, 0});
+            }
+            Cbc<Cipher>::encrypt_batch(cipher, jobs.data(), int(jobs.size()), Padding::Pkcs7);
+        }, keys.find(pending[first].key)->second);
+        first = last;
+    }
+}
+
+/**
+ * @brief decrypt
+ * Odszyfrowanie jednego żądania wprost do bufora odpowiedzi
+ * (lub regionu współdzielonego) i usunięcie paddingu.
+ */
+void Shard::decrypt(const Request& r) noexcept {
+    Connection& c = *r.connection;
+    const auto key = keys.find(r.header.key);
+    if (key == keys.end()) {
+        reply(c, r, Status::UnknownKey, 0);
+        return;
+    }
+    const int bs = block_size(key->second);
+
+    const u8* in = r.data;
+    u64 nbytes = r.header.length;
+    SharedRef ref{};
+    const bool shared = r.header.flags & Shared;
+    if (shared) {
+        if (r.header.length != sizeof(ref)) {
+            reply(c, r, Status::BadRequest, 0);
+            return;
+        }
+        memcpy(&ref, r.data, sizeof(ref));
+        if (!locate(c, ref.input, ref.nbytes) || !locate(c, ref.output, ref.capacity)) {
+            reply(c, r, Status::BadRegion, 0);
+            return;
+        }
+        in = c.region + ref.input;
+        nbytes = ref.nbytes;
+    }
+    if (nbytes % bs || nbytes < u64(2 * bs) || nbytes > u64(INT32_MAX)) {
+        reply(c, r, Status::BadData, 0);
+        return;
+    }
+    if (shared && ref.capacity < nbytes - bs) {
+        reply(c, r, Status::BadRegion, 0);
+        return;
+    }
+
+    const size_t offset = reply(c, r, Status::Ok, u32(shared ? sizeof(SharedResult) : nbytes - bs));
+    u8* const out = shared ? c.region + ref.output : c.out.data() + offset;
+    const int size = visit([&](const auto& cipher) {
+        using Cipher = decay_t<decltype(cipher)>;
+        Cbc<Cipher>::decrypt_chain(cipher, in, int(nbytes / bs) - 1, out);
+        return Crypto::unpad(out, int(nbytes) - bs, bs, Padding::Pkcs7);
+    }, key->second);
+
+    // odpowiedź jest ostatnia w out: poprawka nagłówka i przycięcie
+    if (size < 0) {
+        c.out.resize(offset - sizeof(Header));
+        reply(c, r, Status::BadData, 0);
+    } else if (shared) {
+        const SharedResult result{u32(size)};
+        memcpy(c.out.data() + offset, &result, sizeof(result));
+    } else {
+        Header header;
+        memcpy(&header, c.out.data() + offset - sizeof(header), sizeof(header));
+        header.length = u32(size);
+        memcpy(c.out.data() + offset - sizeof(header), &header, sizeof(header));
+        c.out.resize(offset + size);
+    }
+}
+
+/**
+ * @brief flush
+ * Wysłanie oczekujących odpowiedzi (bez blokowania).
+ */
+void Shard::flush(Connection& c) noexcept {
+    while (c.sent < c.out.size()) {
+        const ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            c.sent += size_t(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                c.closing = true;
+            }
+            break;
+        }
+    }
+    if (c.sent == c.out.size()) {
+        c.out.clear();
+        c.sent = 0;
+    }
+}
+
+/**
+ * @brief watch
+ * Dopasowanie obserwowanych zdarzeń: zapis gdy są niewysłane odpowiedzi,
+ * odczyt tylko gdy zaległe odpowiedzi nie przekraczają limitu
+ * i klient nie zamknął strony zapisu.
+ */
+void Shard::watch(Connection& c) noexcept {
+    const size_t backlog = c.out.size() - c.sent;
+    const u32 input = c.eof ? 0 : (EPOLLRDHUP | (backlog < MaxBacklog ? u32(EPOLLIN) : 0));
+    const u32 events = input | (backlog ? u32(EPOLLOUT) : 0);
+    if (events != c.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.ptr = &c;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &event);
+        c.events = events;
+    }
+}
+
+/**
+ * @brief close
+ * Zamknięcie połączenia i zwolnienie jego zasobów.
+ */
+void Shard::close(Connection& c) noexcept {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+    ::close(c.fd);
+    if (c.descriptor >= 0) {
+        ::close(c.descriptor);
+    }
+    if (c.region) {
+        munmap(c.region, c.region_size);
+    }
+    connections.erase(&c);
+}
+
+/**
+ * @brief reply
+ * Dopisanie nagłówka odpowiedzi i miejsca na jej dane.
+ *
+ * @return pozycja danych odpowiedzi w out.
+ */
+size_t Shard::reply(Connection& c, const Request& r, const Status status, const u32 length) noexcept {
+    const Header header{length, r.header.id, u8(status), r.header.flags, r.header.key};
+    const size_t pos = c.out.size();
+    c.out.resize(pos + sizeof(header) + length);
+    memcpy(c.out.data() + pos, &header, sizeof(header));
+    return pos + sizeof(header);
+}
+
+/**
+ * @brief locate
+ * @return true jeśli fragment [offset, offset + nbytes) leży w regionie połączenia.
+ */
+bool Shard::locate(const Connection& c, const u64 offset, const u64 nbytes) noexcept {
+    return c.region && offset <= c.region_size && nbytes <= c.region_size - offset;
+}
+
+/********************************************************************
+ *                                                                  *
+ *                          S E R V E R                             *
+ *                                                                  *
+ ********************************************************************/
+
+/**
+ * @brief Server
+ * @param path - ścieżka gniazda.
+ * @param keyring - klucze usługi.
+ * @param count - liczba shardów (0 - liczba procesorów).
+ */
+Server::Server(const string& path, const Keyring& keyring, const int count)
+    : path(path)
+{
+    const int cpus = max(1, int(std::thread::hardware_concurrency()));
+    const int n = (count > 0) ? count : cpus;
+    for (int i = 0; i < n; i++) {
+        shards.push_back(make_unique<Shard>(i % cpus, keyring));
+    }
+}
+
+Server::~Server() {
+    shards.clear();
+    if (listener >= 0) {
+        ::close(listener);
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * @brief listen
+ * Utworzenie gniazda (dostępnego tylko dla właściciela) i uruchomienie shardów.
+ *
+ * @return true jeśli usługa jest gotowa do przyjmowania połączeń.
+ */
+bool Server::listen() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        cerr << "Error (cryptod): socket path too long" << endl;
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    const mode_t mask = umask(0077);
+    const bool bound = listener >= 0 && bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(mask);
+    if (!bound || ::listen(listener, SOMAXCONN)) {
+        cerr << "Error (cryptod): cannot listen on " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    for (auto& shard : shards) {
+        if (!shard->start()) {
+            cerr << "Error (cryptod): cannot start shard" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief serve
+ * Przyjmowanie połączeń i przydzielanie ich kolejnym shardom
+ * do czasu ustawienia znacznika stop.
+ *
+ * @param stop - znacznik zakończenia pracy.
+ */
+void Server::serve(const atomic<bool>& stop) noexcept {
+    size_t next = 0;
+    while (!stop.load()) {
+        pollfd pfd{listener, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            shards[next++ % shards.size()]->adopt(fd);
+        }
+    }
+}
+
+}}} // namespaces
@@ -0,0 +1,181 @@
+#ifndef BEESOFT_CRYPTO_SERVICE_SERVER_H
+#define BEESOFT_CRYPTO_SERVICE_SERVER_H
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "Crypto/Crypto.h"
+#include "Crypto/Blowfish/Blowfish.h"
+#include "Crypto/Gost/Gost.h"
+#include "Crypto/Way3/Way3.h"
+#include "Protocol.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+namespace beesoft {
+namespace crypto {
+namespace service {
+
+/// Kontekst jednego z obsługiwanych szyfrów.
+using Context = std::variant<Blowfish, Gost, Way3>;
+
+/**
+ * @brief Keyring
+ * Klucze usługi (surowe bajty), z których każdy shard tworzy
+ * własne konteksty szyfrów. Plik kluczy zawiera wiersze:
+ * <id> <blowfish|gost|way3> <klucz hex>; '#' rozpoczyna komentarz.
+ */
+class Keyring {
+public:
+    struct Entry {
+        int kind;               // indeks typu w Context
+        std::vector<u8> key;
+    };
+
+    Keyring() = default;
+    ~Keyring();
+
+    Keyring(const Keyring&) = delete;
+    Keyring& operator=(const Keyring&) = delete;
+
+    bool add(const u16, const std::string&, const void* const, const int);
+    bool load(const std::string&);
+    std::map<u16, Context> contexts() const;
+
+    int size() const noexcept {
+        return int(entries.size());
+    }
+
+private:
+    std::map<u16, Entry> entries;
+};
+
+/**
+ * @brief Shard
+ * Pętla zdarzeń (epoll) obsługująca część połączeń. Każdy shard
+ * działa w osobnym wątku przypiętym do procesora i ma własne konteksty
+ * szyfrów, więc shardy niczego nie współdzielą. Żądania szyfrowania ze
+ * wszystkich połączeń gotowych w jednym obrocie pętli są grupowane według
+ * klucza i szyfrowane jednym wywołaniem Cbc::encrypt_batch.
+ */
+class Shard {
+    static constexpr int MaxEvents = 64;
+    static constexpr int ReadChunk = 64 * 1024;             // porcja odczytu w bajtach
+    static constexpr size_t MaxBacklog = 8 * 1024 * 1024;   // niewysłane odpowiedzi wstrzymujące odczyt
+
+    struct Connection {
+        int fd = -1;
+        std::vector<u8> in;         // odebrane, nieprzetworzone bajty
+        std::vector<u8> out;        // odpowiedzi do wysłania
+        size_t sent = 0;            // wysłana część out
+        size_t parsed = 0;          // przetworzona część in
+        int descriptor = -1;        // deskryptor odebrany przez SCM_RIGHTS
+        u8* region = nullptr;       // region pamięci współdzielonej
+        size_t region_size = 0;
+        u32 events = 0;             // obserwowane zdarzenia epoll
+        bool eof = false;           // klient zamknął stronę zapisu: odpowiedzi są jeszcze wysyłane
+        bool closing = false;
+    };
+
+    struct Request {
+        Connection* connection;
+        Header header;
+        const u8* data;
+    };
+
+    const int cpu;
+    std::map<u16, Context> keys;
+    int epfd = -1;
+    int wakefd = -1;
+    std::unordered_map<Connection*, std::unique_ptr<Connection>> connections;
+    std::mutex inbox_mutex;
+    std::vector<int> inbox;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+
+public:
+    Shard(const int, const Keyring&);
+    ~Shard();
+
+    Shard(const Shard&) = delete;
+    Shard& operator=(const Shard&) = delete;
+
+    bool start();
+    void adopt(const int);
+    void shutdown() noexcept;
+
+private:
+    void run() noexcept;
+    void accept_inbox() noexcept;
+    bool receive(Connection&) noexcept;
+    void parse(Connection&, std::vector<Request>&) noexcept;
+    void process(std::vector<Request>&) noexcept;
+    void attach(const Request&) noexcept;
+    void encrypt(std::vector<Request>&) noexcept;
+    void decrypt(const Request&) noexcept;
+    void flush(Connection&) noexcept;
+    void watch(Connection&) noexcept;
+    void close(Connection&) noexcept;
+
+    static size_t reply(Connection&, const Request&, const Status, const u32) noexcept;
+    static bool locate(const Connection&, const u64, const u64) noexcept;
+};
+
+/**
+ * @brief Server
+ * Usługa szyfrowania na gnieździe domeny Unix: przyjmuje połączenia
+ * i rozdziela je po kolei między shardy (po jednym na procesor).
+ */
+class Server {
+    const std::string path;
+    int listener = -1;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+public:
+    Server(const std::string&, const Keyring&, const int = 0);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    bool listen();
+    void serve(const std::atomic<bool>&) noexcept;
+};
+
+}}} // namespaces
+#endif // BEESOFT_CRYPTO_SERVICE_SERVER_H
@@ -0,0 +1,78 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include "Server.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+using namespace std;
+using namespace beesoft::crypto::service;
+
+static atomic<bool> stop{false};
+
+static void on_signal(int) {
+    stop.store(true);
+}
+
+/**
+ * @brief main
+ * Usługa szyfrowania: cryptod <gniazdo> <plik kluczy> [liczba shardów].
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " <socket> <keyfile> [shards]" << endl;
+        return 2;
+    }
+
+    Keyring keyring;
+    if (!keyring.load(argv[2]) || keyring.size() == 0) {
+        cerr << "Error (cryptod): no keys loaded" << endl;
+        return 1;
+    }
+
+    struct sigaction action{};
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    Server server(argv[1], keyring, (argc > 3) ? atoi(argv[3]) : 0);
+    if (!server.listen()) {
+        return 1;
+    }
+    cout << "cryptod: " << keyring.size() << " key(s), listening on " << argv[1] << endl;
+    server.serve(stop);
+    cout << "cryptod: stopped" << endl;
+    return 0;
+}
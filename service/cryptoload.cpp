@@ -0,0 +1,285 @@
+/*
+ * BSD 2-Clause License
+ *
+ *	Copyright (c) 2020, Piotr Pszczółkowski
+ *	All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*------- include files:
+-------------------------------------------------------------------*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Client.h"
+
+/*------- namespaces:
+-------------------------------------------------------------------*/
+using namespace std;
+using namespace beesoft::crypto;
+using namespace beesoft::crypto::service;
+using Clock = chrono::steady_clock;
+
+struct Options {
+    string socket;
+    u16 key = 1;
+    int connections = 4;
+    int requests = 100000;      // na połączenie
+    int size = 256;             // rozmiar wiadomości w bajtach
+    int depth = 32;             // żądania w toku na połączenie
+    bool shared = false;
+    bool half_close = false;    // wszystkie żądania, potem shutdown(SHUT_WR)
+};
+
+struct Result {
+    u64 requests = 0;
+    u64 errors = 0;
+    bool verified = false;
+    vector<u32> latency;        // µs
+};
+
+/**
+ * @brief run
+ * Jedno połączenie: potokowe szyfrowanie wiadomości (depth w toku),
+ * na końcu sprawdzenie, że ostatni szyfrogram odszyfrowuje się poprawnie.
+ */
+static void run(const Options& options, Result& result) {
+    Client client;
+    if (!client.connect(options.socket)) {
+        cerr << "cryptoload: cannot connect to " << options.socket << endl;
+        result.errors = 1;
+        return;
+    }
+
+    vector<u8> plain(options.size);
+    mt19937 random(random_device{}());
+    generate(plain.begin(), plain.end(), [&] { return u8(random()); });
+
+    // w regionie: dla każdego miejsca wejście i bufor wynikowy
+    const size_t slot = 2 * (size_t(options.size) + 64);
+    u8* region = nullptr;
+    if (options.shared) {
+        region = client.attach(slot * options.depth);
+        if (region == nullptr) {
+            cerr << "cryptoload: cannot attach shared memory" << endl;
+            result.errors = 1;
+            return;
+        }
+        for (int s = 0; s < options.depth; s++) {
+            memcpy(region + s * slot, plain.data(), plain.size());
+        }
+    }
+
+    vector<Clock::time_point> started(options.requests);
+    vector<int> slot_of(options.requests);
+    vector<int> free_slots(options.depth);
+    for (int s = 0; s < options.depth; s++) {
+        free_slots[s] = options.depth - 1 - s;
+    }
+    result.latency.reserve(options.requests);
+
+    auto submit = [&](const int id) {
+        const int s = free_slots.back();
+        free_slots.pop_back();
+        slot_of[id] = s;
+        started[id] = Clock::now();
+        if (options.shared) {
+            const SharedRef ref{u64(s * slot), u64(s * slot + slot / 2), u32(options.size), u32(slot / 2)};
+            return client.send(Header{sizeof(ref), u32(id), u8(Op::Encrypt), Shared, options.key}, &ref);
+        }
+        return client.send(Header{u32(options.size), u32(id), u8(Op::Encrypt), 0, options.key}, plain.data());
+    };
+
+    int next = 0;
+    while (next < min(options.depth, options.requests)) {
+        if (!submit(next++)) {
+            result.errors++;
+            return;
+        }
+    }
+    Header header;
+    vector<u8> data, last;
+    for (int done = 0; done < options.requests; done++) {
+        if (!client.receive(header, data)) {
+            result.errors++;
+            return;
+        }
+        const int id = int(header.id);
+        result.latency.push_back(u32(chrono::duration_cast<chrono::microseconds>(Clock::now() - started[id]).count()));
+        if (Status(header.op) != Status::Ok) {
+            result.errors++;
+        } else if (options.shared) {
+            SharedResult r;
+            memcpy(&r, data.data(), sizeof(r));
+            const u8* const out = region + slot_of[id] * slot + slot / 2;
+            last.assign(out, out + r.nbytes);
+        } else {
+            last.swap(data);
+        }
+        result.requests++;
+        free_slots.push_back(slot_of[id]);
+        if (next < options.requests && !submit(next++)) {
+            result.errors++;
+            return;
+        }
+    }
+
+    vector<u8> decrypted;
+    result.verified = client.call(Op::Decrypt, options.key, last.data(), u32(last.size()), decrypted) == Status::Ok
+            && decrypted == plain;
+}
+
+/**
+ * @brief run_half_close
+ * Jedno połączenie: wysłanie wszystkich żądań (w osobnym wątku) i zamknięcie
+ * strony zapisu. Serwer musi dostarczyć wszystkie odpowiedzi, a dopiero
+ * potem zamknąć połączenie; ostatni szyfrogram jest sprawdzany
+ * przez osobne połączenie.
+ */
+static void run_half_close(const Options& options, Result& result) {
+    Client client;
+    if (!client.connect(options.socket)) {
+        cerr << "cryptoload: cannot connect to " << options.socket << endl;
+        result.errors = 1;
+        return;
+    }
+
+    vector<u8> plain(options.size);
+    mt19937 random(random_device{}());
+    generate(plain.begin(), plain.end(), [&] { return u8(random()); });
+
+    atomic<bool> sent{true};
+    thread sender([&] {
+        for (int id = 0; id < options.requests && sent; id++) {
+            sent = client.send(Header{u32(options.size), u32(id), u8(Op::Encrypt), 0, options.key}, plain.data());
+        }
+        client.finish();
+    });
+
+    Header header;
+    vector<u8> data, last;
+    for (int done = 0; done < options.requests; done++) {
+        if (!client.receive(header, data)) {
+            result.errors += u64(options.requests - done);
+            break;
+        }
+        if (Status(header.op) != Status::Ok) {
+            result.errors++;
+        } else {
+            last.swap(data);
+        }
+        result.requests++;
+    }
+    sender.join();
+    // po ostatniej odpowiedzi serwer zamyka połączenie
+    const bool closed = !client.receive(header, data);
+
+    Client check;
+    vector<u8> decrypted;
+    result.verified = sent && closed && check.connect(options.socket)
+            && check.call(Op::Decrypt, options.key, last.data(), u32(last.size()), decrypted) == Status::Ok
+            && decrypted == plain;
+}
+
+/**
+ * @brief main
+ * Test obciążeniowy usługi cryptod:
+ * cryptoload <gniazdo> [-k klucz] [-c połączenia] [-n żądania] [-s rozmiar] [-d głębokość] [-m] [-x]
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <socket> [-k key] [-c connections] [-n requests] [-s size] [-d depth] [-m (shared memory)] [-x (half-close)]" << endl;
+        return 2;
+    }
+    Options options;
+    options.socket = argv[1];
+    for (int i = 2; i < argc; i++) {
+        const string arg = argv[i];
+        const int value = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+        if (arg == "-m") {
+            options.shared = true;
+            continue;
+        }
+        if (arg == "-x") {
+            options.half_close = true;
+            continue;
+        }
+        if (value <= 0) {
+            cerr << "cryptoload: invalid option " << arg << endl;
+            return 2;
+        }
+        if (arg == "-k") options.key = u16(value);
+        else if (arg == "-c") options.connections = value;
+        else if (arg == "-n") options.requests = value;
+        else if (arg == "-s") options.size = value;
+        else if (arg == "-d") options.depth = value;
+        else {
+            cerr << "cryptoload: unknown option " << arg << endl;
+            return 2;
+        }
+        i++;
+    }
+
+    vector<Result> results(options.connections);
+    vector<thread> threads;
+    const auto start = Clock::now();
+    for (int i = 0; i < options.connections; i++) {
+        threads.emplace_back(options.half_close ? run_half_close : run, cref(options), ref(results[i]));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    const chrono::duration<double> elapsed = Clock::now() - start;
+
+    u64 requests = 0, errors = 0;
+    bool verified = true;
+    vector<u32> latency;
+    for (const auto& r : results) {
+        requests += r.requests;
+        errors += r.errors;
+        verified = verified && r.verified;
+        latency.insert(latency.end(), r.latency.begin(), r.latency.end());
+    }
+    sort(latency.begin(), latency.end());
+    const auto percentile = [&](const double p) {
+        return latency.empty() ? 0u : latency[min(latency.size() - 1, size_t(p * latency.size()))];
+    };
+
+    cout << fixed << setprecision(0)
+         << "requests: " << requests << " (" << errors << " errors), " << options.size << " B, "
+         << options.connections << " connection(s), depth " << options.depth << (options.shared ? ", shared memory" : "")
+         << (options.half_close ? ", half-close" : "") << endl
+         << "throughput: " << requests / elapsed.count() << " req/s, "
+         << setprecision(1) << requests * double(options.size) / elapsed.count() / (1024 * 1024) << " MiB/s" << endl
+         << "latency: p50 " << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, max " << percentile(1.0) << " us" << endl
+         << "roundtrip: " << (verified ? "OK" : "FAILED") << endl;
+    return (errors == 0 && verified) ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        Client.cpp \
+        cryptoload.cpp
+
+HEADERS += \
+   ../Crypto/Crypto.h \
+   Client.h \
+   Protocol.h